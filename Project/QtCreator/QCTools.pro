@@ -146,13 +146,16 @@ SUBDIRS = \
         qctools-qtav \
         qctools-lib \
         qctools-cli \
-        qctools-gui
+        qctools-gui \
+        qctools-bench
 
 qctools-qtav.file = qctools-qtav/QtAV.pro
 
 qctools-lib.subdir = qctools-lib
 qctools-cli.subdir = qctools-cli
 qctools-gui.subdir = qctools-gui
+qctools-bench.subdir = qctools-bench
 
 qctools-cli.depends = qctools-lib
 qctools-gui.depends = qctools-qtav qctools-lib
+qctools-bench.depends = qctools-lib
@@ -155,6 +155,7 @@ HEADERS += \
     $$SOURCES_PATH/GUI/PlotLegend.h \
     $$SOURCES_PATH/GUI/PlotScaleWidget.h \
     $$SOURCES_PATH/GUI/TinyDisplay.h \
+    $$SOURCES_PATH/GUI/ThumbnailLoader.h \
     $$SOURCES_PATH/GUI/SelectionArea.h \
     $$SOURCES_PATH/GUI/config.h \
     $$SOURCES_PATH/GUI/draggablechildrenbehaviour.h \
@@ -186,6 +187,7 @@ SOURCES += \
     $$SOURCES_PATH/GUI/PlotScaleWidget.cpp \
     $$SOURCES_PATH/GUI/preferences.cpp \
     $$SOURCES_PATH/GUI/TinyDisplay.cpp \
+    $$SOURCES_PATH/GUI/ThumbnailLoader.cpp \
     $$SOURCES_PATH/GUI/SelectionArea.cpp \
     $$SOURCES_PATH/GUI/config.cpp \
     $$SOURCES_PATH/GUI/draggablechildrenbehaviour.cpp \
@@ -325,7 +327,7 @@ INCLUDEPATH += $$SOURCES_PATH/ThirdParty/cqmarkdown
 include(../ffmpeg.pri)
 
 win32-g++* {
-    LIBS += -lbcrypt -lwsock32 -lws2_32
+    LIBS += -lbcrypt -lwsock32 -lws2_32 -lpsapi
 }
 
 macx:ICON = $$SOURCES_PATH/Resource/Logo.icns
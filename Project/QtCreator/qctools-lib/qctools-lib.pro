@@ -25,6 +25,7 @@ include(../zlib.pri)
 
 HEADERS = \
     $$SOURCES_PATH/ThirdParty/tinyxml2/tinyxml2.h \
+    $$SOURCES_PATH/Core/AnalysisScheduler.h \
     $$SOURCES_PATH/Core/AudioCore.h \
     $$SOURCES_PATH/Core/AudioStats.h \
     $$SOURCES_PATH/Core/CommonStats.h \
@@ -38,15 +39,23 @@ HEADERS = \
     $$SOURCES_PATH/Core/VideoStreamStats.h \
     $$SOURCES_PATH/Core/StreamsStats.h \
     $$SOURCES_PATH/Core/Timecode.h \
+    $$SOURCES_PATH/Core/ExportWriter.h \
+    $$SOURCES_PATH/Core/Profiler.h \
+    $$SOURCES_PATH/Core/ThumbnailStore.h \
     $$SOURCES_PATH/Core/FileInformation.h \
     $$SOURCES_PATH/Core/SignalServerConnectionChecker.h \
     $$SOURCES_PATH/Core/SignalServer.h \
     $$SOURCES_PATH/Core/Preferences.h \
+    $$SOURCES_PATH/Core/StatsBinary.h \
+    $$SOURCES_PATH/Core/StatsXmlBuffer.h \
+    $$SOURCES_PATH/Core/StatsColumn.h \
+    $$SOURCES_PATH/Core/XmlPullParser.h \
     $$SOURCES_PATH/Core/FFmpegVideoEncoder.h
 
 
 SOURCES = \
     $$SOURCES_PATH/ThirdParty/tinyxml2/tinyxml2.cpp \
+    $$SOURCES_PATH/Core/AnalysisScheduler.cpp \
     $$SOURCES_PATH/Core/AudioCore.cpp \
     $$SOURCES_PATH/Core/AudioStats.cpp \
     $$SOURCES_PATH/Core/CommonStats.cpp \
@@ -60,10 +69,16 @@ SOURCES = \
     $$SOURCES_PATH/Core/VideoStreamStats.cpp \
     $$SOURCES_PATH/Core/StreamsStats.cpp \
     $$SOURCES_PATH/Core/Timecode.cpp \
+    $$SOURCES_PATH/Core/ExportWriter.cpp \
+    $$SOURCES_PATH/Core/Profiler.cpp \
+    $$SOURCES_PATH/Core/ThumbnailStore.cpp \
     $$SOURCES_PATH/Core/FileInformation.cpp \
     $$SOURCES_PATH/Core/SignalServerConnectionChecker.cpp \
     $$SOURCES_PATH/Core/SignalServer.cpp \
     $$SOURCES_PATH/Core/Preferences.cpp \
+    $$SOURCES_PATH/Core/StatsBinary.cpp \
+    $$SOURCES_PATH/Core/StatsXmlBuffer.cpp \
+    $$SOURCES_PATH/Core/XmlPullParser.cpp \
     $$SOURCES_PATH/Core/FFmpegVideoEncoder.cpp
 
 include($$SOURCES_PATH/ThirdParty/qblowfish/qblowfish.pri)
@@ -0,0 +1,277 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Bench/BenchMedia.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+extern "C"
+{
+#ifndef INT64_C
+#define INT64_C(c) (c ## LL)
+#define UINT64_C(c) (c ## ULL)
+#endif
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <cstring>
+#include <sstream>
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// List
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Usual archive and production formats, from SD to HD
+const benchmedia BenchMedia_List[]=
+{
+    { "ffv1_720x486_yuv422p10",         "ffv1",         720,  486, "yuv422p10le", "pcm_s24le" },
+    { "dv_720x480_yuv411p",             "dvvideo",      720,  480, "yuv411p",     "pcm_s16le" },
+    { "mpeg2_720x480_yuv420p",          "mpeg2video",   720,  480, "yuv420p",     "pcm_s16le" },
+    { "prores_1920x1080_yuv422p10",     "prores_ks",   1920, 1080, "yuv422p10le", "pcm_s24le" },
+    { "h264_1920x1080_yuv420p",         "libx264",     1920, 1080, "yuv420p",     "pcm_s16le" },
+};
+const size_t BenchMedia_Count=sizeof(BenchMedia_List)/sizeof(BenchMedia_List[0]);
+
+//***************************************************************************
+// Helpers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static const AVRational BenchMedia_FrameRate={30000, 1001};
+static const int        BenchMedia_SampleRate=48000;
+
+//---------------------------------------------------------------------------
+// Source filter graph, without input, ending with a sink
+static AVFilterGraph* Graph_Create(const std::string& Description, bool IsAudio, AVFilterContext*& Sink)
+{
+    AVFilterGraph* Graph=avfilter_graph_alloc();
+    if (!Graph)
+        return NULL;
+
+    if (avfilter_graph_create_filter(&Sink, avfilter_get_by_name(IsAudio?"abuffersink":"buffersink"), "out", NULL, NULL, Graph)<0)
+    {
+        avfilter_graph_free(&Graph);
+        return NULL;
+    }
+
+    AVFilterInOut* Inputs=avfilter_inout_alloc();
+    AVFilterInOut* Outputs=NULL;
+    Inputs->name=av_strdup("out");
+    Inputs->filter_ctx=Sink;
+    Inputs->pad_idx=0;
+    Inputs->next=NULL;
+    int Result=avfilter_graph_parse_ptr(Graph, Description.c_str(), &Inputs, &Outputs, NULL);
+    avfilter_inout_free(&Inputs);
+    avfilter_inout_free(&Outputs);
+    if (Result<0 || avfilter_graph_config(Graph, NULL)<0)
+    {
+        avfilter_graph_free(&Graph);
+        return NULL;
+    }
+
+    return Graph;
+}
+
+//---------------------------------------------------------------------------
+// Encoded packets of a frame (NULL for flushing) are written, false on error
+static bool Encode(AVFormatContext* Format, AVStream* Stream, AVCodecContext* Context, AVFrame* Frame, bool& Got)
+{
+    AVPacket Packet;
+    av_init_packet(&Packet);
+    Packet.data=NULL;
+    Packet.size=0;
+
+    int Got_Packet=0;
+    int Result;
+    if (Context->codec_type==AVMEDIA_TYPE_VIDEO)
+        Result=avcodec_encode_video2(Context, &Packet, Frame, &Got_Packet);
+    else
+        Result=avcodec_encode_audio2(Context, &Packet, Frame, &Got_Packet);
+    Got=Got_Packet!=0;
+    if (Result<0)
+        return false;
+    if (!Got)
+        return true;
+
+    av_packet_rescale_ts(&Packet, Context->time_base, Stream->time_base);
+    Packet.stream_index=Stream->index;
+    return av_interleaved_write_frame(Format, &Packet)>=0;
+}
+
+//***************************************************************************
+// Creation
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+struct benchmedia_stream
+{
+    benchmedia_stream() : Graph(NULL), Sink(NULL), Context(NULL), Stream(NULL), Frame(av_frame_alloc()) {}
+    ~benchmedia_stream()
+    {
+        avfilter_graph_free(&Graph);
+        avcodec_free_context(&Context);
+        av_frame_free(&Frame);
+    }
+
+    AVFilterGraph*              Graph;
+    AVFilterContext*            Sink;
+    AVCodecContext*             Context;
+    AVStream*                   Stream;
+    AVFrame*                    Frame;
+};
+
+//---------------------------------------------------------------------------
+static bool Stream_Open(benchmedia_stream& Output, AVFormatContext* Format, const char* Encoder_Name, const benchmedia& Media, bool IsAudio, std::string& Error)
+{
+    AVCodec* Encoder=avcodec_find_encoder_by_name(Encoder_Name);
+    if (!Encoder)
+    {
+        Error=std::string("encoder ")+Encoder_Name+" is not available";
+        return false;
+    }
+
+    Output.Context=avcodec_alloc_context3(Encoder);
+    Output.Stream=avformat_new_stream(Format, NULL);
+    if (!Output.Context || !Output.Stream)
+    {
+        Error="out of memory";
+        return false;
+    }
+
+    std::stringstream Description;
+    if (IsAudio)
+    {
+        AVSampleFormat SampleFmt=(Encoder->sample_fmts)?Encoder->sample_fmts[0]:AV_SAMPLE_FMT_S16;
+        Output.Context->sample_rate=BenchMedia_SampleRate;
+        Output.Context->sample_fmt=SampleFmt;
+        Output.Context->channel_layout=AV_CH_LAYOUT_STEREO;
+        Output.Context->channels=2;
+        Output.Context->time_base=av_make_q(1, BenchMedia_SampleRate);
+        if (SampleFmt==AV_SAMPLE_FMT_S32 && !strcmp(Encoder_Name, "pcm_s24le"))
+            Output.Context->bits_per_raw_sample=24;
+        Description<<"sine=frequency=1000:sample_rate="<<BenchMedia_SampleRate<<",aformat=sample_fmts="<<av_get_sample_fmt_name(SampleFmt)<<":channel_layouts=stereo";
+    }
+    else
+    {
+        Output.Context->width=Media.Width;
+        Output.Context->height=Media.Height;
+        Output.Context->pix_fmt=av_get_pix_fmt(Media.PixFmt);
+        Output.Context->time_base=av_inv_q(BenchMedia_FrameRate);
+        Output.Context->gop_size=12;
+        Output.Context->bit_rate=(int64_t)Media.Width*Media.Height*30*2; // About 2 bits per pixel when not constant quality
+        Description<<"testsrc=size="<<Media.Width<<"x"<<Media.Height<<":rate="<<BenchMedia_FrameRate.num<<"/"<<BenchMedia_FrameRate.den<<",format=pix_fmts="<<Media.PixFmt;
+    }
+    if (Format->oformat->flags&AVFMT_GLOBALHEADER)
+        Output.Context->flags|=AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    if (avcodec_open2(Output.Context, Encoder, NULL)<0)
+    {
+        Error=std::string("encoder ")+Encoder_Name+" can not be opened";
+        return false;
+    }
+    Output.Stream->time_base=Output.Context->time_base;
+    avcodec_parameters_from_context(Output.Stream->codecpar, Output.Context);
+
+    Output.Graph=Graph_Create(Description.str(), IsAudio, Output.Sink);
+    if (!Output.Graph)
+    {
+        Error="lavfi source can not be created";
+        return false;
+    }
+    if (IsAudio && Output.Context->frame_size)
+        av_buffersink_set_frame_size(Output.Sink, Output.Context->frame_size);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool BenchMedia_Create(const benchmedia& Media, const std::string& FileName, int Frames, std::string& Error)
+{
+    av_register_all();
+    avfilter_register_all();
+
+    AVFormatContext* Format=NULL;
+    if (avformat_alloc_output_context2(&Format, NULL, "matroska", FileName.c_str())<0 || !Format)
+    {
+        Error="matroska muxer is not available";
+        return false;
+    }
+
+    benchmedia_stream Video;
+    benchmedia_stream Audio;
+    bool IsOk=Stream_Open(Video, Format, Media.Video_Encoder, Media, false, Error)
+           && Stream_Open(Audio, Format, Media.Audio_Encoder, Media, true, Error);
+    if (IsOk && avio_open(&Format->pb, FileName.c_str(), AVIO_FLAG_WRITE)<0)
+    {
+        Error="file can not be created";
+        IsOk=false;
+    }
+    if (IsOk && avformat_write_header(Format, NULL)<0)
+    {
+        Error="header can not be written";
+        IsOk=false;
+    }
+
+    // Audio is sent up to the time stamp of the next video frame, so the muxer does not buffer much
+    int64_t Audio_Pts=0;
+    bool Got;
+    for (int Frame_Pos=0; IsOk && Frame_Pos<Frames; Frame_Pos++)
+    {
+        if (av_buffersink_get_frame(Video.Sink, Video.Frame)<0)
+        {
+            Error="lavfi video source failed";
+            IsOk=false;
+            break;
+        }
+        Video.Frame->pts=Frame_Pos;
+        Video.Frame->pict_type=AV_PICTURE_TYPE_NONE;
+        IsOk=Encode(Format, Video.Stream, Video.Context, Video.Frame, Got);
+        av_frame_unref(Video.Frame);
+
+        int64_t Audio_End=av_rescale_q(Frame_Pos+1, Video.Context->time_base, Audio.Context->time_base);
+        while (IsOk && Audio_Pts<Audio_End)
+        {
+            if (av_buffersink_get_frame(Audio.Sink, Audio.Frame)<0)
+            {
+                Error="lavfi audio source failed";
+                IsOk=false;
+                break;
+            }
+            Audio.Frame->pts=Audio_Pts;
+            Audio_Pts+=Audio.Frame->nb_samples;
+            IsOk=Encode(Format, Audio.Stream, Audio.Context, Audio.Frame, Got);
+            av_frame_unref(Audio.Frame);
+        }
+    }
+    // Delayed packets
+    if (IsOk)
+    {
+        Got=(Video.Context->codec->capabilities&AV_CODEC_CAP_DELAY)!=0;
+        while (IsOk && Got)
+            IsOk=Encode(Format, Video.Stream, Video.Context, NULL, Got);
+        Got=(Audio.Context->codec->capabilities&AV_CODEC_CAP_DELAY)!=0;
+        while (IsOk && Got)
+            IsOk=Encode(Format, Audio.Stream, Audio.Context, NULL, Got);
+        if (IsOk)
+            IsOk=av_write_trailer(Format)>=0;
+    }
+    if (!IsOk && Error.empty())
+        Error="encoding failed";
+
+    if (Format->pb)
+        avio_closep(&Format->pb);
+    avformat_free_context(Format);
+    return IsOk;
+}
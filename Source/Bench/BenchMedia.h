@@ -0,0 +1,35 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef BenchMedia_H
+#define BenchMedia_H
+
+#include <string>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+// Synthetic media (lavfi testsrc for video, sine for audio) encoded with
+// FFmpeg, so the analysis is measured on the same content on each machine
+// and with each build.
+struct benchmedia
+{
+    const char*                 Name;                       // Unique, also used in the file name
+    const char*                 Video_Encoder;              // FFmpeg encoder name
+    int                         Width;
+    int                         Height;
+    const char*                 PixFmt;
+    const char*                 Audio_Encoder;              // FFmpeg encoder name, 48 kHz stereo
+};
+
+extern const benchmedia         BenchMedia_List[];
+extern const size_t             BenchMedia_Count;
+
+// Matroska file with Frames video frames at 30000/1001 fps and the audio of
+// the same duration, false if an encoder is not available in this build
+bool                            BenchMedia_Create(const benchmedia& Media, const std::string& FileName, int Frames, std::string& Error);
+
+#endif // BenchMedia_H
@@ -0,0 +1,472 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+// qctools-bench: throughput of QCTools on synthetic data, with one JSON
+// object per line on the standard output so results of 2 builds can be
+// compared with diff. Suites:
+// - pipeline: analysis and export of synthetic media (lavfi testsrc and
+//   sine, several codecs and resolutions) for each filter
+// - export: hot paths rewritten for speed, with the reference
+//   implementation
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Bench/BenchMedia.h"
+#include "Core/FileInformation.h"
+#include "Core/FFmpeg_Glue.h"
+#include "Core/CommonStats.h"
+#include "Core/Profiler.h"
+#include "Core/SignalServer.h"
+#include "Core/VideoStats.h"
+#include "Core/VideoCore.h"
+#include "Core/StatsXmlBuffer.h"
+#include "Core/XmlPullParser.h"
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+extern "C"
+{
+#ifndef INT64_C
+#define INT64_C(c) (c ## LL)
+#define UINT64_C(c) (c ## ULL)
+#endif
+
+#include <libavutil/pixdesc.h>
+}
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const int    Bench_Width=720;
+static const int    Bench_Height=486;
+static const size_t Bench_FramesPerBlock=256; // As in FileInformation::Export_XmlGz
+
+//***************************************************************************
+// Helpers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static double Seconds_Since(const std::chrono::steady_clock::time_point& Begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Begin).count();
+}
+
+//---------------------------------------------------------------------------
+static void Result_Show(const char* Name, size_t Frames, size_t Bytes, double Seconds)
+{
+    std::cout << "{\"suite\":\"export\",\"name\":\"" << Name << "\""
+              << ",\"frames\":" << Frames
+              << std::fixed << std::setprecision(3) << ",\"seconds\":" << Seconds
+              << std::setprecision(1) << ",\"frames_per_second\":" << Frames/Seconds
+              << ",\"bytes_per_second\":" << Bytes/Seconds << "}" << std::endl;
+}
+
+//---------------------------------------------------------------------------
+// Silent Qt debug output, the standard output is for results
+static void Message_Ignore(QtMsgType, const QMessageLogContext&, const QString&)
+{
+}
+
+//***************************************************************************
+// Synthetic stats
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Frames are created through the same path as a report being read, with all
+// the video items and values looking like signalstats ones
+static VideoStats* Stats_Create(size_t Frames)
+{
+    VideoStats* Stats=new VideoStats(Frames, Frames/25.0);
+    XmlPullParser Parser;
+    srand(0);
+
+    for (size_t Frame=0; Frame<Frames; Frame++)
+    {
+        std::stringstream Data;
+        Data << "<frame media_type=\"video\" stream_index=\"0\" key_frame=\"" << (Frame%12?0:1) << "\""
+             << " pkt_pts=\"" << Frame*1001 << "\" pkt_pts_time=\"" << std::fixed << std::setprecision(6) << Frame*1.001/30 << "\""
+             << " pkt_duration_time=\"0.033367\" pkt_pos=\"" << Frame*120000 << "\" pkt_size=\"" << 100000+rand()%40000 << "\""
+             << " width=\"" << Bench_Width << "\" height=\"" << Bench_Height << "\" pix_fmt=\"yuv422p10le\" pict_type=\"" << (Frame%12?'P':'I') << "\">";
+        for (size_t Item=0; Item<Item_VideoMax; Item++)
+            if (VideoPerItem[Item].Filter!=activefilter(-1))
+                Data << "<tag key=\"" << VideoPerItem[Item].FFmpeg_Name << "\" value=\"" << std::setprecision(Item%2?0:4) << (rand()%100000)/100.0 << "\"/>";
+        Data << "</frame>";
+
+        std::string Frame_Data=Data.str();
+        Parser.Data_Add(Frame_Data.c_str(), Frame_Data.size());
+        for (;;)
+        {
+            XmlPullParser::token Token=Parser.Next();
+            if (Token==XmlPullParser::Token_None)
+                break;
+            if (Token==XmlPullParser::Token_StartElement && Parser.Name_Is("frame"))
+                Stats->StatsFromExternalData_Frame(Parser);
+            else if (Token==XmlPullParser::Token_StartElement && Parser.Name_Is("tag"))
+                Stats->StatsFromExternalData_Tag(Parser.Attribute("key"), Parser.Attribute("value"));
+            else if (Token==XmlPullParser::Token_EndElement && Parser.Name_Is("frame"))
+                Stats->StatsFromExternalData_FrameEnd();
+        }
+    }
+    Stats->StatsFromExternalData_Finish();
+
+    return Stats;
+}
+
+//***************************************************************************
+// Export
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Reference: serialization with streams and temporary strings, as before
+// StatsXmlBuffer (additional stats and comments are not in synthetic stats)
+static std::string Export_Reference(VideoStats& Stats, const activefilters& filters, size_t x_Begin, size_t x_End)
+{
+    stringstream Data;
+
+    int width=Stats.getWidth();
+    int height=Stats.getHeight();
+    stringstream widthStream; widthStream<<width;
+    stringstream heightStream; heightStream<<height;
+    for (size_t x_Pos=x_Begin; x_Pos<x_End; ++x_Pos)
+    {
+        stringstream pkt_pts_time; pkt_pts_time<<fixed<<setprecision(7)<<(Stats.x[1][x_Pos]+Stats.FirstTimeStamp);
+        stringstream pkt_duration_time; pkt_duration_time<<fixed<<setprecision(7)<<Stats.durations[x_Pos];
+        stringstream key_frame; key_frame<<(Stats.key_frames[x_Pos]?'1':'0');
+        Data<<"        <frame media_type=\"video\"";
+        Data << " stream_index=\"" << 0 << "\"";
+
+        Data<<" key_frame=\"" << key_frame.str() << "\"";
+        Data << " pkt_pts=\"" << Stats.pkt_pts[x_Pos] << "\"";
+        Data<<" pkt_pts_time=\"" << pkt_pts_time.str() << "\"";
+        Data<<" pkt_duration_time=\"" << pkt_duration_time.str() << "\"";
+        Data << " pkt_pos=\"" << Stats.pkt_pos[x_Pos] << "\"";
+        Data << " pkt_size=\"" << Stats.pkt_size[x_Pos] << "\"";
+        Data<<" width=\"" << widthStream.str() << "\" height=\"" << heightStream.str() <<"\"";
+        Data << " pix_fmt=\"" << av_get_pix_fmt_name((AVPixelFormat) Stats.pix_fmt[x_Pos]) << "\"";
+        Data << " pict_type=\"" << Stats.pict_type_char[x_Pos] << "\"";
+
+        Data << ">\n";
+
+        for (size_t Plot_Pos=0; Plot_Pos<Item_VideoMax; Plot_Pos++)
+        {
+            const activefilter filter = VideoPerItem[Plot_Pos].Filter;
+            if(filter == activefilter(-1))
+                continue;
+
+            if(!filters.test(filter))
+                continue;
+
+            const std::string& key = VideoPerItem[Plot_Pos].FFmpeg_Name;
+            std::string value;
+
+            switch (Plot_Pos)
+            {
+            case Item_Crop_x2 :
+            case Item_Crop_w :
+                value = std::to_string(width-Stats.y[Plot_Pos][x_Pos]);
+                break;
+            case Item_Crop_y2 :
+            case Item_Crop_h :
+                value = std::to_string(height-Stats.y[Plot_Pos][x_Pos]);
+                break;
+            default:
+                value = std::to_string(Stats.y[Plot_Pos][x_Pos]);
+            }
+
+            Data<<"            <tag key=\""+key+"\" value=\""+value+"\"/>\n";
+        }
+
+        Data<<"        </frame>\n";
+    }
+
+    return Data.str();
+}
+
+//---------------------------------------------------------------------------
+static bool Bench_Export(VideoStats& Stats)
+{
+    activefilters filters;
+    filters.set();
+    size_t Frames=Stats.x_Current;
+
+    // Reference
+    std::string Reference;
+    auto Begin=std::chrono::steady_clock::now();
+    size_t Reference_Size=0;
+    for (size_t x_Begin=0; x_Begin<Frames; x_Begin+=Bench_FramesPerBlock)
+    {
+        Reference=Export_Reference(Stats, filters, x_Begin, std::min(x_Begin+Bench_FramesPerBlock, Frames));
+        Reference_Size+=Reference.size();
+    }
+    Result_Show("export/stringstream", Frames, Reference_Size, Seconds_Since(Begin));
+
+    // Current
+    StatsXmlBuffer Data;
+    Begin=std::chrono::steady_clock::now();
+    size_t Data_Size=0;
+    for (size_t x_Begin=0; x_Begin<Frames; x_Begin+=Bench_FramesPerBlock)
+    {
+        Data.Clear();
+        Stats.StatsToXML(Data, filters, x_Begin, x_Begin+Bench_FramesPerBlock);
+        Data_Size+=Data.Data.size();
+    }
+    Result_Show("export/StatsXmlBuffer", Frames, Data_Size, Seconds_Since(Begin));
+
+    // Content must be the same
+    Data.Clear();
+    Stats.StatsToXML(Data, filters);
+    if (Data_Size!=Reference_Size || Data.Data!=Export_Reference(Stats, filters, 0, Frames))
+    {
+        std::cerr << "export: output differs from the reference" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//***************************************************************************
+// Pipeline
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Names as in qcli -f
+static const char* const Bench_FilterNames[ActiveFilter_Max]=
+{
+    "signalstats",
+    "cropdetect",
+    "psnr",
+    "ebur128",
+    "aphasemeter",
+    "astats",
+    "ssim",
+    "idet",
+    "deflicker",
+    "entropy",
+    "entropy-diff",
+};
+
+//---------------------------------------------------------------------------
+struct benchfilters
+{
+    std::string                 Name;
+    activefilters               Filters;
+};
+
+//---------------------------------------------------------------------------
+// No filter, each filter alone, then all filters
+static std::vector<benchfilters> Bench_Filters_Get()
+{
+    std::vector<benchfilters> List;
+    benchfilters Item;
+
+    Item.Name="none";
+    List.push_back(Item);
+    for (size_t Filter=0; Filter<ActiveFilter_Max; Filter++)
+    {
+        Item.Name=Bench_FilterNames[Filter];
+        Item.Filters.reset();
+        Item.Filters.set(Filter);
+        List.push_back(Item);
+    }
+    Item.Name="all";
+    Item.Filters.set();
+    List.push_back(Item);
+
+    return List;
+}
+
+//---------------------------------------------------------------------------
+static void Pipeline_Skip(const benchmedia& Media, const std::string& Reason)
+{
+    std::cout << "{\"suite\":\"pipeline\",\"media\":\"" << Media.Name << "\",\"skipped\":\"" << Reason << "\"}" << std::endl;
+}
+
+//---------------------------------------------------------------------------
+// Analysis then export of a file, as done by qcli
+static bool Pipeline_Run(SignalServer& Server, const benchmedia& Media, const QString& FileName, const benchfilters& Filters)
+{
+    std::cerr << Media.Name << " " << Filters.Name << "..." << std::endl;
+
+    QString ReportName=FileName+".bench.qctools.xml.gz"; // Not a name looked for when the media is opened
+    QElapsedTimer Timer;
+    Timer.start();
+    FileInformation Info(&Server, FileName, Filters.Filters, activealltracks()); // Analysis is started by the constructor
+    Info.setAutoCheckFileUploaded(false);
+    Info.setAutoUpload(false);
+    if (!Info.isValid())
+    {
+        Pipeline_Skip(Media, "media can not be opened");
+        return false;
+    }
+
+    // Analysis, a single file is started at once by the scheduler
+    Info.wait();
+    double Analysis_Seconds=Timer.nsecsElapsed()/1000000000.0;
+    if (!Info.parsed())
+    {
+        Pipeline_Skip(Media, "analysis failed");
+        return false;
+    }
+
+    // Export
+    QEventLoop Loop;
+    QObject::connect(&Info, &FileInformation::statsFileGenerated, &Loop, &QEventLoop::quit);
+    QObject::connect(&Info, &FileInformation::statsFileGenerationFailed, &Loop, &QEventLoop::quit);
+    Info.setExportFilters(Filters.Filters);
+    Timer.restart();
+    Info.startExport(ReportName);
+    Loop.exec();
+    Info.wait();
+    double Export_Seconds=Timer.nsecsElapsed()/1000000000.0;
+    quint64 Report_Size=QFileInfo(ReportName).size();
+    QFile::remove(ReportName);
+
+    size_t Frames=Info.ReferenceStat()?Info.ReferenceStat()->x_Current:0;
+    const Profiler& Profile=Info.Profiler_Get();
+    std::cout << "{\"suite\":\"pipeline\",\"media\":\"" << Media.Name << "\",\"filters\":\"" << Filters.Name << "\""
+              << ",\"frames\":" << Frames
+              << std::fixed << std::setprecision(3)
+              << ",\"analysis_seconds\":" << Analysis_Seconds
+              << ",\"export_seconds\":" << Export_Seconds
+              << std::setprecision(1)
+              << ",\"frames_per_second\":" << (Analysis_Seconds?Frames/Analysis_Seconds:0)
+              << ",\"report_size\":" << Report_Size
+              << std::setprecision(3)
+              << ",\"stages\":{";
+    for (size_t Stage=0; Stage<ProfilerStage_Max; Stage++)
+        std::cout << (Stage?",":"") << "\"" << Profiler::Stage_Name((profilerstage)Stage) << "\":" << Profile.Time_Get((profilerstage)Stage)/1000000000.0;
+    std::cout << "},\"peak_rss\":" << Profiler::PeakMemory_Get() << "}" << std::endl;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+static bool Bench_Pipeline(const QString& Directory, int Frames, const std::string& Media_Filter, const std::string& Filters_Filter)
+{
+    Profiler::Enabled_Set(true);
+    SignalServer Server;
+    QDir().mkpath(Directory);
+    std::vector<benchfilters> Filters=Bench_Filters_Get();
+
+    bool IsOk=true;
+    for (size_t Media_Pos=0; Media_Pos<BenchMedia_Count; Media_Pos++)
+    {
+        const benchmedia& Media=BenchMedia_List[Media_Pos];
+        if (!Media_Filter.empty() && Media_Filter!=Media.Name)
+            continue;
+
+        // Media is kept between runs, content only depends on its name and the count of frames
+        std::stringstream Name;
+        Name << Media.Name << "_" << Frames << ".mkv";
+        QString FileName=QDir(Directory).filePath(QString::fromStdString(Name.str()));
+        if (!QFile::exists(FileName))
+        {
+            std::cerr << "Creating " << FileName.toStdString() << "..." << std::endl;
+            std::string Error;
+            if (!BenchMedia_Create(Media, FileName.toStdString(), Frames, Error))
+            {
+                QFile::remove(FileName);
+                Pipeline_Skip(Media, Error);
+                continue;
+            }
+        }
+
+        for (size_t Filters_Pos=0; Filters_Pos<Filters.size(); Filters_Pos++)
+            if (Filters_Filter.empty() || Filters_Filter==Filters[Filters_Pos].Name)
+                if (!Pipeline_Run(Server, Media, FileName, Filters[Filters_Pos]))
+                    IsOk=false;
+    }
+
+    return IsOk;
+}
+
+//***************************************************************************
+// Main
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    qInstallMessageHandler(Message_Ignore);
+    QCoreApplication Application(argc, argv);
+
+    std::string Suite="all";
+    size_t Frames=100000;
+    int Media_Frames=300;
+    std::string Media_Filter;
+    std::string Filters_Filter;
+    QString Directory=QDir::temp().filePath("qctools-bench");
+    for (int i=1; i<argc; i++)
+    {
+        if (!strcmp(argv[i], "-suite") && i+1<argc)
+            Suite=argv[++i];
+        else if (!strcmp(argv[i], "-frames") && i+1<argc)
+            Frames=strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-media_frames") && i+1<argc)
+            Media_Frames=atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-media") && i+1<argc)
+            Media_Filter=argv[++i];
+        else if (!strcmp(argv[i], "-f") && i+1<argc)
+            Filters_Filter=argv[++i];
+        else if (!strcmp(argv[i], "-dir") && i+1<argc)
+            Directory=QString::fromLocal8Bit(argv[++i]);
+        else if (!strcmp(argv[i], "-h"))
+        {
+            std::cout << "Usage: qctools-bench [-suite <name>] [options]" << std::endl
+                      << "Results are written on the standard output, one JSON object per line." << std::endl
+                      << "-suite <name>" << std::endl
+                      << "    pipeline, export or all (default)." << std::endl
+                      << "-media_frames <count>" << std::endl
+                      << "    pipeline: count of frames of each synthetic media, default is 300." << std::endl
+                      << "-media <name>" << std::endl
+                      << "    pipeline: only this synthetic media. Available media:" << std::endl;
+            for (size_t Media_Pos=0; Media_Pos<BenchMedia_Count; Media_Pos++)
+                std::cout << "        " << BenchMedia_List[Media_Pos].Name << std::endl;
+            std::cout << "-f <filter>" << std::endl
+                      << "    pipeline: only this filter (as in qcli -f), none or all. Default is each" << std::endl
+                      << "    of them." << std::endl
+                      << "-dir <directory>" << std::endl
+                      << "    pipeline: directory of the synthetic media, kept between runs. Default is" << std::endl
+                      << "    qctools-bench in the temporary directory." << std::endl
+                      << "-frames <count>" << std::endl
+                      << "    export: count of synthetic frames, default is 100000." << std::endl
+                      << "peak_rss is the peak memory of the process since its start." << std::endl;
+            return 0;
+        }
+    }
+
+    std::cout << "{\"suite\":\"info\",\"ffmpeg\":\"" << FFmpeg_Glue::FFmpeg_Version() << "\",\"cores\":" << QThread::idealThreadCount() << "}" << std::endl;
+
+    bool IsOk=true;
+    if (Suite=="pipeline" || Suite=="all")
+        IsOk&=Bench_Pipeline(Directory, Media_Frames, Media_Filter, Filters_Filter);
+
+    if (Suite=="export" || Suite=="all")
+    {
+        std::cerr << "Creating " << Frames << " synthetic video frames..." << std::endl;
+        VideoStats* Stats=Stats_Create(Frames);
+        IsOk&=Bench_Export(*Stats);
+        delete Stats;
+    }
+
+    return IsOk?0:1;
+}
@@ -2,10 +2,99 @@
 #include "version.h"
 #include "Core/FFmpegVideoEncoder.h"
 #include "Core/FFmpeg_Glue.h"
+#include "Core/CommonStats.h"
+#include "Core/ExportWriter.h"
+#include "Core/AnalysisScheduler.h"
+#include "Core/Profiler.h"
+
+#include <QDir>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+
+Cli::Cli() : indexOfStreamWithKnownFrameCount(0), statsFileBytesWritten(0), statsFileBytesTotal(0), statsFileBytesUploaded(0), statsFileBytesToUpload(0),
+    jsonAnalysisElapsed(0), jsonExportLast(0), profileSummary(false)
+{
+
+}
 
-Cli::Cli() : indexOfStreamWithKnownFrameCount(0), statsFileBytesWritten(0), statsFileBytesTotal(0), statsFileBytesUploaded(0), statsFileBytesToUpload(0)
+static std::string jsonString(const QString& value)
 {
+    std::string result("\"");
+    foreach(char c, value.toUtf8())
+    {
+        if(c == '"' || c == '\\')
+        {
+            result += '\\';
+            result += c;
+        }
+        else if((unsigned char)c < 0x20)
+        {
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            result += escaped;
+        }
+        else
+            result += c;
+    }
+    result += '"';
+    return result;
+}
 
+void Cli::writeJson(const char* type, const QString& input, FileInformation* info, const char* phase, qint64 elapsed, qint64 analysisElapsed,
+                    quint64 written, quint64 total, int code)
+{
+    // Frames of the stream with the most frames, speeds are computed on the analysis phase only
+    quint64 frames = 0;
+    quint64 framesTotal = 0;
+    std::vector<size_t> queues;
+    if(info && info->Glue)
+    {
+        for(int i = 0; i < info->Glue->StreamCount_Get(); ++i)
+        {
+            if(info->Glue->FramesCountPerStream(i) > framesTotal)
+            {
+                framesTotal = info->Glue->FramesCountPerStream(i);
+                frames = info->Glue->FramesProcessedPerStream(i);
+            }
+        }
+        queues = info->Glue->Pipeline_QueuesSize_Get();
+    }
+    quint64 bytesRead = info ? info->Profiler_Get().Bytes_Get() : 0;
+    double analysisSeconds = analysisElapsed / 1000.0;
+
+    std::ostream& out = *jsonOutput;
+    out << "{\"type\":\"" << type << "\",\"input\":" << jsonString(input);
+    if(phase)
+        out << ",\"phase\":\"" << phase << "\"";
+    if(!strcmp(type, "result"))
+        out << ",\"code\":" << code;
+    out << ",\"elapsed\":" << elapsed / 1000.0
+        << ",\"frames\":" << frames
+        << ",\"frames_total\":" << framesTotal
+        << ",\"frames_per_second\":" << (analysisSeconds > 0 ? frames / analysisSeconds : 0)
+        << ",\"bytes_read\":" << bytesRead
+        << ",\"bytes_per_second\":" << (analysisSeconds > 0 ? bytesRead / analysisSeconds : 0)
+        << ",\"bytes_written\":" << written
+        << ",\"bytes_total\":" << total;
+    out << ",\"stages\":{";
+    for(int stage = 0; stage < ProfilerStage_Max; ++stage)
+    {
+        quint64 time = info ? info->Profiler_Get().Time_Get((profilerstage)stage) : 0;
+        out << (stage ? "," : "") << "\"" << Profiler::Stage_Name((profilerstage)stage) << "\":" << time / 1000000000.0;
+    }
+    out << "},\"items\":{";
+    size_t items = info ? info->Profiler_Get().Items_Count() : 0;
+    for(size_t item = 0; item < items; ++item)
+    {
+        out << (item ? "," : "") << jsonString(QString::fromStdString(std::string(Profiler::Stage_Name(info->Profiler_Get().Item_Stage(item))) + ' ' + info->Profiler_Get().Item_Name(item)))
+            << ":" << info->Profiler_Get().Item_Time_Get(item) / 1000000000.0;
+    }
+    out << "},\"queues\":[";
+    for(size_t i = 0; i < queues.size(); ++i)
+        out << (i ? "," : "") << queues[i];
+    out << "],\"peak_rss\":" << Profiler::PeakMemory_Get() << "}" << std::endl;
 }
 
 int Cli::exec(QCoreApplication &a)
@@ -14,12 +103,24 @@ int Cli::exec(QCoreApplication &a)
     std::string copyright = "Copyright (c) 2013-2018 BAVC";
 
     QString input;
+    QStringList inputs;
+    QString inputList;
     QString output;
     QStringList filterStrings;
     bool forceOutput = false;
     bool showLongHelp = false;
     bool showShortHelp = false;
     bool showVersion = false;
+    int segmentsCount = 1;
+    int threadCount = -1;
+    QString threadType;
+    int lossless = -1;
+    int compressionLevel = -1;
+    int checkpointInterval = -1;
+    int maxThreads = 0;
+    bool packetsOnly = false;
+    QString sampling;
+    QString progressFormat;
 
     bool uploadToSignalServer = false;
     bool forceUploadToSignalServer = false;
@@ -30,7 +131,11 @@ int Cli::exec(QCoreApplication &a)
     {
         if(a.arguments().at(i) == "-i" && (i + 1) < a.arguments().length())
         {
-            input = a.arguments().at(i + 1);
+            inputs.append(a.arguments().at(i + 1));
+            ++i;
+        } else if(a.arguments().at(i) == "-list" && (i + 1) < a.arguments().length())
+        {
+            inputList = a.arguments().at(i + 1);
             ++i;
         } else if(a.arguments().at(i) == "-o" && (i + 1) < a.arguments().length())
         {
@@ -52,6 +157,50 @@ int Cli::exec(QCoreApplication &a)
         } else if(a.arguments().at(i) == "-f" && (i + 1) < a.arguments().length())
         {
             filterStrings = a.arguments().at(i + 1).split('+');
+        } else if(a.arguments().at(i) == "-segments" && (i + 1) < a.arguments().length())
+        {
+            segmentsCount = a.arguments().at(i + 1).toInt();
+            ++i;
+        } else if(a.arguments().at(i) == "-threads" && (i + 1) < a.arguments().length())
+        {
+            threadCount = a.arguments().at(i + 1).toInt();
+            ++i;
+        } else if(a.arguments().at(i) == "-thread_type" && (i + 1) < a.arguments().length())
+        {
+            threadType = a.arguments().at(i + 1);
+            ++i;
+        } else if(a.arguments().at(i) == "-lossless")
+        {
+            lossless = 1;
+        } else if(a.arguments().at(i) == "-compression_level" && (i + 1) < a.arguments().length())
+        {
+            compressionLevel = a.arguments().at(i + 1).toInt();
+            ++i;
+        } else if(a.arguments().at(i) == "-checkpoint" && (i + 1) < a.arguments().length())
+        {
+            checkpointInterval = a.arguments().at(i + 1).toInt();
+            ++i;
+        } else if(a.arguments().at(i) == "-max_threads" && (i + 1) < a.arguments().length())
+        {
+            maxThreads = a.arguments().at(i + 1).toInt();
+            ++i;
+        } else if((a.arguments().at(i) == "-progress" || a.arguments().at(i) == "--progress") && (i + 1) < a.arguments().length())
+        {
+            progressFormat = a.arguments().at(i + 1);
+            ++i;
+        } else if(a.arguments().at(i).startsWith("-progress=") || a.arguments().at(i).startsWith("--progress="))
+        {
+            progressFormat = a.arguments().at(i).section('=', 1);
+        } else if(a.arguments().at(i) == "-sampling" && (i + 1) < a.arguments().length())
+        {
+            sampling = a.arguments().at(i + 1);
+            ++i;
+        } else if(a.arguments().at(i) == "-packets")
+        {
+            packetsOnly = true;
+        } else if(a.arguments().at(i) == "-profile")
+        {
+            profileSummary = true;
         } else if(a.arguments().at(i) == "-h")
         {
             showLongHelp = true;
@@ -61,9 +210,54 @@ int Cli::exec(QCoreApplication &a)
         }
     }
 
+    // Batch: several inputs, directories or a list of files (one per line, "-" for stdin)
+    bool batch = inputs.size() > 1 || !inputList.isEmpty();
+    if(!inputList.isEmpty())
+    {
+        QFile list;
+        bool opened;
+        if(inputList == "-")
+            opened = list.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+        else
+        {
+            list.setFileName(inputList);
+            opened = list.open(QIODevice::ReadOnly | QIODevice::Text);
+        }
+        if(!opened)
+        {
+            std::cout << "list of inputs " << inputList.toStdString() << " can not be read, exiting.. " << std::endl;
+            return NoInput;
+        }
+        foreach(QString line, QString::fromUtf8(list.readAll()).split('\n'))
+        {
+            line = line.trimmed();
+            if(!line.isEmpty())
+                inputs.append(line);
+        }
+    }
+    QStringList expandedInputs;
+    foreach(QString item, inputs)
+    {
+        if(!QFileInfo(item).isDir())
+        {
+            expandedInputs.append(item);
+            continue;
+        }
+
+        // Media files of the directory, reports are not analyzed again
+        batch = true;
+        QDir dir(item);
+        foreach(QString name, dir.entryList(QDir::Files, QDir::Name))
+            if(!name.contains(".qctools."))
+                expandedInputs.append(dir.filePath(name));
+    }
+    inputs = expandedInputs;
+    if(!batch && !inputs.isEmpty())
+        input = inputs.front();
+
     if(!showLongHelp)
     {
-        if(a.arguments().length() == 1 || (checkUploadFileName.isEmpty() && input.isEmpty()))
+        if(a.arguments().length() == 1 || (checkUploadFileName.isEmpty() && inputs.isEmpty() && !batch))
             showShortHelp = true;
     }
 
@@ -92,11 +286,18 @@ int Cli::exec(QCoreApplication &a)
                 << "Usage: " << appName << " -i <qctools-input> [-o <qctools-output>]" << std::endl
                 << std::endl
                 << "-i <input file>" << std::endl
-                << "    Specifies absolute path of input file, including extension." << std::endl
+                << "    Specifies absolute path of input file, including extension. May be used" << std::endl
+                << "    several times, and may be a directory (all its files are analyzed)." << std::endl
+                << "-list <list file>" << std::endl
+                << "    Analyzes the input files listed in <list file>, one per line. \"-\" reads the" << std::endl
+                << "    list from the standard input." << std::endl
                 << "-o <output file>" << std::endl
-                << "    Specifies output file path, including extension. If no output file is" << std::endl
+                << "    Specifies output file path, including extension. If several input files are" << std::endl
+                << "    analyzed, specifies the directory of the output files. If no output file is" << std::endl
                 << "    declared, qctools will create an output named after the input file, suffixed" << std::endl
-                << "    with \".qctools.xml.gz\"." << std::endl
+                << "    with \".qctools.xml.gz\". Outputs ending with \".qctools.bin\" are written in" << std::endl
+                << "    the native binary format: all values are kept and read back without text" << std::endl
+                << "    parsing, but they are still all decoded when the file is opened." << std::endl
                 << "-f" << std::endl
                 << "    Specifies '+'-separated string of filters used. Example: -f signalstats+cropdetect" << std::endl
                 << "    The filters used in " << appName << " may also be declared via the qctools-gui (see the" << std::endl
@@ -116,6 +317,58 @@ int Cli::exec(QCoreApplication &a)
                 << std::endl
                 << "-y" << std::endl
                 << "    Force creation of <qctools-report> even if it already exists" << std::endl
+                << "-segments <count>" << std::endl
+                << "    Splits the input file at key frames into <count> parts analyzed in parallel," << std::endl
+                << "    then merged into a single <qctools-report>. Default is 1 (no split)." << std::endl
+                << "    Only seekable input files with a video stream are split. Each part is" << std::endl
+                << "    decoded and filtered from a few seconds before its start, so filters using" << std::endl
+                << "    previous frames match a single pass; ebur128 integrated values (I, LRA)" << std::endl
+                << "    still restart at each part." << std::endl
+                << "-threads <count>" << std::endl
+                << "    Count of decoder threads. 0 shares the cores between the files being" << std::endl
+                << "    analyzed and the segments of each file. Default is set in qctools-gui" << std::endl
+                << "    (see the Preferences panel)." << std::endl
+                << "-thread_type <type>" << std::endl
+                << "    Decoder threading: auto, frame or slice. Frame threading is faster on long" << std::endl
+                << "    GOP files, slice threading has a lower latency." << std::endl
+                << "-lossless" << std::endl
+                << "    Keeps all per frame values at full precision while analyzing. Default stores" << std::endl
+                << "    integer values (sample values, crop positions, sizes) in compact types (16-bit," << std::endl
+                << "    32-bit integers), other values and time stamps stay at full precision." << std::endl
+                << "    Default is set in qctools-gui (see the Preferences panel)." << std::endl
+                << "-compression_level <level>" << std::endl
+                << "    gzip compression level of \".qctools.xml.gz\" outputs, from 0 (fastest) to 9" << std::endl
+                << "    (smallest). Compression is spread over all cores. Default is 6." << std::endl
+                << "-checkpoint <seconds>" << std::endl
+                << "    Saves the analysis progress every <seconds> in \"<input>.qctools.part\", so an" << std::endl
+                << "    interrupted analysis restarts from the last saved key frame. The directory of" << std::endl
+                << "    <input> must be writable. The file is not used if the filters, -lossless or" << std::endl
+                << "    -sampling changed. 0 disables it. Default is set in qctools-gui (see the" << std::endl
+                << "    Preferences panel), disabled if not set." << std::endl
+                << "-max_threads <count>" << std::endl
+                << "    Count of threads shared by all the files being analyzed. Default is the count" << std::endl
+                << "    of cores." << std::endl
+                << "-sampling <mode>" << std::endl
+                << "    Video frames analyzed, for a quick triage of large archives: all, keyframes" << std::endl
+                << "    (other frames are not decoded) or a number N (one frame out of N, all frames" << std::endl
+                << "    are decoded but only these ones are filtered). Frames not analyzed are not in" << std::endl
+                << "    <qctools-report>, which marks the gaps between analyzed frames. Frame numbers" << std::endl
+                << "    of such a report in qctools-gui are the positions of the analyzed frames. Audio" << std::endl
+                << "    is always fully analyzed. Default is all." << std::endl
+                << "-packets" << std::endl
+                << "    Only container values of each frame are analyzed (pkt_size," << std::endl
+                << "    pkt_duration_time, key_frame, pkt_pos, pkt_pts), from the packets, without" << std::endl
+                << "    decoding: files are read at disk speed. Filters are not used (-f is ignored)," << std::endl
+                << "    frames are in decoding order and there are no thumbnails." << std::endl
+                << "-progress <format>" << std::endl
+                << "    Progress report: bar (default) or json. With json, one JSON object per line" << std::endl
+                << "    is written on the standard output every 500 ms (frames and bytes read per" << std::endl
+                << "    second, time spent per stage, pipeline queue depths, peak memory), followed" << std::endl
+                << "    by a \"result\" object per input file; other messages go to the standard error." << std::endl
+                << "-profile" << std::endl
+                << "    Measures the time spent per stage (demux, each decoder, each filter graph," << std::endl
+                << "    scale, JPEG encoding, export...) and prints a summary per input file." << std::endl
+                << "    Always enabled with -progress json." << std::endl
                 << std::endl;
 
             std::cout
@@ -145,14 +398,29 @@ int Cli::exec(QCoreApplication &a)
                 << "        upload stats to Signal Server unconditionally" << std::endl
                 << "    " << appName << " -c file.mkv.qctools.xml.gzip" << std::endl
                 << "        checks if such a file exists on Signal Server" << std::endl
+                << "    " << appName << " -i clips -max_threads 16" << std::endl
+                << "        analyzes all files of the clips directory, with 16 threads in total" << std::endl
+                << "    find . -name \"*.mkv\" | " << appName << " -list -" << std::endl
+                << "        analyzes the files listed on the standard input" << std::endl
                 << std::endl;
         }
 
         return Success;
     }
 
+    if(progressFormat == "json")
+    {
+        // Standard output is kept for JSON lines only
+        jsonOutput = std::unique_ptr<std::ostream>(new std::ostream(std::cout.rdbuf()));
+        *jsonOutput << std::fixed << std::setprecision(3);
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
     std::cout << appName << " " << (VERSION) << std::endl;
 
+    if(!progressFormat.isEmpty() && progressFormat != "json" && progressFormat != "bar")
+        std::cout << "warning: unknown progress format " << progressFormat.toStdString() << ", bar is used" << std::endl;
+
     Preferences prefs;
 
     signalServer = std::unique_ptr<SignalServer>(new SignalServer());
@@ -187,34 +455,44 @@ int Cli::exec(QCoreApplication &a)
         return op->state() == CheckFileUploadedOperation::Uploaded ? Uploaded : NotUploaded;
     }
 
-    if(input.isEmpty())
+    if(batch ? inputs.isEmpty() : input.isEmpty())
         return NoInput;
 
-    if(!input.endsWith(".qctools.xml.gz")) // skip output if input is already .qctools.xml.gz
+    if(batch && !output.isEmpty() && !QFileInfo(output).isDir())
+    {
+        std::cout << "output " << output.toStdString() << " is not a directory, exiting.. " << std::endl;
+        return NoInput;
+    }
+
+    if(!batch && !input.endsWith(".qctools.xml.gz") && !input.endsWith(".qctools.bin")) // skip output if input is already .qctools.xml.gz or .qctools.bin
     {
         if(output.isEmpty())
             output = input + ".qctools.xml.gz";
     }
 
-    bool mkvReport = output.endsWith(".qctools.mkv");
+    bool mkvReport = !batch && output.endsWith(".qctools.mkv");
     bool xmlGzReport = output.endsWith(".xml.gz");
+    bool binReport = output.endsWith(".qctools.bin");
 
-    if(!output.isEmpty() && !xmlGzReport && !mkvReport)
+    if(!batch && !output.isEmpty() && !xmlGzReport && !mkvReport && !binReport)
     {
         std::cout << "warning: non-standard extension (not *.xml.gz) has been specified for output file. " << std::endl;
     }
 
-    QFile file(output);
-    if(file.exists() && !forceOutput)
+    if(!batch)
     {
-        std::cout << "file " << output.toStdString() << " already exists, exiting.. " << std::endl;
-        return OutputAlreadyExists;
-    }
+        QFile file(output);
+        if(file.exists() && !forceOutput)
+        {
+            std::cout << "file " << output.toStdString() << " already exists, exiting.. " << std::endl;
+            return OutputAlreadyExists;
+        }
 
-    if(file.exists() && forceOutput)
-    {
-        std::cout << "file " << output.toStdString() << " already exists and will be overwritten..." << std::endl;
-        file.remove();
+        if(file.exists() && forceOutput)
+        {
+            std::cout << "file " << output.toStdString() << " already exists and will be overwritten..." << std::endl;
+            file.remove();
+        }
     }
 
     activefilters filters = prefs.activeFilters();
@@ -248,6 +526,9 @@ int Cli::exec(QCoreApplication &a)
         }
     }
 
+    if(packetsOnly)
+        filters = 0; // Filters need decoded frames
+
     std::cout << "filters selected: ";
     if(filters.test(ActiveFilter_Video_signalstats))
         std::cout << "signalstats" << " ";
@@ -271,18 +552,73 @@ int Cli::exec(QCoreApplication &a)
         std::cout << "entropy" << " ";
     if(filters.test(ActiveFilter_Video_EntropyDiff))
         std::cout << "entropy-diff" << " ";
+    if(packetsOnly)
+        std::cout << "none (packets only)";
 
     std::cout << std::endl;
 
+    decoderthreading threading = prefs.decoderThreading();
+    if(threadType == "auto")
+        threading = DecoderThreading_Auto;
+    else if(threadType == "frame")
+        threading = DecoderThreading_Frame;
+    else if(threadType == "slice")
+        threading = DecoderThreading_Slice;
+    if(threadCount < 0)
+        threadCount = prefs.decoderThreadCount();
+    if(lossless < 0)
+        lossless = prefs.losslessStats();
+    if(checkpointInterval < 0)
+        checkpointInterval = prefs.checkpointInterval();
+
+    // Sampling is only for reports made by qcli, qctools-gui always analyzes all frames
+    samplingmode samplingMode = Sampling_All;
+    int samplingStride = 1;
+    if(sampling == "all")
+        samplingMode = Sampling_All;
+    else if(sampling == "keyframes")
+        samplingMode = Sampling_KeyFrames;
+    else if(sampling.toInt() > 1)
+    {
+        samplingMode = Sampling_Stride;
+        samplingStride = sampling.toInt();
+    }
+    else if(sampling == "1")
+        samplingMode = Sampling_All;
+    else if(!sampling.isEmpty())
+        std::cout << "warning: unknown sampling " << sampling.toStdString() << ", all frames are analyzed" << std::endl;
+
+    FileInformation::setParallelSegmentsCount(segmentsCount);
+    FileInformation::setDecoderThreading(threading, threadCount);
+    CommonStats::Lossless_Set(lossless != 0);
+    ExportWriter::Level_Set(compressionLevel);
+    FileInformation::setCheckpointInterval(checkpointInterval);
+    FileInformation::setSampling(samplingMode, samplingStride);
+    FileInformation::setPacketsOnly(packetsOnly);
+    AnalysisScheduler::instance()->setThreadBudget(maxThreads);
+    Profiler::Enabled_Set(profileSummary || jsonOutput);
+
+    if(batch)
+    {
+        if(uploadToSignalServer || forceUploadToSignalServer)
+            std::cout << "warning: upload to signalserver is not available with several input files" << std::endl;
+        return execBatch(a, inputs, output, forceOutput, filters);
+    }
+
     info = std::unique_ptr<FileInformation>(new FileInformation(signalServer.get(), input, filters, prefs.activeAllTracks()));
     info->setAutoCheckFileUploaded(false);
     info->setAutoUpload(false);
 
     std::cout << std::endl << "analyzing input file... " << input.toStdString() << std::endl;
 
+    jsonInput = input;
+    jsonTimer.start();
+
     if(!info->isValid())
     {
         std::cout << "invalid input, analyzing aborted.. " << std::endl;
+        if(jsonOutput)
+            writeJson("result", input, nullptr, nullptr, jsonTimer.elapsed(), 0, 0, 0, InvalidInput);
         return InvalidInput;
     }
 
@@ -312,8 +648,13 @@ int Cli::exec(QCoreApplication &a)
 
         std::cout << std::endl << "analyzing " << (info->parsed() ? "completed" : "failed") << std::endl;
 
+        jsonAnalysisElapsed = jsonTimer.elapsed();
         if(!info->parsed())
+        {
+            if(jsonOutput)
+                writeJson("result", input, info.get(), "analyzing", jsonAnalysisElapsed, jsonAnalysisElapsed, 0, 0, ParsingFailure);
             return ParsingFailure;
+        }
 
         // export
         std::cout << std::endl << "generating QCTools report... " << std::endl;
@@ -362,6 +703,11 @@ int Cli::exec(QCoreApplication &a)
 
             a.quit();
         });
+        bool exportFailed = false;
+        QObject::connect(info.get(), &FileInformation::statsFileGenerationFailed, this, [&](const QString&) {
+            exportFailed = true;
+            a.quit();
+        });
         info->setExportFilters(filters);
 
         if(mkvReport) {
@@ -373,12 +719,24 @@ int Cli::exec(QCoreApplication &a)
 
         QObject::disconnect(info.get(), SIGNAL(statsFileGenerationProgress(quint64, quint64)), this, SLOT(onStatsFileGenerationProgress(quint64, quint64)));
 
-        std::cout << std::endl << "generating QCTools report... done" << std::endl;
+        std::cout << std::endl << "generating QCTools report... " << (exportFailed ? "failed" : "done") << std::endl;
+
+        if(profileSummary)
+            std::cout << std::endl << "time spent per stage:" << std::endl << info->Profiler_Get().Summary_Get();
+
+        if(jsonOutput)
+            writeJson("result", input, info.get(), "exporting", jsonTimer.elapsed(), jsonAnalysisElapsed, statsFileBytesWritten, statsFileBytesTotal,
+                      exportFailed ? ExportFailure : Success);
+        if(exportFailed)
+            return ExportFailure;
     }
     else
     {
         // stats already generated
         output = input;
+
+        if(jsonOutput)
+            writeJson("result", input, info.get(), nullptr, jsonTimer.elapsed(), 0, 0, 0, Success);
     }
 
     if(uploadToSignalServer || forceUploadToSignalServer)
@@ -431,8 +789,188 @@ int Cli::exec(QCoreApplication &a)
     return 0;
 }
 
+int Cli::execBatch(QCoreApplication &a, const QStringList& inputs, const QString& outputDirectory, bool forceOutput, const activefilters& filters)
+{
+    struct BatchJob
+    {
+        QString input;
+        QString output;
+        FileInformation* info;
+        bool exporting;
+        bool exportFailed;
+        int result;
+        QElapsedTimer timer;
+        qint64 analysisElapsed;
+        quint64 written;
+        quint64 total;
+    };
+    std::vector<BatchJob> jobs(inputs.size());
+    for(int i = 0; i < inputs.size(); ++i)
+    {
+        jobs[i].input = inputs.at(i);
+        jobs[i].output = outputDirectory.isEmpty() ? (inputs.at(i) + ".qctools.xml.gz") : QDir(outputDirectory).filePath(QFileInfo(inputs.at(i)).fileName() + ".qctools.xml.gz");
+        jobs[i].info = nullptr;
+        jobs[i].exporting = false;
+        jobs[i].exportFailed = false;
+        jobs[i].result = Success;
+        jobs[i].analysisElapsed = 0;
+        jobs[i].written = 0;
+        jobs[i].total = 0;
+    }
+
+    // Files are opened only when a parsing slot is about to be free, so memory does not depend on the count of files
+    size_t nextJob = 0;
+    size_t doneJobs = 0;
+    int openedJobs = 0;
+    Preferences prefs;
+
+    auto finish = [&](size_t i, int result, const char* message) {
+        BatchJob& job = jobs[i];
+        job.result = result;
+        if(jsonOutput)
+            writeJson("result", job.input, job.info, job.exporting ? "exporting" : "analyzing", job.timer.isValid() ? job.timer.elapsed() : 0,
+                      job.exporting ? job.analysisElapsed : (job.timer.isValid() ? job.timer.elapsed() : 0), job.written, job.total, result);
+        std::string summary;
+        if(job.info && profileSummary)
+            summary = job.info->Profiler_Get().Summary_Get();
+        if(job.info)
+        {
+            delete job.info;
+            job.info = nullptr;
+            --openedJobs;
+        }
+
+        ++doneJobs;
+        std::cout << "[" << doneJobs << "/" << jobs.size() << "] " << job.input.toStdString() << ": " << message << " (" << result << ")" << std::endl;
+        std::cout << summary;
+
+        if(doneJobs == jobs.size())
+            a.quit();
+    };
+
+    std::function<void()> startNext;
+    startNext = [&]() {
+        while(nextJob < jobs.size() && openedJobs <= AnalysisScheduler::instance()->maxRunningJobs())
+        {
+            size_t i = nextJob++;
+            BatchJob& job = jobs[i];
+
+            QFile file(job.output);
+            if(file.exists())
+            {
+                if(!forceOutput)
+                {
+                    finish(i, OutputAlreadyExists, "report already exists");
+                    continue;
+                }
+                file.remove();
+            }
+
+            // Parsing is started by the constructor, as soon as the scheduler has a free slot
+            job.timer.start();
+            job.info = new FileInformation(signalServer.get(), job.input, filters, prefs.activeAllTracks());
+            job.info->setAutoCheckFileUploaded(false);
+            job.info->setAutoUpload(false);
+            ++openedJobs;
+
+            if(!job.info->isValid())
+            {
+                finish(i, InvalidInput, "invalid input");
+                continue;
+            }
+            if(job.info->hasStats() && !forceOutput)
+            {
+                finish(i, Success, "stats already generated");
+                continue;
+            }
+
+            // Same thread is used for parsing then export
+            // A short file may be parsed before the connection, and finished() may then be received after the export is started
+            auto onFinished = [&, i]() {
+                BatchJob& job = jobs[i];
+                if(!job.info || job.info->isRunning())
+                    return;
+                if(!job.exporting)
+                {
+                    if(!job.info->parsed())
+                    {
+                        finish(i, ParsingFailure, "analyzing failed");
+                        startNext();
+                        return;
+                    }
+                    job.exporting = true;
+                    job.analysisElapsed = job.timer.elapsed();
+                    job.info->wait(); // finished() is sent just before the end of the thread
+                    job.info->setExportFilters(filters);
+                    job.info->startExport(job.output);
+                }
+                else
+                {
+                    if(job.exportFailed)
+                        finish(i, ExportFailure, "generating QCTools report failed");
+                    else
+                        finish(i, Success, "done");
+                    startNext();
+                }
+            };
+            QObject::connect(job.info, &QThread::finished, this, onFinished);
+            QObject::connect(job.info, &FileInformation::parsingCompleted, this, [onFinished](bool success) {
+                if(!success)
+                    onFinished(); // Also sent when the parsing could not be started
+            });
+            QObject::connect(job.info, &FileInformation::statsFileGenerationFailed, this, [&, i](const QString&) {
+                jobs[i].exportFailed = true; // Sent from the file thread, before finished()
+            });
+            QObject::connect(job.info, &FileInformation::statsFileGenerationProgress, this, [&, i](quint64 written, quint64 total) {
+                jobs[i].written = written;
+                jobs[i].total = total;
+            });
+            if(job.info->isFinished())
+                onFinished();
+        }
+    };
+
+    // Progress of the files being analyzed or exported
+    QTimer jsonProgressTimer;
+    QObject::connect(&jsonProgressTimer, &QTimer::timeout, this, [&]() {
+        for(size_t i = 0; i < jobs.size(); ++i)
+        {
+            BatchJob& job = jobs[i];
+            if(job.info && job.timer.isValid())
+                writeJson("progress", job.input, job.info, job.exporting ? "exporting" : "analyzing", job.timer.elapsed(),
+                          job.exporting ? job.analysisElapsed : job.timer.elapsed(), job.written, job.total);
+        }
+    });
+    if(jsonOutput)
+        jsonProgressTimer.start(500);
+
+    std::cout << std::endl << "analyzing " << jobs.size() << " input files with " << AnalysisScheduler::instance()->threadBudget() << " threads..." << std::endl;
+    startNext();
+    if(doneJobs < jobs.size())
+        a.exec();
+
+    // First failure in input order, each file has its own code in the log
+    int result = Success;
+    size_t failedJobs = 0;
+    for(size_t i = 0; i < jobs.size(); ++i)
+    {
+        if(jobs[i].result != Success)
+        {
+            if(result == Success)
+                result = jobs[i].result;
+            ++failedJobs;
+        }
+    }
+    std::cout << std::endl << "analyzing completed, " << (jobs.size() - failedJobs) << " of " << jobs.size() << " input files succeeded" << std::endl;
+
+    return result;
+}
+
 void Cli::updateParsingProgress()
 {
+    if(jsonOutput)
+        writeJson("progress", jsonInput, info.get(), "analyzing", jsonTimer.elapsed(), jsonTimer.elapsed(), 0, 0);
+
     int value = info->Glue->FramesProcessedPerStream(indexOfStreamWithKnownFrameCount) * progress->getMax() /
             info->Glue->FramesCountPerStream(indexOfStreamWithKnownFrameCount);
 
@@ -444,6 +982,13 @@ void Cli::onStatsFileGenerationProgress(quint64 written, quint64 total)
     statsFileBytesWritten = written;
     statsFileBytesTotal = total;
 
+    // Export progress is sent for each block of frames, JSON lines are limited to the usual rate
+    if(jsonOutput && (jsonTimer.elapsed() - jsonExportLast >= 500 || written == total))
+    {
+        jsonExportLast = jsonTimer.elapsed();
+        writeJson("progress", jsonInput, info.get(), "exporting", jsonExportLast, jsonAnalysisElapsed, written, total);
+    }
+
     if(statsFileBytesWritten != 0 && statsFileBytesTotal != 0)
     {
         int value = statsFileBytesWritten * progress->getMax() / statsFileBytesTotal;
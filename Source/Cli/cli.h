@@ -17,6 +17,7 @@
 #include <memory>
 #include <iostream>
 #include <QTimer>
+#include <QElapsedTimer>
 
 enum Errors {
     Success = 0,
@@ -26,7 +27,8 @@ enum Errors {
     InvalidInput = 4,
     CheckFileUploadedError = 5,
     Uploaded = 6,
-    NotUploaded = 7
+    NotUploaded = 7,
+    ExportFailure = 8
 };
 
 class ProgressBar
@@ -82,6 +84,10 @@ public slots:
     void onSignalServerUploadProgressChanged(qint64 written, qint64 total);
 
 private:
+    int execBatch(QCoreApplication& a, const QStringList& inputs, const QString& outputDirectory, bool forceOutput, const activefilters& filters);
+    void writeJson(const char* type, const QString& input, FileInformation* info, const char* phase, qint64 elapsed, qint64 analysisElapsed,
+                   quint64 written, quint64 total, int code = Success);
+
     std::unique_ptr<FileInformation> info;
     std::unique_ptr<ProgressBar> progress;
     std::unique_ptr<SignalServer> signalServer;
@@ -94,6 +100,16 @@ private:
 
     qint64 statsFileBytesUploaded;
     qint64 statsFileBytesToUpload;
+
+    // Machine-readable progress (-progress json), one JSON object per line on the standard output
+    std::unique_ptr<std::ostream> jsonOutput;
+    QString jsonInput;
+    QElapsedTimer jsonTimer;
+    qint64 jsonAnalysisElapsed;
+    qint64 jsonExportLast;
+
+    // Time spent per stage, printed after each input file (-profile)
+    bool profileSummary;
 };
 
 #endif // 
@@ -0,0 +1,178 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Core/AnalysisScheduler.h"
+#include "Core/FileInformation.h"
+
+#include <QThread>
+
+#include <algorithm>
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Constructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+AnalysisScheduler::AnalysisScheduler() :
+    m_priorityFile(NULL),
+    m_threadBudget(0)
+{
+}
+
+//---------------------------------------------------------------------------
+AnalysisScheduler* AnalysisScheduler::instance()
+{
+    static AnalysisScheduler scheduler;
+    return &scheduler;
+}
+
+//***************************************************************************
+// Budget
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void AnalysisScheduler::setThreadBudget(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_threadBudget = count > 0 ? count : 0;
+}
+
+//---------------------------------------------------------------------------
+int AnalysisScheduler::threadBudget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_threadBudget ? m_threadBudget : QThread::idealThreadCount();
+}
+
+//---------------------------------------------------------------------------
+int AnalysisScheduler::maxRunningJobs() const
+{
+    // Keeping some cores for the user interface and the output threads
+    int max = threadBudget();
+    if (max > 2)
+        max -= 2;
+    else
+        max = 1;
+
+    return max;
+}
+
+//---------------------------------------------------------------------------
+int AnalysisScheduler::decoderThreadCount(int segmentsCount) const
+{
+    int budget = threadBudget();
+    int maxJobs = maxRunningJobs();
+
+    // Jobs expected to run at the same time as the job being started, which is already running
+    int jobs;
+    {
+        QMutexLocker locker(&m_mutex);
+        jobs = (int) (m_running.size() + m_queued.size());
+    }
+    if (jobs < 1)
+        jobs = 1;
+    if (jobs > maxJobs)
+        jobs = maxJobs;
+
+    int count = budget / jobs / (segmentsCount > 1 ? segmentsCount : 1);
+    return count > 1 ? count : 1;
+}
+
+//***************************************************************************
+// Jobs
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void AnalysisScheduler::enqueue(FileInformation* file)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (std::find(m_running.begin(), m_running.end(), file) != m_running.end()
+         || std::find(m_queued.begin(), m_queued.end(), file) != m_queued.end())
+            return;
+
+        m_queued.push_back(file);
+    }
+
+    schedule();
+}
+
+//---------------------------------------------------------------------------
+void AnalysisScheduler::finished(FileInformation* file)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_running.erase(std::remove(m_running.begin(), m_running.end(), file), m_running.end());
+    }
+
+    // The freed slot is used immediately
+    schedule();
+}
+
+//---------------------------------------------------------------------------
+void AnalysisScheduler::remove(FileInformation* file)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queued.erase(std::remove(m_queued.begin(), m_queued.end(), file), m_queued.end());
+        if (m_priorityFile == file)
+            m_priorityFile = NULL;
+    }
+
+    schedule();
+}
+
+//---------------------------------------------------------------------------
+void AnalysisScheduler::setPriorityFile(FileInformation* file)
+{
+    QMutexLocker locker(&m_mutex);
+    m_priorityFile = file;
+}
+
+//---------------------------------------------------------------------------
+int AnalysisScheduler::runningJobsCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return (int) m_running.size();
+}
+
+//---------------------------------------------------------------------------
+int AnalysisScheduler::queuedJobsCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return (int) m_queued.size();
+}
+
+//---------------------------------------------------------------------------
+void AnalysisScheduler::schedule()
+{
+    int maxJobs = maxRunningJobs();
+
+    std::vector<FileInformation*> failed;
+    {
+        QMutexLocker locker(&m_mutex);
+        while ((int) m_running.size() < maxJobs && !m_queued.empty())
+        {
+            // Selected file first, else first in first out
+            std::deque<FileInformation*>::iterator next = std::find(m_queued.begin(), m_queued.end(), m_priorityFile);
+            if (next == m_queued.end())
+                next = m_queued.begin();
+
+            FileInformation* file = *next;
+            m_queued.erase(next);
+            if (file->startParseThread())
+                m_running.push_back(file);
+            else
+                failed.push_back(file);
+        }
+    }
+
+    // Reported outside of the lock, receivers may enqueue other files
+    for (size_t i = 0; i < failed.size(); ++i)
+        failed[i]->parseStartFailed();
+}
@@ -0,0 +1,53 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef AnalysisScheduler_H
+#define AnalysisScheduler_H
+//---------------------------------------------------------------------------
+
+#include <QMutex>
+
+#include <deque>
+#include <vector>
+
+class FileInformation;
+
+//---------------------------------------------------------------------------
+// Shared by all FileInformation instances: decides which files are parsed
+// and how many threads each one gets, from a single thread budget
+class AnalysisScheduler
+{
+public:
+    static AnalysisScheduler*   instance();
+
+    // Budget
+    void                        setThreadBudget(int count); // 0 for the count of cores
+    int                         threadBudget() const;
+    int                         maxRunningJobs() const;
+    int                         decoderThreadCount(int segmentsCount) const; // Share of the budget for a job being started
+
+    // Jobs
+    void                        enqueue(FileInformation* file);
+    void                        finished(FileInformation* file);
+    void                        remove(FileInformation* file);
+    void                        setPriorityFile(FileInformation* file); // Started before the other queued files
+    int                         runningJobsCount() const;
+    int                         queuedJobsCount() const;
+
+private:
+    AnalysisScheduler();
+
+    void                        schedule();
+
+    mutable QMutex              m_mutex;
+    std::deque<FileInformation*> m_queued;
+    std::vector<FileInformation*> m_running;
+    FileInformation*            m_priorityFile;
+    int                         m_threadBudget;
+};
+
+#endif // AnalysisScheduler_H
@@ -27,10 +27,13 @@ public:
     ~AudioStats();
 
     // External data
-    void                        StatsFromExternalData(const char* Data, size_t Size);
     void                        StatsFromFrame(struct AVFrame* Frame, int Width, int Height);
     void                        TimeStampFromFrame(struct AVFrame* Frame, size_t FramePos);
-    string                      StatsToXML(const activefilters& filters);
+    void                        StatsFromPacket(struct AVPacket* Packet, int PixFmt);
+    void                        StatsToXML(StatsXmlBuffer& Data, const activefilters& filters, size_t x_Begin=0, size_t x_End=(size_t)-1);
+
+    // Segments
+    CommonStats*                Segment_Create(size_t FrameCount, double Duration) const;
 };
 
 #endif // Stats_H
@@ -21,14 +21,21 @@ extern "C"
 }
 
 #include "Core/Core.h"
+#include "Core/StatsBinary.h"
+#include "Core/StatsXmlBuffer.h"
+#include "Core/XmlPullParser.h"
 #include "tinyxml2.h"
 #include <sstream>
 #include <iomanip>
 #include <cstdlib>
 #include <cfloat>
+#include <cmath>
 using namespace tinyxml2;
 //---------------------------------------------------------------------------
 
+//---------------------------------------------------------------------------
+bool CommonStats::Lossless=false;
+
 //***************************************************************************
 // Constructor / Destructor
 //***************************************************************************
@@ -36,6 +43,7 @@ using namespace tinyxml2;
 //---------------------------------------------------------------------------
 CommonStats::CommonStats (const struct per_item* PerItem_, int Type_, size_t CountOfGroups_, size_t CountOfItems_, size_t FrameCount, double Duration, AVStream* stream)
     :
+    x(&FirstTimeStamp),
     Frequency(stream ? (((double)stream->time_base.den) / stream->time_base.num) : 0),
     streamIndex(stream ? stream->index : -1),
     Type(Type_),
@@ -52,19 +60,23 @@ CommonStats::CommonStats (const struct per_item* PerItem_, int Type_, size_t Cou
 
     // Status
     IsComplete=false;
+    Sampled=false;
     FirstTimeStamp=DBL_MAX;
 
+    // External data
+    ExternalData_StatsMapInitialized=false;
+    ExternalData_Width=0;
+    ExternalData_Height=0;
+
     // Memory management
-    if (FrameCount<10*3600*30)
+    Data_Reserved=0;
+    Data_ChunkBits=StatsColumn<double>::Chunk_Bits_Default;
+    if (FrameCount<10*3600*30) //Else frame count is not reliable (too huge, e.g. it is sample count instead of frame count), using default chunks.
     {
-        Data_Reserved=1;
-        while (Data_Reserved<FrameCount)
-            Data_Reserved<<=1;
-        if (Data_Reserved+128>=FrameCount)
-            Data_Reserved<<=1;
+        Data_ChunkBits=8;
+        while (Data_ChunkBits<StatsColumn<double>::Chunk_Bits_Default && (((size_t)1)<<Data_ChunkBits)<FrameCount+128)
+            Data_ChunkBits++;
     }
-    else
-        Data_Reserved=1<<16; //Frame count is not reliable (too huge, e.g. it is sample count instead of frame count), reserving only a default count of frames.
 
     // Data - Counts
     Stats_Totals = new double[CountOfItems];
@@ -75,43 +87,41 @@ CommonStats::CommonStats (const struct per_item* PerItem_, int Type_, size_t Cou
     memset(Stats_Counts2, 0x00, CountOfItems*sizeof(uint64_t));
 
     // Data - x and y
-    x = new double*[4];
-    for (size_t j=0; j<4; ++j)
-    {
-        x[j]=new double[Data_Reserved];
-        memset(x[j], 0x00, Data_Reserved*sizeof(double));
-    }
-    y = new double*[CountOfItems];
+    x.Encoding_Set(StatsEncoding_Double); // Time stamps are exported with 7 digits after the comma, a float offset is not enough for long chunks
+    x.Chunk_Bits_Set(Data_ChunkBits);
+    y = new StatsValueColumn[CountOfItems];
     for (size_t j=0; j<CountOfItems; ++j)
     {
-        y[j]=new double[Data_Reserved];
-        memset(y[j], 0x00, Data_Reserved*sizeof(double));
+        y[j].Encoding_Set(Data_Encoding(j));
+        y[j].Chunk_Bits_Set(Data_ChunkBits);
     }
 
     // Data - Extra
-    durations=new double[Data_Reserved];
-    memset(durations, 0x00, Data_Reserved*sizeof(double));
-
-    key_frames=new bool[Data_Reserved];
-    memset(key_frames, 0x00, Data_Reserved*sizeof(bool));
-
-    pkt_pos = new int64_t[Data_Reserved];
-    memset(pkt_pos, 0x00, Data_Reserved * sizeof(int64_t));
-
-    pkt_pts = new int64_t[Data_Reserved];
-    memset(pkt_pts, 0x00, Data_Reserved * sizeof(int64_t));
-
-    pkt_size = new int[Data_Reserved];
-    memset(pkt_size, 0x00, Data_Reserved * sizeof(int));
-
-    pix_fmt = new int[Data_Reserved];
-    memset(pix_fmt, 0x00, Data_Reserved * sizeof(int));
-
-    pict_type_char = new char[Data_Reserved];
-    memset(pict_type_char, 0x00, Data_Reserved * sizeof(char));
-
-    comments = new char*[Data_Reserved];
-    memset(comments, 0x00, Data_Reserved * sizeof(char*));
+    durations.Chunk_Bits_Set(Data_ChunkBits);
+    key_frames.Chunk_Bits_Set(Data_ChunkBits);
+    gaps.Chunk_Bits_Set(Data_ChunkBits);
+    pkt_pos.Chunk_Bits_Set(Data_ChunkBits);
+    pkt_pts.Chunk_Bits_Set(Data_ChunkBits);
+    pkt_size.Chunk_Bits_Set(Data_ChunkBits);
+    pix_fmt.Chunk_Bits_Set(Data_ChunkBits);
+    pict_type_char.Chunk_Bits_Set(Data_ChunkBits);
+    comments.Chunk_Bits_Set(Data_ChunkBits);
+
+    // First chunk
+    Data_Reserve(0);
+
+    // Metadata keys
+    Keys_Count=0;
+    Item_Transforms.resize(CountOfItems, ItemTransform_None);
+    for (size_t j=0; j<CountOfItems; ++j)
+    {
+        const char* Name=PerItem[j].FFmpeg_Name;
+        Key_Insert(Name, j, StatsValueInfo());
+        if (!strcmp(Name, "lavfi.cropdetect.x2") || !strcmp(Name, "lavfi.cropdetect.w"))
+            Item_Transforms[j]=ItemTransform_WidthMinus;
+        else if (!strcmp(Name, "lavfi.cropdetect.y2") || !strcmp(Name, "lavfi.cropdetect.h"))
+            Item_Transforms[j]=ItemTransform_HeightMinus;
+    }
 
     // Data - Maximums
     x_Current=0;
@@ -134,45 +144,18 @@ CommonStats::~CommonStats()
     delete[] Stats_Counts;
     delete[] Stats_Counts2;
 
-    // Data - x and y
-    for (size_t j=0; j<4; ++j)
-        delete[] x[j];
-    delete[] x;
-
-    // Data - Extra
-    for (size_t j=0; j<CountOfItems; ++j)
-        delete[] y[j];
+    // Data - y
     delete[] y;
 
     // Data - Maximums
-    delete[] durations;
-    delete[] key_frames;
     delete[] y_Min;
     delete[] y_Max;
 
-    delete[] pkt_pos;
-    delete[] pkt_pts;
-    delete[] pkt_size;
-    delete[] pix_fmt;
-    delete[] pict_type_char;
-
+    // Data - Extra
     for (size_t j = 0; j < Data_Reserved; ++j)
         delete [] comments[j];
 
-    delete [] comments;
-
-    auto numberOfIntValues = lastStatsIndexByValueType[StatsValueInfo::Int];
-
-    for (size_t j = 0; j < numberOfIntValues; ++j) {
-        delete[] additionalIntStats[j];
-    }
     delete[] additionalIntStats;
-
-    auto numberOfDoubleValues = lastStatsIndexByValueType[StatsValueInfo::Double];
-
-    for (size_t j = 0; j < numberOfDoubleValues; ++j) {
-        delete[] additionalDoubleStats[j];
-    }
     delete[] additionalDoubleStats;
 
     auto numberOfStringValues = lastStatsIndexByValueType[StatsValueInfo::String];
@@ -181,8 +164,6 @@ CommonStats::~CommonStats()
         for(size_t i = 0; i < Data_Reserved; ++i) {
             free(additionalStringStats[j][i]);
         }
-
-        delete[] additionalStringStats[j];
     }
     delete[] additionalStringStats;
 }
@@ -209,32 +190,44 @@ void CommonStats::processAdditionalStats(const char* key, const char* value, boo
     }
 }
 
-void CommonStats::writeAdditionalStats(stringstream &stream, size_t index)
+void CommonStats::writeAdditionalStats(StatsXmlBuffer& Data, size_t index)
 {
     if(additionalIntStats) {
         for(size_t i = 0; i < statsKeysByIndexByValueType[StatsValueInfo::Int].size(); ++i) {
-            auto key = statsKeysByIndexByValueType[StatsValueInfo::Int][i];
+            const auto& key = statsKeysByIndexByValueType[StatsValueInfo::Int][i];
             auto value = additionalIntStats[i][index];
 
-            stream<<"            <tag key=\"" << key << "\" value=\"" << value << "\"/>\n";
+            Data.Put("            <tag key=\"");
+            Data.Put(key);
+            Data.Put("\" value=\"");
+            Data.Put_Int(value);
+            Data.Put("\"/>\n");
         }
     }
 
     if(additionalDoubleStats) {
         for(size_t i = 0; i < statsKeysByIndexByValueType[StatsValueInfo::Double].size(); ++i) {
-            auto key = statsKeysByIndexByValueType[StatsValueInfo::Double][i];
+            const auto& key = statsKeysByIndexByValueType[StatsValueInfo::Double][i];
             auto value = additionalDoubleStats[i][index];
 
-            stream<<"            <tag key=\"" << key << "\" value=\"" << std::to_string(value) << "\"/>\n";
+            Data.Put("            <tag key=\"");
+            Data.Put(key);
+            Data.Put("\" value=\"");
+            Data.Put_Fixed(value, 6);
+            Data.Put("\"/>\n");
         }
     }
 
     if(additionalStringStats) {
         for(size_t i = 0; i < statsKeysByIndexByValueType[StatsValueInfo::String].size(); ++i) {
-            auto key = statsKeysByIndexByValueType[StatsValueInfo::String][i];
+            const auto& key = statsKeysByIndexByValueType[StatsValueInfo::String][i];
             auto value = additionalStringStats[i][index];
 
-            stream<<"            <tag key=\"" << key << "\" value=\"" << value << "\"/>\n";
+            Data.Put("            <tag key=\"");
+            Data.Put(key);
+            Data.Put("\" value=\"");
+            Data.Put(value);
+            Data.Put("\"/>\n");
         }
     }
 }
@@ -243,29 +236,32 @@ void CommonStats::initializeAdditionalStats()
 {
     auto numberOfIntValues = lastStatsIndexByValueType[StatsValueInfo::Int];
     if(numberOfIntValues != 0) {
-        additionalIntStats = new int*[numberOfIntValues];
+        additionalIntStats = new StatsColumn<int>[numberOfIntValues];
         for(size_t i = 0; i < numberOfIntValues; ++i) {
-            additionalIntStats[i] = new int[Data_Reserved];
+            additionalIntStats[i].Chunk_Bits_Set(Data_ChunkBits);
+            additionalIntStats[i].Reserve(Data_Reserved);
         }
     }
     auto numberOfDoubleValues = lastStatsIndexByValueType[StatsValueInfo::Double];
     if(numberOfDoubleValues != 0) {
-        additionalDoubleStats = new double*[numberOfDoubleValues];
+        additionalDoubleStats = new StatsColumn<double>[numberOfDoubleValues];
         for(size_t i = 0; i < numberOfDoubleValues; ++i) {
-            additionalDoubleStats[i] = new double[Data_Reserved];
+            additionalDoubleStats[i].Chunk_Bits_Set(Data_ChunkBits);
+            additionalDoubleStats[i].Reserve(Data_Reserved);
         }
     }
     auto numberOfStringValues = lastStatsIndexByValueType[StatsValueInfo::String];
     if(numberOfStringValues != 0) {
-        additionalStringStats = new char**[numberOfStringValues];
+        additionalStringStats = new StatsColumn<char*>[numberOfStringValues];
         for(size_t i = 0; i < numberOfStringValues; ++i) {
-            additionalStringStats[i] = new char*[Data_Reserved];
-            memset(additionalStringStats[i], 0, sizeof(char*) * Data_Reserved);
+            additionalStringStats[i].Chunk_Bits_Set(Data_ChunkBits);
+            additionalStringStats[i].Reserve(Data_Reserved);
         }
     }
 
     for(auto entry : statsValueInfoByKeys) {
         auto& stats = entry.second;
+        Key_Insert(entry.first, CountOfItems, stats);
         if(stats.type == StatsValueInfo::Int) {
             additionalIntStats[stats.index][x_Current] = std::stoi(stats.initialValue);
         } else if(stats.type == StatsValueInfo::Double) {
@@ -300,16 +296,55 @@ double CommonStats::State_Get()
     return Value;
 }
 
+//---------------------------------------------------------------------------
+void CommonStats::TimeStampFromPacket (struct AVPacket* Packet, size_t FramePos)
+{
+    if (Frequency==0)
+        return; // Not supported
+
+    if (FramePos>=x_Current_Max)
+    {
+        x_Current_Max=FramePos+1;
+        if (x_Current_Max>Data_Reserved)
+            Data_Reserve(x_Current_Max);
+    }
+
+    int64_t ts=(Packet->pts == AV_NOPTS_VALUE) ? Packet->dts : Packet->pts; // Using DTS is PTS is not available
+    if (ts==AV_NOPTS_VALUE && FramePos)
+        ts=(int64_t)((x.TimeStamp(FramePos-1)+durations[FramePos-1])*Frequency); // If time stamp is not present, creating a fake one from last frame duration
+    if (ts!=AV_NOPTS_VALUE)
+    {
+        double TimeStamp=((double)ts)/Frequency;
+        if (TimeStamp<FirstTimeStamp)
+            FirstTimeStamp=TimeStamp; // Previous frames are relative to the new origin too
+        x.Set(FramePos, TimeStamp);
+    }
+    if (Packet->duration)
+        durations[FramePos]=((double)Packet->duration)/Frequency;
+}
+
+//---------------------------------------------------------------------------
+void CommonStats::Gap_Check ()
+{
+    if (!Sampled || !x_Current)
+        return;
+
+    // Half a frame of margin for rounding and jitter
+    double Expected=x[1][x_Current-1]+durations[x_Current-1];
+    double Margin=durations[x_Current-1]?(durations[x_Current-1]/2):0;
+    if (x[1][x_Current]>Expected+Margin)
+        gaps[x_Current]=true;
+}
+
 //---------------------------------------------------------------------------
 void CommonStats::StatsFinish ()
 {
     // Adaptation
     if (x_Current==1)
     {
-        x[0][1]=1;
-        x[1][1]=durations[0]?durations[0]:1; //forcing to 1 in case duration is not available
-        x[2][1]=durations[0]?(durations[0]/60):1; //forcing to 1 in case duration is not available
-        x[3][1]=durations[0]?(durations[0]/3600):1; //forcing to 1 in case duration is not available
+        if (FirstTimeStamp==DBL_MAX)
+            FirstTimeStamp=0;
+        x.Set(1, FirstTimeStamp+(durations[0]?durations[0]:1)); //forcing to 1 in case duration is not available
         for (size_t Plot_Pos=0; Plot_Pos<CountOfItems; Plot_Pos++)
             y[Plot_Pos][1]= y[Plot_Pos][0];
     }
@@ -330,6 +365,105 @@ void CommonStats::StatsFinish ()
     IsComplete=true;
 }
 
+//***************************************************************************
+// External data
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void CommonStats::StatsFromExternalData_Frame(const XmlPullParser& Frame)
+{
+    ExternalData_StatsMapInitialized=!statsValueInfoByKeys.empty();
+
+    if (x_Current>=Data_Reserved)
+        Data_Reserve(x_Current);
+
+    // Attributes are read in a single pass
+    const char* pkt_pts_time=NULL;
+    const char* pkt_dts_time=NULL;
+    for (size_t Pos=0; Pos<Frame.Attributes_Count(); Pos++)
+    {
+        const char* Name=Frame.Attribute_Name(Pos);
+        const char* Value=Frame.Attribute_Value(Pos);
+        if (!strcmp(Name, "stream_index"))
+            streamIndex=std::atoi(Value);
+        else if (!strcmp(Name, "pkt_duration_time"))
+            durations[x_Current]=std::atof(Value);
+        else if (!strcmp(Name, "key_frame"))
+            key_frames[x_Current]=std::atof(Value)?true:false;
+        else if (!strcmp(Name, "pkt_pos"))
+            pkt_pos[x_Current]=std::atoll(Value);
+        else if (!strcmp(Name, "pkt_size"))
+            pkt_size[x_Current]=std::atoi(Value);
+        else if (!strcmp(Name, "pkt_pts"))
+            pkt_pts[x_Current]=std::atoll(Value);
+        else if (!strcmp(Name, "pkt_pts_time"))
+            pkt_pts_time=Value;
+        else if (!strcmp(Name, "pkt_dts_time"))
+            pkt_dts_time=Value;
+    }
+
+    const char* TimeStamp_String=pkt_pts_time;
+    if (!TimeStamp_String || !strcmp(TimeStamp_String, "N/A"))
+        TimeStamp_String=pkt_dts_time;
+    if (TimeStamp_String && strcmp(TimeStamp_String, "N/A"))
+    {
+        double TimeStamp=std::atof(TimeStamp_String);
+        if (TimeStamp<FirstTimeStamp)
+            FirstTimeStamp=TimeStamp; // Previous frames are relative to the new origin too
+        x.Set(x_Current, TimeStamp);
+    }
+}
+
+//---------------------------------------------------------------------------
+void CommonStats::StatsFromExternalData_Tag(const char* Key, const char* Value)
+{
+    if (!Key)
+        return;
+    if (!Value)
+        Value="";
+
+    const KeyEntry* Entry=Key_Find(Key);
+    if (Entry && Entry->Item<CountOfItems)
+    {
+        size_t j=Entry->Item;
+        double Item_Value=std::atof(Value);
+
+        // Special cases: crop: x2, y2, w, h
+        if (ExternalData_Width && Item_Transforms[j]==ItemTransform_WidthMinus)
+            Item_Value=ExternalData_Width-Item_Value;
+        else if (ExternalData_Height && Item_Transforms[j]==ItemTransform_HeightMinus)
+            Item_Value=ExternalData_Height-Item_Value;
+
+        Item_Set(j, Item_Value);
+    }
+    else if (Entry && ExternalData_StatsMapInitialized)
+        additionalStats_Set(Entry->Info, Value);
+    else
+        processAdditionalStats(Key, Value, ExternalData_StatsMapInitialized);
+}
+
+//---------------------------------------------------------------------------
+void CommonStats::StatsFromExternalData_FrameEnd()
+{
+    if (!ExternalData_StatsMapInitialized)
+    {
+        initializeAdditionalStats();
+        ExternalData_StatsMapInitialized=true;
+    }
+
+    if (x_Max[0]<=x[0][x_Current])
+    {
+        x_Max[0]=x[0][x_Current];
+        x_Max[1]=x[1][x_Current];
+        x_Max[2]=x[2][x_Current];
+        x_Max[3]=x[3][x_Current];
+    }
+
+    x_Current++;
+    if (x_Current_Max<=x_Current)
+        x_Current_Max=x_Current;
+}
+
 //***************************************************************************
 // Stats
 //***************************************************************************
@@ -399,124 +533,513 @@ string CommonStats::Percent_Get(size_t Pos)
 }
 
 //***************************************************************************
-// Memory management
+// Metadata keys
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-void CommonStats::Data_Reserve(size_t NewValue)
+uint32_t CommonStats::Key_Hash(const char* Key)
 {
-    // Saving old data
-    size_t                      Data_Reserved_Old = Data_Reserved;
-    double**                    x_Old = x;
-    double**                    y_Old = y;
-    double*                     durations_Old = durations;
-    bool*                       key_frames_Old = key_frames;
-    int64_t*                    pkt_pos_Old = pkt_pos;
-    int64_t*                    pkt_pts_Old = pkt_pts;
-    int*                        pkt_size_Old = pkt_size;
-    int*                        pix_fmt_Old = pix_fmt;
-    char*                       pict_type_char_Old = pict_type_char;
-    char**                      comments_Old = comments;
-
-    auto                        additionalIntStats_Old = additionalIntStats;
-    auto                        additionalDoubleStats_Old = additionalDoubleStats;
-    auto                        additionalStringStats_Old = additionalStringStats;
-
-    // Computing new value
-    while (Data_Reserved < NewValue + (1 << 18)) //We reserve extra space, minimum 2^18 frames added
-        Data_Reserved <<= 1;
-
-    size_t diff = Data_Reserved - Data_Reserved_Old;
-
-    // Creating new data - x and y
-    x = new double*[4];
-    for (size_t j = 0; j < 4; ++j)
+    // FNV-1a
+    uint32_t Hash=2166136261u;
+    for (; *Key; Key++)
     {
-        x[j] = new double[Data_Reserved];
-        memcpy(x[j], x_Old[j], Data_Reserved_Old * sizeof(double));
-        memset(&x[j][Data_Reserved_Old], 0x00, diff * sizeof(double));
-        delete[] x_Old[j];
+        Hash^=(unsigned char)*Key;
+        Hash*=16777619u;
     }
+    return Hash;
+}
 
-    y = new double*[CountOfItems];
-    for (size_t j = 0; j < CountOfItems; ++j)
+//---------------------------------------------------------------------------
+void CommonStats::Key_Insert(const string& Key, size_t Item, const StatsValueInfo& Info)
+{
+    if (Key_Find(Key.c_str()))
+        return;
+
+    // Keeping the table at most half full
+    if ((Keys_Count+1)*2>Keys.size())
     {
-        y[j] = new double[Data_Reserved];
-        memcpy(y[j], y_Old[j], Data_Reserved_Old * sizeof(double));
-        memset(&y[j][Data_Reserved_Old], 0x00, diff * sizeof(double));
-        delete[] y_Old[j];
+        vector<KeyEntry> Keys_Old;
+        Keys_Old.swap(Keys);
+        Keys.resize(Keys_Old.empty()?64:(Keys_Old.size()*2));
+        Keys_Count=0;
+        for (size_t Pos=0; Pos<Keys_Old.size(); Pos++)
+            if (!Keys_Old[Pos].Key.empty())
+                Key_Insert(Keys_Old[Pos].Key, Keys_Old[Pos].Item, Keys_Old[Pos].Info);
     }
 
-    // Creating new data - Extra
-    durations = new double[Data_Reserved];
-    memcpy(durations, durations_Old, Data_Reserved_Old * sizeof(double));
-    memset(&durations[Data_Reserved_Old], 0x00, diff * sizeof(double));
+    uint32_t Hash=Key_Hash(Key.c_str());
+    size_t Mask=Keys.size()-1;
+    size_t Pos=Hash&Mask;
+    while (!Keys[Pos].Key.empty())
+        Pos=(Pos+1)&Mask;
+
+    Keys[Pos].Hash=Hash;
+    Keys[Pos].Key=Key;
+    Keys[Pos].Item=Item;
+    Keys[Pos].Info=Info;
+    Keys_Count++;
+}
 
-    key_frames = new bool[Data_Reserved];
-    memcpy(key_frames, key_frames_Old, Data_Reserved_Old * sizeof(bool));
-    memset(&key_frames[Data_Reserved_Old], 0x00, diff * sizeof(bool));
+//---------------------------------------------------------------------------
+const CommonStats::KeyEntry* CommonStats::Key_Find(const char* Key) const
+{
+    if (Keys.empty())
+        return NULL;
 
-    pkt_pos = new int64_t[Data_Reserved];
-    memcpy(pkt_pos, pkt_pos_Old, Data_Reserved_Old * sizeof(int64_t));
-    memset(&pkt_pos[Data_Reserved_Old], 0x00, diff * sizeof(int64_t));
+    uint32_t Hash=Key_Hash(Key);
+    size_t Mask=Keys.size()-1;
+    for (size_t Pos=Hash&Mask; !Keys[Pos].Key.empty(); Pos=(Pos+1)&Mask)
+        if (Keys[Pos].Hash==Hash && Keys[Pos].Key==Key)
+            return &Keys[Pos];
 
-    pkt_pts = new int64_t[Data_Reserved];
-    memcpy(pkt_pts, pkt_pts_Old, Data_Reserved_Old * sizeof(int64_t));
-    memset(&pkt_pts[Data_Reserved_Old], 0x00, diff * sizeof(int64_t));
+    return NULL;
+}
 
-    pkt_size = new int[Data_Reserved];
-    memcpy(pkt_size, pkt_size_Old, Data_Reserved_Old * sizeof(int));
-    memset(&pkt_size[Data_Reserved_Old], 0x00, diff * sizeof(int));
+//---------------------------------------------------------------------------
+void CommonStats::Item_Set(size_t Item, size_t Pos, double Value)
+{
+    y[Item][Pos]=Value;
+    Value=y[Item][Pos]; // As stored
+
+    const per_item& Info=PerItem[Item];
+    if (Info.Group1!=CountOfGroups && y_Max[Info.Group1]<Value)
+        y_Max[Info.Group1]=Value;
+    if (Info.Group2!=CountOfGroups && y_Max[Info.Group2]<Value)
+        y_Max[Info.Group2]=Value;
+    if (Info.Group1!=CountOfGroups && y_Min[Info.Group1]>Value)
+        y_Min[Info.Group1]=Value;
+    if (Info.Group2!=CountOfGroups && y_Min[Info.Group2]>Value)
+        y_Min[Info.Group2]=Value;
+
+    //Stats
+    Stats_Totals[Item]+=Value;
+    if (Info.DefaultLimit!=DBL_MAX)
+    {
+        if (Value>Info.DefaultLimit)
+            Stats_Counts[Item]++;
+        if (Info.DefaultLimit2!=DBL_MAX && Value>Info.DefaultLimit2)
+            Stats_Counts2[Item]++;
+    }
+}
 
-    pix_fmt = new int[Data_Reserved];
-    memcpy(pix_fmt, pix_fmt_Old, Data_Reserved_Old * sizeof(int));
-    memset(&pix_fmt[Data_Reserved_Old], 0x00, diff * sizeof(int));
+//---------------------------------------------------------------------------
+void CommonStats::additionalStats_Set(const StatsValueInfo& Info, const char* Value)
+{
+    switch (Info.type)
+    {
+        case StatsValueInfo::Int    :   additionalIntStats[Info.index][x_Current] = std::atoi(Value); break;
+        case StatsValueInfo::Double :   additionalDoubleStats[Info.index][x_Current] = std::atof(Value); break;
+        default                     :   free(additionalStringStats[Info.index][x_Current]);
+                                        additionalStringStats[Info.index][x_Current] = strdup(Value);
+    }
+}
 
-    pict_type_char = new char[Data_Reserved];
-    memcpy(pict_type_char, pict_type_char_Old, Data_Reserved_Old * sizeof(char));
-    memset(&pict_type_char[Data_Reserved_Old], 0x00, diff * sizeof(char));
+//***************************************************************************
+// Segments
+//***************************************************************************
 
-    comments = new char*[Data_Reserved];
-    memcpy(comments, comments_Old, Data_Reserved_Old * sizeof(char*));
-    memset(&comments[Data_Reserved_Old], 0x00, diff * sizeof(char*));
+//---------------------------------------------------------------------------
+void CommonStats::Data_Append(const CommonStats& Segment)
+{
+    size_t Count=Segment.x_Current;
+    if (!Count || Segment.CountOfItems!=CountOfItems)
+        return;
+    if (x_Current+Count>=Data_Reserved)
+        Data_Reserve(x_Current+Count);
+
+    // Time stamps are stored as is, only the origin may change
+    if (Segment.FirstTimeStamp<FirstTimeStamp)
+        FirstTimeStamp=Segment.FirstTimeStamp;
+    x.Copy(x_Current, Segment.x, Count);
+
+    // Data
+    for (size_t j=0; j<CountOfItems; ++j)
+        y[j].Copy(x_Current, Segment.y[j], Count);
+    durations.Copy(x_Current, Segment.durations, Count);
+    key_frames.Copy(x_Current, Segment.key_frames, Count);
+    gaps.Copy(x_Current, Segment.gaps, Count);
+    pkt_pos.Copy(x_Current, Segment.pkt_pos, Count);
+    pkt_pts.Copy(x_Current, Segment.pkt_pts, Count);
+    pkt_size.Copy(x_Current, Segment.pkt_size, Count);
+    pix_fmt.Copy(x_Current, Segment.pix_fmt, Count);
+    pict_type_char.Copy(x_Current, Segment.pict_type_char, Count);
+    for (size_t Pos=0; Pos<Count; Pos++)
+        if (Segment.comments[Pos])
+            comments[x_Current+Pos]=strdup(Segment.comments[Pos]);
+
+    // Additional stats, keys are not in the same order if the first frames differ
+    if (statsValueInfoByKeys.empty() && !Segment.statsValueInfoByKeys.empty())
+    {
+        memcpy(lastStatsIndexByValueType, Segment.lastStatsIndexByValueType, sizeof(lastStatsIndexByValueType));
+        statsValueInfoByKeys=Segment.statsValueInfoByKeys;
+        for (size_t Type=0; Type<3; Type++)
+            statsKeysByIndexByValueType[Type]=Segment.statsKeysByIndexByValueType[Type];
+        delete[] additionalIntStats;
+        delete[] additionalDoubleStats;
+        delete[] additionalStringStats;
+        additionalIntStats=nullptr;
+        additionalDoubleStats=nullptr;
+        additionalStringStats=nullptr;
+        initializeAdditionalStats();
+    }
+    for (auto& Entry : Segment.statsValueInfoByKeys)
+    {
+        auto Info=statsValueInfoByKeys.find(Entry.first);
+        if (Info==statsValueInfoByKeys.end() || Info->second.type!=Entry.second.type)
+            continue;
 
-    auto numberOfIntValues = lastStatsIndexByValueType[StatsValueInfo::Int];
-    additionalIntStats = new int*[numberOfIntValues];
-    for (size_t j = 0; j < numberOfIntValues; ++j)
+        size_t Index=Info->second.index;
+        size_t Segment_Index=Entry.second.index;
+        switch (Entry.second.type)
+        {
+            case StatsValueInfo::Int    :   additionalIntStats[Index].Copy(x_Current, Segment.additionalIntStats[Segment_Index], Count); break;
+            case StatsValueInfo::Double :   additionalDoubleStats[Index].Copy(x_Current, Segment.additionalDoubleStats[Segment_Index], Count); break;
+            default                     :   for (size_t Pos=0; Pos<Count; Pos++)
+                                            {
+                                                free(additionalStringStats[Index][x_Current+Pos]);
+                                                additionalStringStats[Index][x_Current+Pos]=Segment.additionalStringStats[Segment_Index][Pos]?strdup(Segment.additionalStringStats[Segment_Index][Pos]):NULL;
+                                            }
+        }
+    }
+
+    // Counts
+    for (size_t j=0; j<CountOfItems; ++j)
+    {
+        Stats_Totals[j]+=Segment.Stats_Totals[j];
+        Stats_Counts[j]+=Segment.Stats_Counts[j];
+        Stats_Counts2[j]+=Segment.Stats_Counts2[j];
+    }
+    for (size_t j=0; j<CountOfGroups; ++j)
     {
-        additionalIntStats[j] = new int[Data_Reserved];
-        memcpy(additionalIntStats[j], additionalIntStats_Old[j], Data_Reserved_Old * sizeof(int));
-        memset(&additionalIntStats[j][Data_Reserved_Old], 0x00, diff * sizeof(int));
-        delete[] additionalIntStats_Old[j];
+        if (y_Min[j]>Segment.y_Min[j])
+            y_Min[j]=Segment.y_Min[j];
+        if (y_Max[j]<Segment.y_Max[j])
+            y_Max[j]=Segment.y_Max[j];
     }
 
-    auto numberOfDoubleValues = lastStatsIndexByValueType[StatsValueInfo::Double];
-    additionalDoubleStats = new double*[numberOfDoubleValues];
-    for (size_t j = 0; j < numberOfDoubleValues; ++j)
+    x_Current+=Count;
+    if (x_Current_Max<=x_Current)
+        x_Current_Max=x_Current;
+    if (x_Max[0]<=x[0][x_Current-1])
     {
-        additionalDoubleStats[j] = new double[Data_Reserved];
-        memcpy(additionalDoubleStats[j], additionalDoubleStats_Old[j], Data_Reserved_Old * sizeof(double));
-        memset(&additionalDoubleStats[j][Data_Reserved_Old], 0x00, diff * sizeof(double));
-        delete[] additionalDoubleStats_Old[j];
+        x_Max[0]=x[0][x_Current-1];
+        x_Max[1]=x[1][x_Current-1];
+        x_Max[2]=x[2][x_Current-1];
+        x_Max[3]=x[3][x_Current-1];
     }
+}
 
-    auto numberOfStringValues = lastStatsIndexByValueType[StatsValueInfo::String];
-    additionalStringStats = new char**[numberOfStringValues];
-    for (size_t j = 0; j < numberOfStringValues; ++j)
+//***************************************************************************
+// Binary sidecar
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+template<typename T, typename F>
+static void Binary_Column_Add(StatsBinaryWriter& Writer, uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, size_t Start, size_t End, F Get)
+{
+    StatsBinaryBuffer Buffer;
+    Buffer.Data.reserve((End-Start)*sizeof(T));
+    for (size_t Pos=Start; Pos<End; Pos++)
+        Buffer.Put<T>(Get(Pos));
+    Writer.Block_Add(Kind, Stream, Item, Chunk, Buffer.Data);
+}
+
+//---------------------------------------------------------------------------
+template<typename T, typename F>
+static bool Binary_Column_Get(const StatsBinaryReader& Reader, uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, size_t Start, size_t End, F Set)
+{
+    string Raw;
+    if (!Reader.Block_Get(Kind, Stream, Item, Chunk, Raw) || Raw.size()!=(End-Start)*sizeof(T))
+        return false;
+
+    StatsBinaryCursor Cursor(Raw);
+    for (size_t Pos=Start; Pos<End; Pos++)
+        Set(Pos, Cursor.Get<T>());
+    return true;
+}
+
+//---------------------------------------------------------------------------
+static void Binary_Strings_Add(StatsBinaryWriter& Writer, uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, size_t Start, size_t End, const StatsColumn<char*>& Column)
+{
+    StatsBinaryBuffer Buffer;
+    for (size_t Pos=Start; Pos<End; Pos++)
+        Buffer.Put_String(Column[Pos]);
+    Writer.Block_Add(Kind, Stream, Item, Chunk, Buffer.Data);
+}
+
+//---------------------------------------------------------------------------
+static bool Binary_Strings_Get(const StatsBinaryReader& Reader, uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, size_t Start, size_t End, StatsColumn<char*>& Column)
+{
+    string Raw;
+    if (!Reader.Block_Get(Kind, Stream, Item, Chunk, Raw))
+        return false;
+
+    StatsBinaryCursor Cursor(Raw);
+    string Value;
+    bool IsNull;
+    for (size_t Pos=Start; Pos<End; Pos++)
+    {
+        if (!Cursor.Get_String(Value, IsNull))
+            return false;
+        free(Column[Pos]);
+        Column[Pos]=IsNull?NULL:strdup(Value.c_str());
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void CommonStats::StatsToBinary(StatsBinaryWriter& Writer, uint32_t Stream, size_t x_Begin, size_t x_End) const
+{
+    if (x_End>x_Current)
+        x_End=x_Current;
+    if (x_Begin>x_End)
+        x_Begin=x_End;
+
+    // Info, items are listed by name so files stay readable if the list of items changes
+    StatsBinaryBuffer Info;
+    Info.Put<int32_t>(Type);
+    Info.Put<uint64_t>(x_End-x_Begin);
+    Info.Put<int32_t>(streamIndex);
+    Info.Put<double>(Frequency);
+    Info.Put<double>(FirstTimeStamp);
+    Info.Put<uint32_t>((uint32_t)CountOfItems);
+    for (size_t j=0; j<CountOfItems; ++j)
+    {
+        Info.Put_String(PerItem[j].FFmpeg_Name);
+        Info.Put<uint8_t>((uint8_t)y[j].Encoding_Get());
+    }
+    Writer.Block_Add(StatsBinary_Info, Stream, 0, 0, Info.Data);
+
+    // Additional stats
+    StatsBinaryBuffer Keys;
+    Keys.Put<uint32_t>((uint32_t)statsValueInfoByKeys.size());
+    for (auto& Entry : statsValueInfoByKeys)
+    {
+        Keys.Put_String(Entry.first.c_str());
+        Keys.Put<uint8_t>((uint8_t)Entry.second.type);
+        Keys.Put<uint32_t>((uint32_t)Entry.second.index);
+        Keys.Put_String(Entry.second.initialValue.c_str());
+    }
+    Writer.Block_Add(StatsBinary_AdditionalKeys, Stream, 0, 0, Keys.Data);
+
+    // Per frame, by ranges of frames
+    size_t ChunkFrames=Writer.ChunkFrames_Get();
+    for (size_t Start=x_Begin, Chunk=0; Start<x_End; Start+=ChunkFrames, Chunk++)
     {
-        additionalStringStats[j] = new char*[Data_Reserved];
-        memcpy(additionalStringStats[j], additionalStringStats_Old[j], Data_Reserved_Old * sizeof(char*));
-        memset(&additionalStringStats[j][Data_Reserved_Old], 0x00, diff * sizeof(char*));
-        delete[] additionalStringStats_Old[j];
-    }
-
-    delete[] x_Old;
-    delete[] y_Old;
-    delete[] durations_Old;
-    delete[] key_frames_Old;
-    delete[] pkt_pos_Old;
-    delete[] pkt_size_Old;
-    delete[] pix_fmt_Old;
-    delete[] pict_type_char_Old;
-    delete[] comments_Old;
+        size_t End=std::min(Start+ChunkFrames, x_End);
+
+        Binary_Column_Add<double>(Writer, StatsBinary_TimeStamps, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return x.IsSet(Pos)?x.TimeStamp(Pos):NAN;});
+        Binary_Column_Add<double>(Writer, StatsBinary_Durations, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return durations[Pos];});
+        Binary_Column_Add<uint8_t>(Writer, StatsBinary_KeyFrames, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return key_frames.Get(Pos)?1:0;});
+        Binary_Column_Add<int64_t>(Writer, StatsBinary_PktPos, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return pkt_pos[Pos];});
+        Binary_Column_Add<int64_t>(Writer, StatsBinary_PktPts, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return pkt_pts[Pos];});
+        Binary_Column_Add<int32_t>(Writer, StatsBinary_PktSize, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return pkt_size[Pos];});
+        Binary_Column_Add<int32_t>(Writer, StatsBinary_PixFmt, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return pix_fmt[Pos];});
+        Binary_Column_Add<char>(Writer, StatsBinary_PictType, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return pict_type_char[Pos];});
+        Binary_Strings_Add(Writer, StatsBinary_Comments, Stream, 0, Chunk, Start, End, comments);
+        Binary_Column_Add<uint8_t>(Writer, StatsBinary_Gaps, Stream, 0, Chunk, Start, End, [&](size_t Pos) {return gaps.Get(Pos)?1:0;});
+
+        // Values with their storage type
+        for (size_t j=0; j<CountOfItems; ++j)
+        {
+            const StatsValueColumn& Values=y[j];
+            switch (Values.Encoding_Get())
+            {
+                case StatsEncoding_UInt16   : Binary_Column_Add<uint16_t>(Writer, StatsBinary_Item, Stream, j, Chunk, Start, End, [&](size_t Pos) {return (uint16_t)Values.Get(Pos);}); break;
+                case StatsEncoding_Int32    : Binary_Column_Add<int32_t>(Writer, StatsBinary_Item, Stream, j, Chunk, Start, End, [&](size_t Pos) {return (int32_t)Values.Get(Pos);}); break;
+                case StatsEncoding_Float    :
+                case StatsEncoding_Delta    : Binary_Column_Add<float>(Writer, StatsBinary_Item, Stream, j, Chunk, Start, End, [&](size_t Pos) {return (float)Values.Get(Pos);}); break;
+                default                     : Binary_Column_Add<double>(Writer, StatsBinary_Item, Stream, j, Chunk, Start, End, [&](size_t Pos) {return Values.Get(Pos);});
+            }
+        }
+
+        if (additionalIntStats)
+            for (size_t j=0; j<lastStatsIndexByValueType[StatsValueInfo::Int]; ++j)
+                Binary_Column_Add<int32_t>(Writer, StatsBinary_AdditionalInt, Stream, j, Chunk, Start, End, [&](size_t Pos) {return additionalIntStats[j][Pos];});
+        if (additionalDoubleStats)
+            for (size_t j=0; j<lastStatsIndexByValueType[StatsValueInfo::Double]; ++j)
+                Binary_Column_Add<double>(Writer, StatsBinary_AdditionalDouble, Stream, j, Chunk, Start, End, [&](size_t Pos) {return additionalDoubleStats[j][Pos];});
+        if (additionalStringStats)
+            for (size_t j=0; j<lastStatsIndexByValueType[StatsValueInfo::String]; ++j)
+                Binary_Strings_Add(Writer, StatsBinary_AdditionalString, Stream, j, Chunk, Start, End, additionalStringStats[j]);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool CommonStats::StatsFromBinary(const StatsBinaryReader& Reader, uint32_t Stream)
+{
+    // Info
+    string Raw;
+    if (!Reader.Block_Get(StatsBinary_Info, Stream, 0, 0, Raw))
+        return false;
+    StatsBinaryCursor Info(Raw);
+    if (Info.Get<int32_t>()!=Type)
+        return false;
+    uint64_t Count_Stored=Info.Get<uint64_t>();
+    streamIndex=Info.Get<int32_t>();
+    Frequency=Info.Get<double>();
+    FirstTimeStamp=Info.Get<double>();
+    uint32_t Items_Count=Info.Get<uint32_t>();
+    if (!Info.IsOk() || !Reader.FrameCount_IsValid(Stream, Count_Stored) || Items_Count>Raw.size()/5) // Each item has at least a name size and an encoding
+        return false;
+    size_t Count=(size_t)Count_Stored;
+    vector<size_t> Items(Items_Count, CountOfItems); // Item of this version for each stored item, CountOfItems if unknown
+    vector<statsencoding> Items_Encoding(Items.size());
+    for (size_t i=0; i<Items.size(); i++)
+    {
+        string Name;
+        bool IsNull;
+        Info.Get_String(Name, IsNull);
+        Items_Encoding[i]=(statsencoding)Info.Get<uint8_t>();
+        const KeyEntry* Entry=Key_Find(Name.c_str());
+        if (Entry && Entry->Item<CountOfItems)
+            Items[i]=Entry->Item;
+    }
+    if (!Info.IsOk())
+        return false;
+
+    // Additional stats
+    if (Reader.Block_Get(StatsBinary_AdditionalKeys, Stream, 0, 0, Raw))
+    {
+        StatsBinaryCursor Keys(Raw);
+        uint32_t Keys_Count=Keys.Get<uint32_t>();
+        if (Keys_Count>Raw.size()/13) // Each key has at least 2 string sizes, a type and an index
+            return false;
+        for (uint32_t i=0; i<Keys_Count; i++)
+        {
+            string Key;
+            bool IsNull;
+            StatsValueInfo Value;
+            Keys.Get_String(Key, IsNull);
+            Value.type=(StatsValueInfo::Type)Keys.Get<uint8_t>();
+            Value.index=Keys.Get<uint32_t>();
+            Keys.Get_String(Value.initialValue, IsNull);
+            if (!Keys.IsOk() || Value.type>StatsValueInfo::String || Value.index>=Keys_Count) // Index is used for allocating the columns
+                return false;
+
+            statsValueInfoByKeys[Key]=Value;
+            statsKeysByIndexByValueType[Value.type][Value.index]=Key;
+            if (lastStatsIndexByValueType[Value.type]<=Value.index)
+                lastStatsIndexByValueType[Value.type]=Value.index+1;
+        }
+    }
+
+    Data_Reserve(Count);
+    if (!statsValueInfoByKeys.empty())
+        initializeAdditionalStats();
+
+    // Per frame, by ranges of frames
+    size_t ChunkFrames=Reader.ChunkFrames_Get();
+    for (size_t Start=0, Chunk=0; Start<Count; Start+=ChunkFrames, Chunk++)
+    {
+        size_t End=std::min(Start+ChunkFrames, Count);
+        bool IsOk=true;
+
+        IsOk&=Binary_Column_Get<double>(Reader, StatsBinary_TimeStamps, Stream, 0, Chunk, Start, End, [&](size_t Pos, double Value) {if (!std::isnan(Value)) x.Set(Pos, Value);});
+        IsOk&=Binary_Column_Get<double>(Reader, StatsBinary_Durations, Stream, 0, Chunk, Start, End, [&](size_t Pos, double Value) {durations[Pos]=Value;});
+        IsOk&=Binary_Column_Get<uint8_t>(Reader, StatsBinary_KeyFrames, Stream, 0, Chunk, Start, End, [&](size_t Pos, uint8_t Value) {key_frames.Set(Pos, Value?true:false);});
+        IsOk&=Binary_Column_Get<int64_t>(Reader, StatsBinary_PktPos, Stream, 0, Chunk, Start, End, [&](size_t Pos, int64_t Value) {pkt_pos[Pos]=Value;});
+        IsOk&=Binary_Column_Get<int64_t>(Reader, StatsBinary_PktPts, Stream, 0, Chunk, Start, End, [&](size_t Pos, int64_t Value) {pkt_pts[Pos]=Value;});
+        IsOk&=Binary_Column_Get<int32_t>(Reader, StatsBinary_PktSize, Stream, 0, Chunk, Start, End, [&](size_t Pos, int32_t Value) {pkt_size[Pos]=Value;});
+        IsOk&=Binary_Column_Get<int32_t>(Reader, StatsBinary_PixFmt, Stream, 0, Chunk, Start, End, [&](size_t Pos, int32_t Value) {pix_fmt[Pos]=Value;});
+        IsOk&=Binary_Column_Get<char>(Reader, StatsBinary_PictType, Stream, 0, Chunk, Start, End, [&](size_t Pos, char Value) {pict_type_char[Pos]=Value;});
+        IsOk&=Binary_Strings_Get(Reader, StatsBinary_Comments, Stream, 0, Chunk, Start, End, comments);
+        Binary_Column_Get<uint8_t>(Reader, StatsBinary_Gaps, Stream, 0, Chunk, Start, End, [&](size_t Pos, uint8_t Value) {gaps.Set(Pos, Value?true:false);}); // Not in files written before gaps were stored
+
+        // Values, minimums, maximums and counts are computed again
+        for (size_t i=0; i<Items.size(); i++)
+        {
+            size_t j=Items[i];
+            if (j>=CountOfItems)
+                continue;
+            auto Set=[&](size_t Pos, double Value) {Item_Set(j, Pos, Value);};
+            switch (Items_Encoding[i])
+            {
+                case StatsEncoding_UInt16   : IsOk&=Binary_Column_Get<uint16_t>(Reader, StatsBinary_Item, Stream, i, Chunk, Start, End, Set); break;
+                case StatsEncoding_Int32    : IsOk&=Binary_Column_Get<int32_t>(Reader, StatsBinary_Item, Stream, i, Chunk, Start, End, Set); break;
+                case StatsEncoding_Float    :
+                case StatsEncoding_Delta    : IsOk&=Binary_Column_Get<float>(Reader, StatsBinary_Item, Stream, i, Chunk, Start, End, Set); break;
+                default                     : IsOk&=Binary_Column_Get<double>(Reader, StatsBinary_Item, Stream, i, Chunk, Start, End, Set);
+            }
+        }
+
+        if (additionalIntStats)
+            for (size_t j=0; j<lastStatsIndexByValueType[StatsValueInfo::Int]; ++j)
+                IsOk&=Binary_Column_Get<int32_t>(Reader, StatsBinary_AdditionalInt, Stream, j, Chunk, Start, End, [&](size_t Pos, int32_t Value) {additionalIntStats[j][Pos]=Value;});
+        if (additionalDoubleStats)
+            for (size_t j=0; j<lastStatsIndexByValueType[StatsValueInfo::Double]; ++j)
+                IsOk&=Binary_Column_Get<double>(Reader, StatsBinary_AdditionalDouble, Stream, j, Chunk, Start, End, [&](size_t Pos, double Value) {additionalDoubleStats[j][Pos]=Value;});
+        if (additionalStringStats)
+            for (size_t j=0; j<lastStatsIndexByValueType[StatsValueInfo::String]; ++j)
+                IsOk&=Binary_Strings_Get(Reader, StatsBinary_AdditionalString, Stream, j, Chunk, Start, End, additionalStringStats[j]);
+
+        if (!IsOk)
+            return false;
+    }
+
+    x_Current=Count;
+    StatsFinish();
+    return true;
+}
+
+//***************************************************************************
+// Memory management
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+statsencoding CommonStats::Data_Encoding(size_t Item) const
+{
+    if (Lossless)
+        return StatsEncoding_Double;
+
+    const char* Name=PerItem[Item].FFmpeg_Name;
+
+    // Sample values (up to 16-bit), averages are not integers
+    if (!strncmp(Name, "lavfi.signalstats.", 18) && !PerItem[Item].DigitsAfterComma && !StatsValueInfo::endsWith(Name, "AVG"))
+        return StatsEncoding_UInt16;
+
+    // Positions and sizes, idet values are not counts (half_life is used)
+    if ((!strncmp(Name, "lavfi.cropdetect.", 17) || !strcmp(Name, "pkt_size")) && !PerItem[Item].DigitsAfterComma)
+        return StatsEncoding_Int32;
+
+    // Other values, including fractional ones, are exported with 6 digits after the comma, more than a float keeps
+    return StatsEncoding_Double;
+}
+
+//---------------------------------------------------------------------------
+void CommonStats::Data_Reserve(size_t NewValue)
+{
+    // Adding chunks, existing data stays in place
+    size_t Count=NewValue+1;
+
+    x.Reserve(Count);
+    for (size_t j = 0; j < CountOfItems; ++j)
+        y[j].Reserve(Count);
+
+    durations.Reserve(Count);
+    key_frames.Reserve(Count);
+    gaps.Reserve(Count);
+    pkt_pos.Reserve(Count);
+    pkt_pts.Reserve(Count);
+    pkt_size.Reserve(Count);
+    pix_fmt.Reserve(Count);
+    pict_type_char.Reserve(Count);
+    comments.Reserve(Count);
+
+    auto numberOfIntValues = lastStatsIndexByValueType[StatsValueInfo::Int];
+    if (additionalIntStats)
+        for (size_t j = 0; j < numberOfIntValues; ++j)
+            additionalIntStats[j].Reserve(Count);
+
+    auto numberOfDoubleValues = lastStatsIndexByValueType[StatsValueInfo::Double];
+    if (additionalDoubleStats)
+        for (size_t j = 0; j < numberOfDoubleValues; ++j)
+            additionalDoubleStats[j].Reserve(Count);
+
+    auto numberOfStringValues = lastStatsIndexByValueType[StatsValueInfo::String];
+    if (additionalStringStats)
+        for (size_t j = 0; j < numberOfStringValues; ++j)
+            additionalStringStats[j].Reserve(Count);
+
+    Data_Reserved = durations.Reserved();
 }
@@ -16,12 +16,18 @@
 #include <algorithm>
 #include <cctype>
 #include <Core/Core.h>
+#include <Core/StatsColumn.h>
 
 using namespace std;
 
 struct AVFrame;
+struct AVPacket;
 struct AVStream;
 struct per_item;
+class StatsBinaryWriter;
+class StatsBinaryReader;
+class XmlPullParser;
+class StatsXmlBuffer;
 
 class CommonStats
 {
@@ -31,22 +37,30 @@ public:
     virtual ~CommonStats();
 
     // Data
-    double**                    x;                          // Time information, per frame (0=frame number, 1=seconds, 2=minutes, 3=hours)
-    double**                    y;                          // Data (Group_xxxMax size)
-    double*                     durations;                  // Duration of a frame, per frame
-    int64_t*					pkt_pos;                    // Frame offsets
-    int64_t*                    pkt_pts;                    // pkt_pts
-    int*                        pkt_size;                   // Frame size
-    int*                        pix_fmt;                    //
-    char*                       pict_type_char;             //
-    bool*                       key_frames;                 // Key frame status, per frame
+    StatsTimeAxis               x;                          // Time information, per frame (0=frame number, 1=seconds, 2=minutes, 3=hours), relative to FirstTimeStamp
+    StatsValueColumn*           y;                          // Data (Group_xxxMax size)
+    StatsColumn<double>         durations;                  // Duration of a frame, per frame
+    StatsColumn<int64_t>        pkt_pos;                    // Frame offsets
+    StatsColumn<int64_t>        pkt_pts;                    // pkt_pts
+    StatsColumn<int>            pkt_size;                   // Frame size
+    StatsColumn<int>            pix_fmt;                    //
+    StatsColumn<char>           pict_type_char;             //
+    StatsFlagColumn             key_frames;                 // Key frame status, per frame
+    StatsFlagColumn             gaps;                       // Frames before this one are not analyzed (sampled analysis), per frame
     size_t                      x_Current;                  // Data is filled up to
     size_t                      x_Current_Max;              // Data will be filled up to
     double                      x_Max[4];                   // Maximum x by plot
     double*                     y_Min;                      // Minimum y by plot
     double*                     y_Max;                      // Maximum y by plot
     double                      FirstTimeStamp;             // Time stamp of the first frame
-    char**                      comments;                   // Comments per frame (utf-8)
+    StatsColumn<char*>          comments;                   // Comments per frame (utf-8)
+
+    // Storage
+    static void                 Lossless_Set(bool Value) {Lossless=Value;} // Full precision for all per frame values, else integer values use compact types (16-bit...)
+    static bool                 Lossless_Get() {return Lossless;}
+
+    // Sampling
+    void                        Sampled_Set(bool Value) {Sampled=Value;} // Only some frames are analyzed, gaps are detected from the time stamps
 
     // Status
     int                         Type_Get();
@@ -60,12 +74,24 @@ public:
     string                      Percent_Get(size_t Pos);
 
     // External data
-    virtual void                StatsFromExternalData(const char* Data, size_t Size) = 0;
+    virtual void                StatsFromExternalData_Frame(const XmlPullParser& Frame); // <frame> element, its tags follow
+    virtual void                StatsFromExternalData_Tag(const char* Key, const char* Value); // <tag> element of the current frame
+            void                StatsFromExternalData_FrameEnd();
             void                StatsFromExternalData_Finish() {Frequency=1; StatsFinish();}
     virtual void                StatsFromFrame(struct AVFrame* Frame, int Width, int Height) = 0;
     virtual void                TimeStampFromFrame(struct AVFrame* Frame, size_t FramePos) = 0;
+    virtual void                StatsFromPacket(struct AVPacket* Packet, int PixFmt) = 0; // Packet values only, the frame is not decoded
+            void                TimeStampFromPacket(struct AVPacket* Packet, size_t FramePos);
     virtual void                StatsFinish();
-    virtual string              StatsToXML(const activefilters& filters) = 0;
+    virtual void                StatsToXML(StatsXmlBuffer& Data, const activefilters& filters, size_t x_Begin=0, size_t x_End=(size_t)-1) = 0; // Frames from x_Begin to x_End (excluded) are appended
+
+    // Segments
+    virtual CommonStats*        Segment_Create(size_t FrameCount, double Duration) const = 0; // Empty stats of the same kind, for another part of the same stream
+            void                Data_Append(const CommonStats& Segment);
+
+    // Binary sidecar
+    virtual void                StatsToBinary(StatsBinaryWriter& Writer, uint32_t Stream, size_t x_Begin=0, size_t x_End=(size_t)-1) const; // Frames from x_Begin to x_End (excluded)
+    virtual bool                StatsFromBinary(const StatsBinaryReader& Reader, uint32_t Stream); // Stats must be empty
 
     struct StatsValueInfo {
         size_t index;
@@ -156,7 +182,7 @@ public:
 
     void initializeAdditionalStats();
     void processAdditionalStats(const char* key, const char* value, bool statsMapInitialized);
-    void writeAdditionalStats(std::stringstream& stream, size_t index);
+    void writeAdditionalStats(StatsXmlBuffer& Data, size_t index);
 
 protected:
     size_t lastStatsIndexByValueType[3];
@@ -165,6 +191,8 @@ protected:
 
     // Status
     bool                        IsComplete;
+    bool                        Sampled;
+    void                        Gap_Check(); // Current frame is after a gap if its time stamp is far from the end of the previous frame
 
     // Counts
     double*                     Stats_Totals;
@@ -175,9 +203,41 @@ protected:
     double                      Frequency;
     int							streamIndex;
 
+    // External data, current frame
+    bool                        ExternalData_StatsMapInitialized;
+    int                         ExternalData_Width;         // 0 if unknown
+    int                         ExternalData_Height;        // 0 if unknown
+
+    // Metadata keys, resolved with a hash table instead of comparing with each item name
+    enum itemtransform
+    {
+        ItemTransform_None,
+        ItemTransform_WidthMinus,                           // Width minus the value (crop x2, w)
+        ItemTransform_HeightMinus,                          // Height minus the value (crop y2, h)
+    };
+    struct KeyEntry
+    {
+        uint32_t                Hash;
+        string                  Key;                        // Empty if the slot is free
+        size_t                  Item;                       // Index in PerItem, CountOfItems for additional stats
+        StatsValueInfo          Info;                       // Additional stats only
+    };
+    vector<KeyEntry>            Keys;                       // Open addressing, size is a power of 2
+    size_t                      Keys_Count;
+    vector<itemtransform>       Item_Transforms;
+    static uint32_t             Key_Hash(const char* Key);
+    void                        Key_Insert(const string& Key, size_t Item, const StatsValueInfo& Info);
+    const KeyEntry*             Key_Find(const char* Key) const;
+    void                        Item_Set(size_t Item, size_t Pos, double Value); // Also updates minimums, maximums and counts
+    void                        Item_Set(size_t Item, double Value) {Item_Set(Item, x_Current, Value);}
+    void                        additionalStats_Set(const StatsValueInfo& Info, const char* Value);
+
     // Memory management
+    static bool                 Lossless;
+    statsencoding               Data_Encoding(size_t Item) const; // Storage type of an item, from its per_item description
     size_t                      Data_Reserved; // Count of frames reserved in memory;
-    void                        Data_Reserve(size_t NewValue); // Increase Data_Reserved
+    void                        Data_Reserve(size_t NewValue); // Increase Data_Reserved so frame NewValue can be written, existing data is not moved
+    size_t                      Data_ChunkBits; // Size of the chunks of the columns, smaller for short streams
 
     // Arrays
     int                         Type;
@@ -185,9 +245,9 @@ protected:
     size_t                      CountOfGroups;
     size_t                      CountOfItems;
 
-    int**                       additionalIntStats;
-    double**                    additionalDoubleStats;
-    char***                     additionalStringStats;
+    StatsColumn<int>*           additionalIntStats;
+    StatsColumn<double>*        additionalDoubleStats;
+    StatsColumn<char*>*         additionalStringStats;
 };
 
 #endif // Stats_H
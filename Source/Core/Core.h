@@ -83,6 +83,32 @@ enum Types
 
 typedef std::bitset<Type_Max> activealltracks;
 
+enum decoderthreading
+{
+    DecoderThreading_Auto,
+    DecoderThreading_Frame,
+    DecoderThreading_Slice,
+    DecoderThreading_Max //Note: value is stored in preferences, always add a new element before DecoderThreading_Max
+};
+
+enum samplingmode
+{
+    Sampling_All,
+    Sampling_KeyFrames,                                     // Key frames only, other packets are not decoded
+    Sampling_Stride,                                        // One frame out of N, all frames are decoded but only these ones are filtered
+    Sampling_Max
+};
+
+// Sprite sheet holding the thumbnail of a frame
+struct thumbnailtile
+{
+    size_t FirstFrame;                                      // Frame in the top left cell
+    size_t Count;                                           // Count of frames in the sheet, cells are in raster order
+    int Columns;
+    int Width;                                              // Size of a cell
+    int Height;
+};
+
 extern const struct stream_info PerStreamType    [Type_Max];
 
 #endif // Core_H
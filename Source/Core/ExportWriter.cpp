@@ -0,0 +1,276 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Core/ExportWriter.h"
+#include "Core/AnalysisScheduler.h"
+#include "Core/Profiler.h"
+
+#include <QIODevice>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include <zlib.h>
+
+#include <cstring>
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Configuration
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static int ExportWriter_Level=Z_DEFAULT_COMPRESSION;
+static int ExportWriter_Threads=0;
+
+//---------------------------------------------------------------------------
+void ExportWriter::Level_Set(int Value)
+{
+    ExportWriter_Level=(Value>=0 && Value<=9)?Value:Z_DEFAULT_COMPRESSION;
+}
+
+//---------------------------------------------------------------------------
+int ExportWriter::Level_Get()
+{
+    return ExportWriter_Level;
+}
+
+//---------------------------------------------------------------------------
+void ExportWriter::Threads_Set(int Count)
+{
+    ExportWriter_Threads=Count>0?Count:0;
+}
+
+//---------------------------------------------------------------------------
+// Shared by all writers, e.g. the files exported at the same time in batch mode
+static QThreadPool* ExportWriter_Pool(int Threads)
+{
+    static QThreadPool Pool;
+    if (Pool.maxThreadCount()!=Threads)
+        Pool.setMaxThreadCount(Threads);
+    return &Pool;
+}
+
+//***************************************************************************
+// Block
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// One buffer, deflated without reference to the other ones. All blocks but
+// the last one end with a sync flush so they can be concatenated.
+class ExportWriter_Block : public QRunnable
+{
+public:
+    ExportWriter_Block() : Input_Size(0), Crc(0), Last(false), Level(Z_DEFAULT_COMPRESSION), Error(false), Profile(NULL) {setAutoDelete(false);}
+
+    void run();
+    void Compress();
+
+    std::vector<char>           Input;
+    size_t                      Input_Size;
+    std::string                 Output;
+    uLong                       Crc;
+    bool                        Last;
+    int                         Level;
+    bool                        Error;
+    Profiler*                   Profile;
+    QSemaphore                  Done;
+};
+
+//---------------------------------------------------------------------------
+void ExportWriter_Block::run()
+{
+    {
+        ProfilerScope Scope(Profile, ProfilerStage_Compress);
+        Compress();
+    }
+    Done.release(); // The block may be deleted as soon as it is released
+}
+
+//---------------------------------------------------------------------------
+void ExportWriter_Block::Compress()
+{
+    Crc=crc32(crc32(0, Z_NULL, 0), (const Bytef*)Input.data(), (uInt)Input_Size);
+
+    z_stream Stream;
+    memset(&Stream, 0, sizeof(Stream));
+    if (deflateInit2(&Stream, Level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY)!=Z_OK) // Raw deflate, the gzip wrapper is written once for all blocks
+    {
+        Error=true;
+        return;
+    }
+
+    Output.resize(deflateBound(&Stream, (uLong)Input_Size)+16); // Room for the sync flush marker
+    Stream.next_in=(Bytef*)Input.data();
+    Stream.avail_in=(uInt)Input_Size;
+    Stream.next_out=(Bytef*)&Output[0];
+    Stream.avail_out=(uInt)Output.size();
+    for (;;)
+    {
+        int Result=deflate(&Stream, Last?Z_FINISH:Z_SYNC_FLUSH);
+        if (Result==Z_STREAM_ERROR)
+        {
+            Error=true;
+            break;
+        }
+        if (Last?(Result==Z_STREAM_END):(!Stream.avail_in && Stream.avail_out))
+            break;
+
+        // Not expected with deflateBound(), but handled
+        size_t Output_Used=Output.size()-Stream.avail_out;
+        Output.resize(Output.size()*2);
+        Stream.next_out=(Bytef*)&Output[Output_Used];
+        Stream.avail_out=(uInt)(Output.size()-Output_Used);
+    }
+    Output.resize(Output.size()-Stream.avail_out);
+    deflateEnd(&Stream);
+}
+
+//***************************************************************************
+// Constructor / Destructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+ExportWriter::ExportWriter(QIODevice* Output_, bool Compressed_, size_t Buffer_Size) :
+    Output(Output_),
+    Compressed(Compressed_),
+    Buffer(Buffer_Size),
+    Buffer_Used(0),
+    Error(false),
+    Written(0),
+    Level(ExportWriter_Level),
+    Threads(ExportWriter_Threads?ExportWriter_Threads:AnalysisScheduler::instance()->threadBudget()),
+    Pool(NULL),
+    Crc(crc32(0, Z_NULL, 0)),
+    Offset(0),
+    Profile(NULL)
+{
+    if (Compressed)
+    {
+        if (Threads>1)
+            Pool=ExportWriter_Pool(Threads);
+
+        // gzip header: no name, no time stamp, Unix
+        static const char Header[10]={'\x1F', '\x8B', 8, 0, 0, 0, 0, 0, 0, 3};
+        if (Output->write(Header, sizeof(Header))!=(qint64)sizeof(Header))
+            Error=true;
+    }
+}
+
+//---------------------------------------------------------------------------
+ExportWriter::~ExportWriter()
+{
+    // Only the blocks of this writer are waited for, the pool is shared
+    for (size_t Pos=0; Pos<Pending.size(); Pos++)
+    {
+        Pending[Pos]->Done.acquire();
+        delete Pending[Pos];
+    }
+}
+
+//***************************************************************************
+// Data
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void ExportWriter::Write(const char* Data, size_t Size)
+{
+    Written+=Size;
+
+    while (Size)
+    {
+        size_t ToCopy=Buffer.size()-Buffer_Used;
+        if (ToCopy>Size)
+            ToCopy=Size;
+        memcpy(Buffer.data()+Buffer_Used, Data, ToCopy);
+        Buffer_Used+=ToCopy;
+        Data+=ToCopy;
+        Size-=ToCopy;
+
+        if (Buffer_Used==Buffer.size())
+            Flush(false);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool ExportWriter::Finish()
+{
+    Flush(true);
+    return !Error;
+}
+
+//---------------------------------------------------------------------------
+void ExportWriter::Flush(bool Last)
+{
+    if (Error)
+    {
+        Buffer_Used=0;
+        return;
+    }
+
+    if (!Compressed)
+    {
+        if (Buffer_Used && Output->write(Buffer.data(), Buffer_Used)!=(qint64)Buffer_Used)
+            Error=true;
+        Buffer_Used=0;
+        return;
+    }
+
+    // The buffer is given to the block, a new one is used for next data
+    ExportWriter_Block* Block=new ExportWriter_Block;
+    size_t Buffer_Size=Buffer.size();
+    Block->Input.swap(Buffer);
+    Buffer.resize(Buffer_Size);
+    Block->Input_Size=Buffer_Used;
+    Block->Last=Last;
+    Block->Level=Level;
+    Block->Profile=Profile;
+    Buffer_Used=0;
+    Pending.push_back(Block);
+    if (Pool)
+        Pool->start(Block);
+    else
+        Block->run();
+
+    // Blocks are written in order, a few of them are kept in flight for keeping the threads busy
+    size_t Pending_Max=Last?0:(size_t)(Pool?Threads*2:0);
+    while (Pending.size()>Pending_Max)
+        Block_Write();
+
+    if (Last && !Error)
+    {
+        // gzip trailer: CRC-32 and size modulo 2^32, little endian
+        char Trailer[8];
+        for (int Pos=0; Pos<4; Pos++)
+        {
+            Trailer[Pos]=(char)(Crc>>(Pos*8));
+            Trailer[4+Pos]=(char)(Offset>>(Pos*8));
+        }
+        if (Output->write(Trailer, sizeof(Trailer))!=(qint64)sizeof(Trailer))
+            Error=true;
+    }
+}
+
+//---------------------------------------------------------------------------
+void ExportWriter::Block_Write()
+{
+    ExportWriter_Block* Block=Pending.front();
+    Pending.pop_front();
+    Block->Done.acquire();
+
+    if (Block->Error)
+        Error=true;
+    if (!Error)
+    {
+        if (!Block->Output.empty() && Output->write(Block->Output.data(), Block->Output.size())!=(qint64)Block->Output.size())
+            Error=true;
+        Crc=(quint32)crc32_combine(Crc, Block->Crc, (z_off_t)Block->Input_Size);
+        Offset+=Block->Input_Size;
+    }
+
+    delete Block;
+}
@@ -0,0 +1,74 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef ExportWriter_H
+#define ExportWriter_H
+
+#include <QtGlobal>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+class QIODevice;
+class QThreadPool;
+class ExportWriter_Block;
+class Profiler;
+
+//---------------------------------------------------------------------------
+// Fixed size buffer between a serializer and the output device, compressed
+// (gzip) on the fly if requested. Memory usage does not depend on the size
+// of the content.
+//
+// When compressed, each full buffer is deflated independently on a thread
+// pool (as pigz does) and the blocks are written in order as a single gzip
+// member, readable by any gzip reader. The pool is shared by all writers,
+// so exports running at the same time stay within the thread budget.
+class ExportWriter
+{
+public:
+    // Configuration, before construction
+    static void                 Level_Set(int Value); // zlib compression level (0-9), -1 for the zlib default
+    static int                  Level_Get();
+    static void                 Threads_Set(int Count); // Count of compression threads, 0 for the analysis thread budget
+    void                        Profiler_Set(Profiler* Value) {Profile=Value;} // Compression time, before the first write
+
+    // Constructor / Destructor
+    ExportWriter(QIODevice* Output, bool Compressed, size_t Buffer_Size=0x100000);
+    ~ExportWriter();
+
+    // Data
+    void                        Write(const char* Data, size_t Size);
+    void                        Write(const std::string& Data) {Write(Data.c_str(), Data.size());}
+    bool                        Finish(); // Must be called once all data is written
+
+    // Status
+    quint64                     Written_Get() const {return Written;} // Uncompressed bytes received
+    bool                        IsOk() const {return !Error;}
+
+private:
+    void                        Flush(bool Last);
+    void                        Block_Write();
+
+    QIODevice*                  Output;
+    bool                        Compressed;
+    std::vector<char>           Buffer;
+    size_t                      Buffer_Used;
+    bool                        Error;
+    quint64                     Written;
+
+    // Compression
+    int                         Level;
+    int                         Threads;
+    QThreadPool*                Pool;
+    std::deque<ExportWriter_Block*> Pending;                // Blocks sent to the pool, in output order
+    quint32                     Crc;
+    quint64                     Offset;
+    Profiler*                   Profile;
+};
+
+#endif // ExportWriter_H
@@ -13,9 +13,12 @@
 #include "Core/AudioStats.h"
 #include "Core/StreamsStats.h"
 #include "Core/FormatStats.h"
+#include "Core/Profiler.h"
 
 #include <QXmlStreamReader>
 #include <QDebug>
+#include <QThread>
+#include <QWaitCondition>
 
 extern "C"
 {
@@ -46,6 +49,8 @@ extern "C"
 #include <iomanip>
 #include <cstdlib>
 #include <cfloat>
+#include <deque>
+#include <algorithm>
 //---------------------------------------------------------------------------
 
 void LibsVersion_Inject(stringstream &LibsVersion, const char* Name, int Value)
@@ -117,6 +122,9 @@ FFmpeg_Glue::inputdata::inputdata()
 
     // Status
     FramePos(0),
+    Decoder_FramePos((size_t)-1),
+    FramesSkipped(0),
+    Segment_Done(false),
 
     // General information
     FrameCount(0),
@@ -125,7 +133,10 @@ FFmpeg_Glue::inputdata::inputdata()
 
     // Cache
     FramesCache(NULL),
-    FramesCache_Default(NULL)
+    FramesCache_Default(NULL),
+
+    // Performance
+    Profile_Item((size_t)-1)
 {
 }
 
@@ -146,6 +157,179 @@ FFmpeg_Glue::inputdata::~inputdata()
     }
 }
 
+//***************************************************************************
+// outputthread
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Bounded queue of decoded frames for one output, processed on a dedicated thread
+class FFmpeg_Glue::outputthread : public QThread
+{
+public:
+    outputthread(outputdata* OutputData_) :
+        OutputData(OutputData_),
+        LastFrame(NULL),
+        IsBusy(false),
+        IsStopping(false)
+    {
+    }
+
+    ~outputthread()
+    {
+        Queue_Mutex.lock();
+        IsStopping=true;
+        Queue_NotEmpty.wakeAll();
+        Queue_NotFull.wakeAll();
+        Queue_Mutex.unlock();
+        wait();
+
+        for (size_t Pos=0; Pos<Queue.size(); Pos++)
+            av_frame_free(&Queue[Pos].Frame);
+        av_frame_free(&LastFrame);
+    }
+
+    // Frame is owned by the queue, NULL is a flush of the filters
+    void Push(AVFrame* Frame, bool IsPreRoll)
+    {
+        QMutexLocker locker(&Queue_Mutex);
+        while (Queue.size()>=Queue_Max && !IsStopping)
+            Queue_NotFull.wait(&Queue_Mutex);
+        queueitem Item;
+        Item.Frame=Frame;
+        Item.IsPreRoll=IsPreRoll;
+        Queue.push_back(Item);
+        Queue_NotEmpty.wakeOne();
+    }
+
+    size_t Queue_Size()
+    {
+        QMutexLocker locker(&Queue_Mutex);
+        return Queue.size();
+    }
+
+    void WaitIdle()
+    {
+        QMutexLocker locker(&Queue_Mutex);
+        while ((!Queue.empty() || IsBusy) && !IsStopping)
+            Queue_NotFull.wait(&Queue_Mutex);
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            AVFrame* Frame;
+            bool IsPreRoll;
+            {
+                QMutexLocker locker(&Queue_Mutex);
+                while (Queue.empty() && !IsStopping)
+                    Queue_NotEmpty.wait(&Queue_Mutex);
+                if (IsStopping)
+                    return;
+                Frame=Queue.front().Frame;
+                IsPreRoll=Queue.front().IsPreRoll;
+                Queue.pop_front();
+                IsBusy=true;
+                Queue_NotFull.wakeAll();
+            }
+
+            OutputData->Process(Frame, IsPreRoll);
+
+            // Output keeps a pointer to the last decoded frame, it must stay valid until the next one
+            av_frame_free(&LastFrame);
+            LastFrame=Frame;
+
+            {
+                QMutexLocker locker(&Queue_Mutex);
+                IsBusy=false;
+                Queue_NotFull.wakeAll();
+            }
+        }
+    }
+
+    static const size_t         Queue_Max=4;            // Decoded frames may be big, the queue only smooths out the speed differences
+
+    struct queueitem
+    {
+        AVFrame*                Frame;
+        bool                    IsPreRoll;
+    };
+
+    outputdata*                 OutputData;
+    std::deque<queueitem>       Queue;
+    QMutex                      Queue_Mutex;
+    QWaitCondition              Queue_NotEmpty;
+    QWaitCondition              Queue_NotFull;
+    AVFrame*                    LastFrame;
+    bool                        IsBusy;
+    bool                        IsStopping;
+};
+
+//***************************************************************************
+// cachethread
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Decoding of the frames after the displayed one, for the display cache
+class FFmpeg_Glue::cachethread : public QThread
+{
+public:
+    cachethread(FFmpeg_Glue* Glue_) :
+        Glue(Glue_),
+        IsWanted(false),
+        IsStopping(false)
+    {
+    }
+
+    ~cachethread()
+    {
+        Wake_Mutex.lock();
+        IsStopping=true;
+        Wake.wakeAll();
+        Wake_Mutex.unlock();
+        wait();
+    }
+
+    // The displayed frame changed
+    void Wake_Up()
+    {
+        QMutexLocker locker(&Wake_Mutex);
+        IsWanted=true;
+        Wake.wakeOne();
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            {
+                QMutexLocker locker(&Wake_Mutex);
+                while (!IsWanted && !IsStopping)
+                    Wake.wait(&Wake_Mutex);
+                if (IsStopping)
+                    return;
+                IsWanted=false;
+            }
+
+            // One frame at a time, so FrameAtPosition() waits for one decoding at most
+            while (Glue->DisplayCache_FillNext())
+            {
+                QMutexLocker locker(&Wake_Mutex);
+                if (IsStopping)
+                    return;
+            }
+        }
+    }
+
+    FFmpeg_Glue*                Glue;
+    QMutex                      Wake_Mutex;
+    QWaitCondition              Wake;
+    bool                        IsWanted;
+    bool                        IsStopping;
+};
+
 //***************************************************************************
 // outputdata
 //***************************************************************************
@@ -175,8 +359,19 @@ FFmpeg_Glue::outputdata::outputdata()
 
     // Out
     OutputMethod(Output_None),
-    Thumbnails_Modulo(1),
+
+    // Sprite sheets
+    Tiles_Side(0),
+    TileOutput_CodecContext(NULL),
+    TileInput_CodecContext(NULL),
+    TileDecoded_FirstFrame((size_t)-1),
+
     Stats(NULL),
+
+    // Pipeline
+    Thread(NULL),
+    Profile(NULL),
+    Profile_Item((size_t)-1),
     
     // Helpers
     Width(0),
@@ -190,14 +385,21 @@ FFmpeg_Glue::outputdata::outputdata()
 //---------------------------------------------------------------------------
 FFmpeg_Glue::outputdata::~outputdata()
 {
+    // Pipeline
+    delete Thread;
+
     // Images
     image.free();
 
-    Thumbnails.clear();
-
     if (JpegOutput_CodecContext)
         avcodec_free_context(&JpegOutput_CodecContext);
 
+    // Sprite sheets
+    if (TileOutput_CodecContext)
+        avcodec_free_context(&TileOutput_CodecContext);
+    if (TileInput_CodecContext)
+        avcodec_free_context(&TileInput_CodecContext);
+
     // FFmpeg pointers - Scale
     if (ScaledFrame)
         ScaledFrame.reset();
@@ -211,7 +413,7 @@ FFmpeg_Glue::outputdata::~outputdata()
 }
 
 //---------------------------------------------------------------------------
-void FFmpeg_Glue::outputdata::Process(AVFrame* DecodedFrame_)
+void FFmpeg_Glue::outputdata::Process(AVFrame* DecodedFrame_, bool IsPreRoll)
 {
     struct NoDeleter {
         static void free(AVFrame* frame) {
@@ -223,7 +425,18 @@ void FFmpeg_Glue::outputdata::Process(AVFrame* DecodedFrame_)
     OutputFrame = DecodedFrame;
 
     //Filtering
-    ApplyFilter(OutputFrame);
+    {
+        ProfilerScope Scope(Profile, ProfilerStage_Filter, Profile_Item);
+        ApplyFilter(OutputFrame);
+    }
+
+    // Pre-roll: the filtered frame belongs to the previous segment, it is dropped
+    if (IsPreRoll)
+    {
+        FilteredFrame.reset();
+        OutputFrame.reset();
+        return;
+    }
 
     if(FilteredFrame)
     {
@@ -234,12 +447,16 @@ void FFmpeg_Glue::outputdata::Process(AVFrame* DecodedFrame_)
     // Stats
     if (Stats && FilteredFrame && !Filter.empty())
     {
+        ProfilerScope Scope(Profile, ProfilerStage_Stats);
         Stats->TimeStampFromFrame(FilteredFrame.get(), FramePos-1);
         Stats->StatsFromFrame(FilteredFrame.get(), Stream->codec->width, Stream->codec->height);
     }
 
     // Scale
-    ApplyScale(OutputFrame);
+    {
+        ProfilerScope Scope(Profile, ProfilerStage_Scale);
+        ApplyScale(OutputFrame);
+    }
 
     if(ScaledFrame)
         OutputFrame = ScaledFrame;
@@ -253,6 +470,19 @@ void FFmpeg_Glue::outputdata::Process(AVFrame* DecodedFrame_)
     }    
 }
 
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::outputdata::Process_Queue(AVFrame* DecodedFrame_, bool IsPreRoll)
+{
+    if (!Thread)
+    {
+        Process(DecodedFrame_, IsPreRoll);
+        return;
+    }
+
+    // Decoded frames are ref-counted, the output thread gets its own reference without copying the pixels
+    Thread->Push(DecodedFrame_?av_frame_clone(DecodedFrame_):NULL, IsPreRoll);
+}
+
 //---------------------------------------------------------------------------
 void FFmpeg_Glue::outputdata::ApplyFilter(const AVFramePtr& sourceFrame)
 {
@@ -264,9 +494,9 @@ void FFmpeg_Glue::outputdata::ApplyFilter(const AVFramePtr& sourceFrame)
     if (!FilterGraph && !FilterGraph_Init())
         return;
             
-    // Push the decoded Frame into the filtergraph 
-    //if (av_buffersrc_add_frame_flags(FilterGraph_Source_Context, DecodedFrame, AV_BUFFERSRC_FLAG_KEEP_REF)<0)
-    if (av_buffersrc_add_frame_flags(FilterGraph_Source_Context, sourceFrame.get(), 0)<0)
+    // Push the decoded Frame into the filtergraph
+    // The source frame is shared (decoder frame, display cache entry) by all the outputs of the stream, the filter graph gets its own reference
+    if (av_buffersrc_add_frame_flags(FilterGraph_Source_Context, sourceFrame.get(), AV_BUFFERSRC_FLAG_KEEP_REF)<0)
         return;
 
     struct FilteredFrameDeleter {
@@ -359,10 +589,10 @@ void FFmpeg_Glue::outputdata::AVPacketDeleter::operator()(AVPacket* packet) {
 //---------------------------------------------------------------------------
 void FFmpeg_Glue::outputdata::AddThumbnail()
 {
-    if (Thumbnails.size()%Thumbnails_Modulo)
+    if (Tiles_Side)
     {
-        Thumbnails.push_back(NULL);
-        return; // Not wanting to saturate memory. TODO: Find a smarter way to detect memory usage
+        AddToTile();
+        return;
     }
 
     auto jpegOutPacket = std::unique_ptr<AVPacket, AVPacketDeleter>(av_packet_alloc(), AVPacketDeleter());
@@ -373,23 +603,226 @@ void FFmpeg_Glue::outputdata::AddThumbnail()
 
     if (!JpegOutput_CodecContext && !InitThumnails())
     {
-        Thumbnails.push_back(std::move(jpegOutPacket));
+        Thumbnails.Add(jpegOutPacket.get());
         return;
     }
 
     int got_packet=0;
-    int result = avcodec_encode_video2(JpegOutput_CodecContext, jpegOutPacket.get(), OutputFrame.get(), &got_packet);
+    int result;
+    {
+        ProfilerScope Scope(Profile, ProfilerStage_Jpeg);
+        result = avcodec_encode_video2(JpegOutput_CodecContext, jpegOutPacket.get(), OutputFrame.get(), &got_packet);
+    }
 
     if (result < 0 || !got_packet)
     {
         char buffer[256];
         qDebug() << av_make_error_string(buffer, sizeof buffer, result);
 
-        Thumbnails.push_back(std::move(jpegOutPacket));
+        Thumbnails.Add(jpegOutPacket.get());
+        return;
+    }
+
+    Thumbnails.Add(jpegOutPacket.get());
+}
+
+//---------------------------------------------------------------------------
+static void Frame_Free(AVFrame* Frame)
+{
+    av_frame_free(&Frame);
+}
+
+//---------------------------------------------------------------------------
+bool FFmpeg_Glue::outputdata::InitTiles()
+{
+    if (Tile)
+        return true;
+
+    // Single thumbnails are still encoded when they are extracted from a sheet (e.g. for a .qctools.mkv)
+    if (!InitThumnails())
+        return false;
+
+    AVCodec *TileOutput_Codec=avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    if (!TileOutput_Codec)
+        return false;
+    TileOutput_CodecContext=avcodec_alloc_context3(TileOutput_Codec);
+    if (!TileOutput_CodecContext)
+        return false;
+    TileOutput_CodecContext->qmin          = JpegOutput_CodecContext->qmin;
+    TileOutput_CodecContext->qmax          = JpegOutput_CodecContext->qmax;
+    TileOutput_CodecContext->width         = Tile_CellWidth()*Tiles_Side;
+    TileOutput_CodecContext->height        = Tile_CellHeight()*Tiles_Side;
+    TileOutput_CodecContext->pix_fmt       = AV_PIX_FMT_YUVJ420P;
+    TileOutput_CodecContext->time_base     = JpegOutput_CodecContext->time_base;
+    if (avcodec_open2(TileOutput_CodecContext, TileOutput_Codec, NULL) < 0)
+    {
+        avcodec_free_context(&TileOutput_CodecContext);
+        return false;
+    }
+
+    Tile=AVFramePtr(av_frame_alloc(), Frame_Free);
+    Tile->width=TileOutput_CodecContext->width;
+    Tile->height=TileOutput_CodecContext->height;
+    Tile->format=AV_PIX_FMT_YUVJ420P;
+    if (av_frame_get_buffer(Tile.get(), 32) < 0)
+    {
+        Tile.reset();
+        avcodec_free_context(&TileOutput_CodecContext);
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::outputdata::AddToTile()
+{
+    if (!InitTiles())
+    {
+        Thumbnails.Add(NULL);
+        return;
+    }
+
+    size_t Slot=Tile_Pts.size();
+    if (!Slot)
+    {
+        // New sheet, black background for the cells not filled at the end of the stream
+        av_frame_make_writable(Tile.get());
+        memset(Tile->data[0], 0x00, Tile->linesize[0]*Tile->height);
+        memset(Tile->data[1], 0x80, Tile->linesize[1]*(Tile->height/2));
+        memset(Tile->data[2], 0x80, Tile->linesize[2]*(Tile->height/2));
+    }
+
+    if (OutputFrame && OutputFrame->width==Width && OutputFrame->height==Height)
+    {
+        int X=(int)(Slot%Tiles_Side)*Tile_CellWidth();
+        int Y=(int)(Slot/Tiles_Side)*Tile_CellHeight();
+        for (int Plane=0; Plane<3; Plane++)
+        {
+            int Shift=Plane?1:0; // 4:2:0
+            av_image_copy_plane(Tile->data[Plane]+(Y>>Shift)*Tile->linesize[Plane]+(X>>Shift), Tile->linesize[Plane],
+                                OutputFrame->data[Plane], OutputFrame->linesize[Plane],
+                                (Width+Shift)>>Shift, (Height+Shift)>>Shift);
+        }
+    }
+
+    Tile_Pts.push_back(OutputFrame?OutputFrame->pts:AV_NOPTS_VALUE);
+    if (Tile_Pts.size()==(size_t)(Tiles_Side*Tiles_Side))
+        FlushTile();
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::outputdata::FlushTile()
+{
+    if (Tile_Pts.empty())
         return;
+
+    auto jpegOutPacket = std::unique_ptr<AVPacket, AVPacketDeleter>(av_packet_alloc(), AVPacketDeleter());
+    av_init_packet (jpegOutPacket.get());
+
+    jpegOutPacket->data = nullptr;
+    jpegOutPacket->size = 0;
+
+    Tile->pts=Tile_Pts[0];
+
+    int got_packet=0;
+    int result;
+    {
+        ProfilerScope Scope(Profile, ProfilerStage_Jpeg);
+        result = avcodec_encode_video2(TileOutput_CodecContext, jpegOutPacket.get(), Tile.get(), &got_packet);
     }
 
-    Thumbnails.push_back(std::move(jpegOutPacket));
+    if (result < 0 || !got_packet)
+    {
+        char buffer[256];
+        qDebug() << av_make_error_string(buffer, sizeof buffer, result);
+
+        Thumbnails.Add_Tile(NULL, Tile_Pts);
+    }
+    else
+        Thumbnails.Add_Tile(jpegOutPacket.get(), Tile_Pts);
+
+    Tile_Pts.clear();
+}
+
+//---------------------------------------------------------------------------
+AVPacket* FFmpeg_Glue::outputdata::Thumbnail_Get(size_t FramePos)
+{
+    int Slot=-1;
+    AVPacket* Sheet=Thumbnails.Packet_Get(FramePos, &Slot);
+    if (!Sheet || Slot<0 || !Sheet->size)
+        return Sheet;
+
+    if (!TileExtracted)
+        TileExtracted.reset(av_packet_alloc());
+    if (!TileExtracted)
+        return NULL;
+    av_packet_unref(TileExtracted.get());
+    TileExtracted->data = nullptr;
+    TileExtracted->size = 0;
+
+    // Sheet decoding, once for all the frames of the sheet
+    size_t FirstFrame=FramePos-Slot;
+    if (!TileDecoded || TileDecoded_FirstFrame!=FirstFrame)
+    {
+        if (!TileInput_CodecContext)
+        {
+            AVCodec *TileInput_Codec=avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+            if (!TileInput_Codec)
+                return TileExtracted.get();
+            TileInput_CodecContext=avcodec_alloc_context3(TileInput_Codec);
+            if (!TileInput_CodecContext)
+                return TileExtracted.get();
+            if (avcodec_open2(TileInput_CodecContext, TileInput_Codec, NULL) < 0)
+            {
+                avcodec_free_context(&TileInput_CodecContext);
+                return TileExtracted.get();
+            }
+        }
+
+        if (!TileDecoded)
+            TileDecoded=AVFramePtr(av_frame_alloc(), Frame_Free);
+        else
+            av_frame_unref(TileDecoded.get());
+        TileDecoded_FirstFrame=(size_t)-1;
+
+        int got_frame=0;
+        if (avcodec_decode_video2(TileInput_CodecContext, TileDecoded.get(), &got_frame, Sheet) < 0 || !got_frame || TileDecoded->format!=AV_PIX_FMT_YUVJ420P)
+            return TileExtracted.get();
+        TileDecoded_FirstFrame=FirstFrame;
+    }
+
+    if (!JpegOutput_CodecContext)
+        return TileExtracted.get();
+
+    // Cell, pointing to the decoded sheet
+    AVFrame* Cell=av_frame_alloc();
+    if (!Cell)
+        return TileExtracted.get();
+    Cell->width=Width;
+    Cell->height=Height;
+    Cell->format=TileDecoded->format;
+    Cell->pts=Sheet->pts;
+    int X=(Slot%Tiles_Side)*Tile_CellWidth();
+    int Y=(Slot/Tiles_Side)*Tile_CellHeight();
+    for (int Plane=0; Plane<3; Plane++)
+    {
+        int Shift=Plane?1:0; // 4:2:0
+        Cell->data[Plane]=TileDecoded->data[Plane]+(Y>>Shift)*TileDecoded->linesize[Plane]+(X>>Shift);
+        Cell->linesize[Plane]=TileDecoded->linesize[Plane];
+    }
+
+    int got_packet=0;
+    int result=avcodec_encode_video2(JpegOutput_CodecContext, TileExtracted.get(), Cell, &got_packet);
+    av_frame_free(&Cell);
+    if (result < 0 || !got_packet)
+    {
+        av_packet_unref(TileExtracted.get());
+        TileExtracted->data = nullptr;
+        TileExtracted->size = 0;
+    }
+
+    return TileExtracted.get();
 }
 
 //---------------------------------------------------------------------------
@@ -586,12 +1019,19 @@ void ensureFFMpegInitialized() {
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-FFmpeg_Glue::FFmpeg_Glue (const string &FileName_, activealltracks ActiveAllTracks, std::vector<CommonStats*>* Stats_, StreamsStats** streamsStats, FormatStats** formatStats, bool WithStats_) :
+FFmpeg_Glue::FFmpeg_Glue (const string &FileName_, activealltracks ActiveAllTracks, std::vector<CommonStats*>* Stats_, StreamsStats** streamsStats, FormatStats** formatStats, bool WithStats_, decoderthreading DecoderThreading, int DecoderThreadCount, bool PacketsOnly_) :
     Stats(Stats_),
     WithStats(WithStats_),
+    PacketsOnly(PacketsOnly_),
     FileName(FileName_),
     InputDatas_Copy(false),
-    mutex(nullptr)
+    mutex(nullptr),
+    DisplayCache_Thread(NULL),
+    DisplayCache_Bytes(0),
+    DisplayCache_MaxBytes(0),
+    DisplayCache_Current(0),
+    DisplayCache_IsFilling(false),
+    Profile(NULL)
 {
     ensureFFMpegInitialized();
 
@@ -616,9 +1056,20 @@ FFmpeg_Glue::FFmpeg_Glue (const string &FileName_, activealltracks ActiveAllTrac
                                                         inputdata* InputData=new inputdata;
                                                         InputData->Type=FormatContext->streams[Pos]->codec->codec_type;
                                                         InputData->Stream=FormatContext->streams[Pos];
-                                                        AVCodec* Codec=avcodec_find_decoder(InputData->Stream->codec->codec_id);
+                                                        AVCodec* Codec=PacketsOnly?NULL:avcodec_find_decoder(InputData->Stream->codec->codec_id);
                                                         if (Codec)
+                                                        {
+                                                            // Threading, 0 lets FFmpeg choose the count
+                                                            InputData->Stream->codec->thread_count=DecoderThreadCount;
+                                                            switch (DecoderThreading)
+                                                            {
+                                                                case DecoderThreading_Frame :   InputData->Stream->codec->thread_type=FF_THREAD_FRAME; break;
+                                                                case DecoderThreading_Slice :   InputData->Stream->codec->thread_type=FF_THREAD_SLICE; break;
+                                                                default                     :   InputData->Stream->codec->thread_type=FF_THREAD_FRAME|FF_THREAD_SLICE;
+                                                            }
+                                                            InputData->Stream->codec->refcounted_frames=1; // Output threads and the display cache keep references instead of copies
                                                             avcodec_open2(InputData->Stream->codec, Codec, NULL);
+                                                        }
 
                                                         InputData->FrameCount=InputData->Stream->nb_frames;
                                                         if (InputData->Stream->duration!=AV_NOPTS_VALUE)
@@ -698,11 +1149,20 @@ FFmpeg_Glue::FFmpeg_Glue (const string &FileName_, activealltracks ActiveAllTrac
 
     // Temp
     Seek_TimeStamp=AV_NOPTS_VALUE;
+    SeekIndex_Scanned=0;
+    Sampling_Mode=Sampling_All;
+    Sampling_Stride=1;
+    Segment_Stream=NULL;
+    Segment_Start=INT64_MIN;
+    Segment_End=INT64_MAX;
 }
 
 //---------------------------------------------------------------------------
 FFmpeg_Glue::~FFmpeg_Glue()
 {
+    delete DisplayCache_Thread;
+    DisplayCache_Clear();
+
     if (Packet)
     {
         //av_packet_unref(Packet);
@@ -736,8 +1196,7 @@ AVPacket *FFmpeg_Glue::ThumbnailPacket_Get(size_t Pos, size_t FramePos)
     if (Pos>=OutputDatas.size() || !OutputDatas[Pos] || !OutputDatas[Pos]->Enabled)
         return NULL;
 
-    auto avpacket = OutputDatas[Pos]->Thumbnails[FramePos].get();
-    return avpacket;
+    return OutputDatas[Pos]->Thumbnail_Get(FramePos);
 }
 
 QByteArray FFmpeg_Glue::Thumbnail_Get(size_t Pos, size_t FramePos)
@@ -747,10 +1206,32 @@ QByteArray FFmpeg_Glue::Thumbnail_Get(size_t Pos, size_t FramePos)
     if (Pos>=OutputDatas.size() || !OutputDatas[Pos] || !OutputDatas[Pos]->Enabled)
         return NULL;
 
-    auto avpacket = OutputDatas[Pos]->Thumbnails[FramePos].get();
+    AVPacket* avpacket = OutputDatas[Pos]->Thumbnail_Get(FramePos);
+    if (!avpacket || !avpacket->size)
+        return QByteArray();
     return QByteArray(reinterpret_cast<char*> (avpacket->data), avpacket->size);
 }
 
+QByteArray FFmpeg_Glue::ThumbnailTile_Get(size_t Pos, size_t FramePos, thumbnailtile& Tile)
+{
+    QMutexLocker locker(mutex);
+
+    if (Pos>=OutputDatas.size() || !OutputDatas[Pos] || !OutputDatas[Pos]->Enabled)
+        return QByteArray();
+
+    outputdata* OutputData=OutputDatas[Pos];
+    int Slot=-1;
+    size_t Count=1;
+    QByteArray Data=OutputData->Thumbnails.Get(FramePos, &Slot, &Count);
+
+    Tile.FirstFrame=Slot<0?FramePos:(FramePos-Slot);
+    Tile.Count=Count;
+    Tile.Columns=Slot<0?1:OutputData->Tiles_Side;
+    Tile.Width=Slot<0?OutputData->Width:OutputData->Tile_CellWidth();
+    Tile.Height=Slot<0?OutputData->Height:OutputData->Tile_CellHeight();
+    return Data;
+}
+
 size_t FFmpeg_Glue::Thumbnails_Size(size_t Pos)
 {
     QMutexLocker locker(mutex);
@@ -758,7 +1239,7 @@ size_t FFmpeg_Glue::Thumbnails_Size(size_t Pos)
     if (Pos>=OutputDatas.size() || !OutputDatas[Pos] || !OutputDatas[Pos]->Enabled)
         return 0;
 
-    return OutputDatas[Pos]->Thumbnails.size();
+    return OutputDatas[Pos]->Thumbnails.Size();
 }
 
 //***************************************************************************
@@ -812,6 +1293,7 @@ void FFmpeg_Glue::ModifyOutput(size_t InputPos, size_t OutputPos, size_t FilterP
 
     delete OutputDatas[OutputPos];
     OutputDatas[OutputPos]=OutputData;
+    Profiler_Items_Set();
 }
 
 //---------------------------------------------------------------------------
@@ -833,12 +1315,39 @@ void FFmpeg_Glue::Seek(size_t FramePos)
                 InputData->FirstTimeStamp=(*Stats)[0]->FirstTimeStamp;
 
             // Finding the right source and time stamp computing
+            bool IsSeekNeeded=true;
             if (Stats && !Stats->empty() && (*Stats)[0] && FramePos<(*Stats)[0]->x_Current)
             {
                 double TimeStamp=(*Stats)[0]->x[1][FramePos];
                 if (InputData->FirstTimeStamp!=DBL_MAX)
                     TimeStamp+=InputData->FirstTimeStamp;
                 Seek_TimeStamp=(int64_t)(TimeStamp*InputData->Stream->time_base.den/InputData->Stream->time_base.num);
+
+                // Exact seek to the key frame before the wanted frame (the frame before FramePos may be displayed, see FrameAtPosition)
+                // Stats of this stream, so pkt_pts is in the time base of the seeked stream
+                CommonStats* Video=Pos<Stats->size()?(*Stats)[Pos]:NULL;
+                size_t Target=FramePos?(FramePos-1):0;
+                size_t KeyFrame=(Video && Video->Type_Get()==Type_Video)?SeekIndex_KeyFrame(Video, Target):(size_t)-1;
+                if (FormatContext && KeyFrame!=(size_t)-1)
+                {
+                    if (InputData->Decoder_FramePos!=(size_t)-1 && InputData->Decoder_FramePos>=KeyFrame && InputData->Decoder_FramePos<=Target)
+                    {
+                        // No key frame between the current position and the wanted frame, decoding forward is enough
+                        IsSeekNeeded=false;
+                    }
+                    else if (Video->pkt_pts[KeyFrame]!=AV_NOPTS_VALUE)
+                    {
+                        IsSeekNeeded=avformat_seek_file(FormatContext, Pos, INT64_MIN, Video->pkt_pts[KeyFrame], Video->pkt_pts[KeyFrame], 0)<0;
+                        if (!IsSeekNeeded)
+                            avcodec_flush_buffers(InputData->Stream->codec);
+                    }
+                    else if (Video->pkt_pos[KeyFrame]>=0 && !(FormatContext->iformat->flags&AVFMT_NO_BYTE_SEEK))
+                    {
+                        IsSeekNeeded=avformat_seek_file(FormatContext, Pos, INT64_MIN, Video->pkt_pos[KeyFrame], Video->pkt_pos[KeyFrame], AVSEEK_FLAG_BYTE)<0;
+                        if (!IsSeekNeeded)
+                            avcodec_flush_buffers(InputData->Stream->codec);
+                    }
+                }
             }
             else
             {
@@ -849,6 +1358,9 @@ void FFmpeg_Glue::Seek(size_t FramePos)
                     Seek_TimeStamp/=InputData->FrameCount;  // TODO: seek based on time stamp
             }
     
+            if (!IsSeekNeeded)
+                break;
+
             // Seek
             if (FormatContext)
             {
@@ -866,9 +1378,30 @@ void FFmpeg_Glue::Seek(size_t FramePos)
     }
 }
 
+//---------------------------------------------------------------------------
+size_t FFmpeg_Glue::SeekIndex_KeyFrame(CommonStats* Video, size_t FramePos)
+{
+    // Stats are only appended, new frames are added to the index
+    if (SeekIndex_Scanned>Video->x_Current)
+    {
+        SeekIndex.clear();
+        SeekIndex_Scanned=0;
+    }
+    for (; SeekIndex_Scanned<Video->x_Current; SeekIndex_Scanned++)
+        if (Video->key_frames.Get(SeekIndex_Scanned))
+            SeekIndex.push_back(SeekIndex_Scanned);
+
+    std::vector<size_t>::iterator KeyFrame=std::upper_bound(SeekIndex.begin(), SeekIndex.end(), FramePos);
+    if (KeyFrame==SeekIndex.begin())
+        return (size_t)-1;
+    return *(KeyFrame-1);
+}
+
 //---------------------------------------------------------------------------
 void FFmpeg_Glue::FrameAtPosition(size_t FramePos)
 {
+    QMutexLocker CacheLocker(&DisplayCache_Mutex);
+
     for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
     {
         inputdata* InputData=InputDatas[Pos];
@@ -877,7 +1410,31 @@ void FFmpeg_Glue::FrameAtPosition(size_t FramePos)
         {
             // qDebug() << "*** frameAtPosition: FramePos = " << FramePos << ", InputData->FramePos = " << InputData->FramePos;
 
-            if (InputData->FramePos != FramePos)
+            bool IsCached=DisplayCache_MaxBytes && FramePos!=(size_t)-1;
+            if (IsCached)
+            {
+                DisplayCache_Current=FramePos;
+
+                // Already decoded, only filtering and scaling are needed
+                std::map<size_t, AVFrame*>::iterator Cached=DisplayCache.find(FramePos);
+                if (Cached!=DisplayCache.end())
+                {
+                    {
+                        QMutexLocker locker(mutex);
+                        for (size_t OutputPos=0; OutputPos<OutputDatas.size(); OutputPos++)
+                            if (OutputDatas[OutputPos] && OutputDatas[OutputPos]->Enabled && OutputDatas[OutputPos]->Stream==InputData->Stream)
+                                OutputDatas[OutputPos]->Process_Queue(Cached->second);
+                        InputData->FramePos=FramePos+1;
+                    }
+
+                    if (DisplayCache_Thread)
+                        DisplayCache_Thread->Wake_Up();
+                    break;
+                }
+            }
+
+            // The decoder may be elsewhere if the previous frames came from the cache
+            if (InputData->FramePos != FramePos || (IsCached && InputData->Decoder_FramePos != FramePos))
             {
                 if(FramePos == -1)
                 {
@@ -900,7 +1457,28 @@ void FFmpeg_Glue::FrameAtPosition(size_t FramePos)
                 // qDebug() << "frameAtPosition after Seek: FramePos = " << FramePos << ", InputData->FramePos = " << InputData->FramePos;
             }
 
-            NextFrame();
+            DisplayCache_Pending_Add(NULL);
+            bool IsDecoded=NextFrame();
+            InputData->Decoder_FramePos=InputData->FramePos;
+
+            if (IsCached && IsDecoded)
+            {
+                // Frames decoded before the wanted one are the previous ones
+                for (size_t Pending=0; Pending<DisplayCache_Pending.size(); Pending++)
+                {
+                    size_t Distance=DisplayCache_Pending.size()-Pending;
+                    if (FramePos>=Distance)
+                        DisplayCache_Add(FramePos-Distance, DisplayCache_Pending[Pending]);
+                    else
+                        av_frame_free(&DisplayCache_Pending[Pending]);
+                }
+                DisplayCache_Pending.clear();
+
+                DisplayCache_Add(FramePos, av_frame_clone(Frame));
+                if (DisplayCache_Thread)
+                    DisplayCache_Thread->Wake_Up();
+            }
+            DisplayCache_Pending_Add(NULL);
 
             // qDebug() << "frameAtPosition after NextFrame: FramePos = " << FramePos << ", InputData->FramePos = " << InputData->FramePos;
             break;
@@ -954,13 +1532,29 @@ bool FFmpeg_Glue::NextFrame()
     if (!FormatContext)
         return false;
 
+    if (PacketsOnly)
+        return NextPacket();
+
     // Next frame
-    while (Packet->size || av_read_frame(FormatContext, Packet) >= 0)
+    while (Packet->size || Packet_Read() >= 0)
     {
         AVPacket TempPacket=*Packet;
-        if (Packet->stream_index<InputDatas.size() && InputDatas[Packet->stream_index] && InputDatas[Packet->stream_index]->Enabled)
+        if (Packet->stream_index<InputDatas.size() && InputDatas[Packet->stream_index] && InputDatas[Packet->stream_index]->Enabled && !InputDatas[Packet->stream_index]->Segment_Done)
         {
-            do
+            // Audio frames are not reordered, a packet after the end of the segment means that the stream is done
+            if (Segment_End!=INT64_MAX && InputDatas[Packet->stream_index]->Type==AVMEDIA_TYPE_AUDIO)
+            {
+                int64_t ts=(Packet->pts==AV_NOPTS_VALUE)?Packet->dts:Packet->pts;
+                if (ts!=AV_NOPTS_VALUE && av_compare_ts(ts, InputDatas[Packet->stream_index]->Stream->time_base, Segment_End, Segment_Stream->time_base)>=0)
+                    InputDatas[Packet->stream_index]->Segment_Done=true;
+            }
+
+            // Key frames only: other packets are not decoded
+            bool IsSkipped=Sampling_Mode==Sampling_KeyFrames && InputDatas[Packet->stream_index]->Type==AVMEDIA_TYPE_VIDEO && !(Packet->flags&AV_PKT_FLAG_KEY);
+            if (IsSkipped)
+                InputDatas[Packet->stream_index]->FramesSkipped++;
+
+            while (!IsSkipped && !InputDatas[Packet->stream_index]->Segment_Done)
             {
                 if (OutputFrame(Packet))
                 {
@@ -969,18 +1563,75 @@ bool FFmpeg_Glue::NextFrame()
                     if (InputDatas[Packet->stream_index]->Type==AVMEDIA_TYPE_VIDEO)
                         return true;
                 }
+                if (Packet->size<=0)
+                    break;
             }
-            while (Packet->size > 0);
         }
         av_packet_unref(&TempPacket);
         Packet->size=0;
+
+        if (Segment_End!=INT64_MAX && Segment_IsComplete())
+            break;
     }
     
     // Flushing
     Packet->data=NULL;
     Packet->size=0;
     while (OutputFrame(Packet));
+    Pipeline_Flush();
+
+    // Last sprite sheets, partially filled
+    for (size_t Pos=0; Pos<OutputDatas.size(); Pos++)
+        if (OutputDatas[Pos])
+            OutputDatas[Pos]->FlushTile();
     
+    // Complete (stats of a segment are finished by the caller, after all segments are appended)
+    if (WithStats && Segment_End==INT64_MAX)
+        for (size_t Pos=0; Pos<Stats->size(); Pos++)
+            if ((*Stats)[Pos])
+                (*Stats)[Pos]->StatsFinish();
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+int FFmpeg_Glue::Packet_Read()
+{
+    ProfilerScope Scope(Profile, ProfilerStage_Demux);
+    int Result=av_read_frame(FormatContext, Packet);
+    if (Result>=0 && Profile)
+        Profile->Bytes_Add(Packet->size);
+    return Result;
+}
+
+//---------------------------------------------------------------------------
+// Packets are not decoded, stats are filled in decoding order with the container values only
+bool FFmpeg_Glue::NextPacket()
+{
+    while (Packet_Read()>=0)
+    {
+        size_t Pos=Packet->stream_index;
+        inputdata* InputData=Pos<InputDatas.size()?InputDatas[Pos]:NULL;
+        CommonStats* Stat=(Stats && Pos<Stats->size())?(*Stats)[Pos]:NULL;
+        bool IsVideo=false;
+        if (InputData && InputData->Enabled && Stat)
+        {
+            {
+                ProfilerScope Scope(Profile, ProfilerStage_Stats);
+                Stat->StatsFromPacket(Packet, InputData->Stream->codec->pix_fmt);
+            }
+
+            InputData->FramePos++;
+            if (InputData->FramePos>InputData->FrameCount)
+                InputData->FrameCount=InputData->FramePos;
+            IsVideo=InputData->Type==AVMEDIA_TYPE_VIDEO;
+        }
+        av_packet_unref(Packet);
+
+        if (IsVideo)
+            return true;
+    }
+
     // Complete
     if (WithStats)
         for (size_t Pos=0; Pos<Stats->size(); Pos++)
@@ -1007,13 +1658,20 @@ bool FFmpeg_Glue::OutputFrame(AVPacket* TempPacket, bool Decode)
     int got_frame;
     if (Decode)
     {
+        // Decoded frames are ref-counted, the previous one is released (frames from FramesCache are not ref-counted and are kept)
+        if (Frame->buf[0])
+            av_frame_unref(Frame);
+
         got_frame=0;
         int Bytes;
-        switch(InputData->Type)
         {
-            case AVMEDIA_TYPE_VIDEO : Bytes=DecodeVideo(InputData, Frame, got_frame, TempPacket); break;
-            case AVMEDIA_TYPE_AUDIO : Bytes=avcodec_decode_audio4(InputData->Stream->codec, Frame, &got_frame, TempPacket); break;
-            default                 : Bytes=0;
+            ProfilerScope Scope(Profile, ProfilerStage_Decode, InputData->Profile_Item);
+            switch(InputData->Type)
+            {
+                case AVMEDIA_TYPE_VIDEO : Bytes=DecodeVideo(InputData, Frame, got_frame, TempPacket); break;
+                case AVMEDIA_TYPE_AUDIO : Bytes=avcodec_decode_audio4(InputData->Stream->codec, Frame, &got_frame, TempPacket); break;
+                default                 : Bytes=0;
+            }
         }
         
         if (Bytes<=0 && !got_frame)
@@ -1024,7 +1682,7 @@ bool FFmpeg_Glue::OutputFrame(AVPacket* TempPacket, bool Decode)
             for (size_t OutputPos=0; OutputPos<OutputDatas.size(); OutputPos++)
                 if (OutputDatas[OutputPos] && OutputDatas[OutputPos]->Enabled && OutputDatas[OutputPos]->Stream==InputData->Stream) {
                     if(!OutputDatas[OutputPos]->Filter.empty()) // flush delayed filtered frames
-                        OutputDatas[OutputPos]->Process(nullptr);
+                        OutputDatas[OutputPos]->Process_Queue(nullptr);
                 }
 
             return false;
@@ -1041,13 +1699,44 @@ bool FFmpeg_Glue::OutputFrame(AVPacket* TempPacket, bool Decode)
     if (got_frame && (Seek_TimeStamp==AV_NOPTS_VALUE || Frame->pkt_pts>=(Seek_TimeStamp?(Seek_TimeStamp-1):Seek_TimeStamp)))
     {
         Seek_TimeStamp=AV_NOPTS_VALUE;
+
+        // Background decoding for the display cache, the frame is not sent to the outputs
+        if (DisplayCache_IsFilling && InputData->Type==AVMEDIA_TYPE_VIDEO)
+        {
+            DisplayCache_Add(InputData->Decoder_FramePos++, av_frame_clone(Frame));
+            return true;
+        }
         int64_t ts=(Frame->pkt_pts==AV_NOPTS_VALUE)?Frame->pkt_dts:Frame->pkt_pts;
+
+        // Segment, frames out of the segment are analyzed by the glue of the previous or next segment
+        if (Segment_Stream && ts!=AV_NOPTS_VALUE)
+        {
+            if (Segment_Start!=INT64_MIN && av_compare_ts(ts, InputData->Stream->time_base, Segment_Start, Segment_Stream->time_base)<0)
+            {
+                // Pre-roll: the filters which depend on the previous frames (idet, entropy diff, psnr/ssim, deflicker, audio windows) get the same history as in a sequential analysis
+                // Not with one frame out of N, the frames seen by the filters depend on the position
+                if (Decode && (Sampling_Mode!=Sampling_Stride || InputData->Type!=AVMEDIA_TYPE_VIDEO))
+                    for (size_t OutputPos=0; OutputPos<OutputDatas.size(); OutputPos++)
+                        if (OutputDatas[OutputPos] && OutputDatas[OutputPos]->Enabled && OutputDatas[OutputPos]->Stream==InputData->Stream && OutputDatas[OutputPos]->OutputMethod==Output_Stats && !OutputDatas[OutputPos]->Filter.empty())
+                            OutputDatas[OutputPos]->Process_Queue(Frame, true);
+                return false;
+            }
+            if (Segment_End!=INT64_MAX && av_compare_ts(ts, InputData->Stream->time_base, Segment_End, Segment_Stream->time_base)>=0)
+            {
+                InputData->Segment_Done=true;
+                return false;
+            }
+        }
         if (ts!=AV_NOPTS_VALUE && ts<InputData->FirstTimeStamp*InputData->Stream->time_base.den/InputData->Stream->time_base.num)
             InputData->FirstTimeStamp=((double)ts)*InputData->Stream->time_base.num/InputData->Stream->time_base.den;
         
-        for (size_t OutputPos=0; OutputPos<OutputDatas.size(); OutputPos++)
-            if (OutputDatas[OutputPos] && OutputDatas[OutputPos]->Enabled && OutputDatas[OutputPos]->Stream==InputData->Stream)
-                OutputDatas[OutputPos]->Process(Frame);
+        // One frame out of N: other frames are decoded (needed for the next ones) but not sent to the outputs
+        bool IsSampled=!Decode || Sampling_Mode!=Sampling_Stride || InputData->Type!=AVMEDIA_TYPE_VIDEO || !(InputData->FramePos%Sampling_Stride);
+
+        if (IsSampled)
+            for (size_t OutputPos=0; OutputPos<OutputDatas.size(); OutputPos++)
+                if (OutputDatas[OutputPos] && OutputDatas[OutputPos]->Enabled && OutputDatas[OutputPos]->Stream==InputData->Stream)
+                    OutputDatas[OutputPos]->Process_Queue(Frame);
 
         if(Decode)
             InputData->FramePos++;
@@ -1076,6 +1765,10 @@ bool FFmpeg_Glue::OutputFrame(AVPacket* TempPacket, bool Decode)
         return true;
     }
 
+    // Frames before the wanted one after a seek, kept for stepping backward
+    if (got_frame && DisplayCache_MaxBytes && InputData->Type==AVMEDIA_TYPE_VIDEO)
+        DisplayCache_Pending_Add(av_frame_clone(Frame));
+
     return false;
 }
 
@@ -1183,29 +1876,465 @@ void FFmpeg_Glue::Scale_Change(int Scale_Width_, int Scale_Height_, int index /*
 }
 
 //---------------------------------------------------------------------------
-void FFmpeg_Glue::Thumbnails_Modulo_Change(size_t Modulo)
+std::vector<int64_t> FFmpeg_Glue::SegmentsStart_Get(size_t Count)
+{
+    std::vector<int64_t> SegmentsStart;
+
+    // Only seekable files, with a reference video stream, are split (packets only are read at disk speed, no need to split)
+    if (Count<2 || PacketsOnly || !FormatContext || !FormatContext->pb || !FormatContext->pb->seekable || FileName=="pipe:0")
+        return SegmentsStart;
+    size_t StreamPos=0;
+    while (StreamPos<InputDatas.size() && (!InputDatas[StreamPos] || InputDatas[StreamPos]->Type!=AVMEDIA_TYPE_VIDEO))
+        StreamPos++;
+    if (StreamPos>=InputDatas.size())
+        return SegmentsStart;
+    AVStream* Stream=InputDatas[StreamPos]->Stream;
+    int64_t StartTime=(Stream->start_time!=AV_NOPTS_VALUE)?Stream->start_time:0;
+    int64_t Duration=Stream->duration;
+    if (Duration==AV_NOPTS_VALUE || Duration<=0)
+        Duration=(int64_t)(InputDatas[StreamPos]->Duration*Stream->time_base.den/Stream->time_base.num);
+    if (Duration<=0)
+        return SegmentsStart;
+
+    // Scanning is done on a separate context, the main one stays at the beginning of the file
+    AVFormatContext* ScanContext=NULL;
+    if (avformat_open_input(&ScanContext, FileName.c_str(), NULL, NULL)<0)
+        return SegmentsStart;
+    if (avformat_find_stream_info(ScanContext, NULL)<0 || StreamPos>=ScanContext->nb_streams)
+    {
+        avformat_close_input(&ScanContext);
+        return SegmentsStart;
+    }
+
+    // Segments start at the first key frame after the theoretical split point
+    AVPacket ScanPacket;
+    av_init_packet(&ScanPacket);
+    ScanPacket.data=NULL;
+    ScanPacket.size=0;
+    for (size_t Pos=1; Pos<Count; Pos++)
+    {
+        int64_t TimeStamp=StartTime+Duration/Count*Pos;
+        if (avformat_seek_file(ScanContext, StreamPos, INT64_MIN, TimeStamp, TimeStamp, 0)<0)
+            continue;
+        while (av_read_frame(ScanContext, &ScanPacket)>=0)
+        {
+            bool IsFound=false;
+            if (ScanPacket.stream_index==StreamPos && (ScanPacket.flags&AV_PKT_FLAG_KEY))
+            {
+                int64_t ts=(ScanPacket.pts==AV_NOPTS_VALUE)?ScanPacket.dts:ScanPacket.pts;
+                if (ts!=AV_NOPTS_VALUE && ts>=TimeStamp)
+                {
+                    if (ts>StartTime && (SegmentsStart.empty() || ts>SegmentsStart.back()))
+                        SegmentsStart.push_back(ts);
+                    IsFound=true;
+                }
+            }
+            av_packet_unref(&ScanPacket);
+            if (IsFound)
+                break;
+        }
+    }
+    avformat_close_input(&ScanContext);
+
+    return SegmentsStart;
+}
+
+//---------------------------------------------------------------------------
+// Seconds decoded and filtered before the start of a segment, as long as the
+// longest filter window (ebur128 short term loudness)
+static const double Segment_PreRoll=3;
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Segment_Set(int64_t Start, int64_t End)
+{
+    QMutexLocker locker(mutex);
+
+    Segment_Stream=NULL;
+    size_t StreamPos=0;
+    while (StreamPos<InputDatas.size() && (!InputDatas[StreamPos] || InputDatas[StreamPos]->Type!=AVMEDIA_TYPE_VIDEO))
+        StreamPos++;
+    if (!FormatContext || StreamPos>=InputDatas.size())
+        return;
+
+    Segment_Stream=InputDatas[StreamPos]->Stream;
+    Segment_Start=Start;
+    Segment_End=End;
+    for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
+        if (InputDatas[Pos])
+            InputDatas[Pos]->Segment_Done=false;
+
+    // Decoding starts at the last key frame at least Segment_PreRoll seconds before the start, for the pre-roll of the filters
+    if (Segment_Start!=INT64_MIN)
+    {
+        int64_t PreRoll_Start=Segment_Start-av_rescale_q((int64_t)(Segment_PreRoll*AV_TIME_BASE), AV_TIME_BASE_Q, Segment_Stream->time_base);
+        avformat_seek_file(FormatContext, StreamPos, INT64_MIN, PreRoll_Start, PreRoll_Start, 0);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool FFmpeg_Glue::Segment_IsComplete()
+{
+    for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
+        if (InputDatas[Pos] && InputDatas[Pos]->Enabled && !InputDatas[Pos]->Segment_Done && (!Stats || Stats->empty() || (Pos<Stats->size() && (*Stats)[Pos])))
+            return false;
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Segment_Append(FFmpeg_Glue* Segment)
 {
     QMutexLocker locker(mutex);
 
+    for (size_t Pos=0; Pos<InputDatas.size() && Pos<Segment->InputDatas.size(); Pos++)
+        if (InputDatas[Pos] && Segment->InputDatas[Pos])
+        {
+            InputDatas[Pos]->FramePos+=Segment->InputDatas[Pos]->FramePos;
+            if (InputDatas[Pos]->FramePos>InputDatas[Pos]->FrameCount)
+                InputDatas[Pos]->FrameCount=InputDatas[Pos]->FramePos;
+        }
+
+    for (size_t Pos=0; Pos<OutputDatas.size() && Pos<Segment->OutputDatas.size(); Pos++)
+    {
+        outputdata* OutputData=OutputDatas[Pos];
+        outputdata* SegmentData=Segment->OutputDatas[Pos];
+        if (OutputData && SegmentData && OutputData->OutputMethod==Output_Jpeg && SegmentData->OutputMethod==Output_Jpeg)
+            OutputData->Thumbnails.Append(SegmentData->Thumbnails);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool FFmpeg_Glue::Resume_IsPossible()
+{
+    // Same constraints as segments: seekable file with a reference video stream
+    if (PacketsOnly || !FormatContext || !FormatContext->pb || !FormatContext->pb->seekable || FileName=="pipe:0")
+        return false;
+    for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
+        if (InputDatas[Pos] && InputDatas[Pos]->Type==AVMEDIA_TYPE_VIDEO)
+            return true;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Resume_Set(int64_t Start)
+{
+    Segment_Set(Start, INT64_MAX);
+
+    QMutexLocker locker(mutex);
+
+    // Positions continue after the frames already in the stats
+    for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
+        if (InputDatas[Pos])
+        {
+            size_t Count=(Stats && Pos<Stats->size() && (*Stats)[Pos])?(*Stats)[Pos]->x_Current:0;
+            InputDatas[Pos]->FramePos=Count;
+            if (InputDatas[Pos]->FrameCount<Count)
+                InputDatas[Pos]->FrameCount=Count;
+        }
+
     for (size_t Pos=0; Pos<OutputDatas.size(); Pos++)
     {
         outputdata* OutputData=OutputDatas[Pos];
+        if (!OutputData)
+            continue;
 
-        if (OutputData)
+        size_t StreamPos=0;
+        while (StreamPos<InputDatas.size() && (!InputDatas[StreamPos] || InputDatas[StreamPos]->Stream!=OutputData->Stream))
+            StreamPos++;
+        if (StreamPos>=InputDatas.size())
+            continue;
+        OutputData->FramePos=InputDatas[StreamPos]->FramePos;
+
+        // Thumbnails of the frames already analyzed are not available, empty ones are used
+        if (OutputData->OutputMethod==Output_Jpeg)
+            while (OutputData->Thumbnails.Size()<OutputData->FramePos)
+                OutputData->Thumbnails.Add(NULL);
+    }
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::DecoderThreadCount_Set(int DecoderThreadCount)
+{
+    QMutexLocker locker(mutex);
+
+    for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
+    {
+        inputdata* InputData=InputDatas[Pos];
+        if (!InputData || !avcodec_is_open(InputData->Stream->codec) || InputData->Stream->codec->thread_count==DecoderThreadCount)
+            continue;
+
+        // Thread type is kept
+        AVCodec* Codec=avcodec_find_decoder(InputData->Stream->codec->codec_id);
+        avcodec_close(InputData->Stream->codec);
+        InputData->Stream->codec->thread_count=DecoderThreadCount;
+        if (Codec)
+            avcodec_open2(InputData->Stream->codec, Codec, NULL);
+    }
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Pipeline_Set(bool Enable)
+{
+    QMutexLocker locker(mutex);
+
+    for (size_t Pos=0; Pos<OutputDatas.size(); Pos++)
+    {
+        outputdata* OutputData=OutputDatas[Pos];
+        if (!OutputData)
+            continue;
+
+        // Only outputs not read back by the caller after each frame
+        // Thumbnails stay on the decoding thread: they are read by the UI during the analysis, with the glue mutex which the decoding thread holds
+        if (Enable && !OutputData->Thread && OutputData->OutputMethod==Output_Stats && OutputData->Stats)
         {
-            OutputData->Thumbnails_Modulo=Modulo;
-            size_t Thumbnails_Size=OutputData->Thumbnails.size();
-            for (size_t Pos = 0; Pos < Thumbnails_Size; Pos++)
-            {
-                if (Pos%Modulo)
-                    continue;
+            OutputData->Thread=new outputthread(OutputData);
+            OutputData->Thread->start();
+        }
+        else if (!Enable && OutputData->Thread)
+        {
+            OutputData->Thread->WaitIdle();
+            delete OutputData->Thread;
+            OutputData->Thread=NULL;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Pipeline_Flush()
+{
+    for (size_t Pos=0; Pos<OutputDatas.size(); Pos++)
+        if (OutputDatas[Pos] && OutputDatas[Pos]->Thread)
+            OutputDatas[Pos]->Thread->WaitIdle();
+}
+
+//---------------------------------------------------------------------------
+std::vector<size_t> FFmpeg_Glue::Pipeline_QueuesSize_Get() const
+{
+    QMutexLocker locker(mutex);
+
+    std::vector<size_t> Sizes;
+    for (size_t Pos=0; Pos<OutputDatas.size(); Pos++)
+        Sizes.push_back((OutputDatas[Pos] && OutputDatas[Pos]->Thread)?OutputDatas[Pos]->Thread->Queue_Size():0);
+    return Sizes;
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Sampling_Set(samplingmode Mode, int Stride)
+{
+    QMutexLocker locker(mutex);
+
+    Sampling_Mode=(Mode==Sampling_Stride && Stride<2)?Sampling_All:Mode;
+    Sampling_Stride=Stride>1?Stride:1;
+
+    for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
+        if (InputDatas[Pos] && InputDatas[Pos]->Type==AVMEDIA_TYPE_VIDEO)
+        {
+            // Decoder drops non key frames too, in case the container does not flag key frames
+            InputDatas[Pos]->Stream->codec->skip_frame=(Sampling_Mode==Sampling_KeyFrames)?AVDISCARD_NONKEY:AVDISCARD_DEFAULT;
+            if (Stats && Pos<Stats->size() && (*Stats)[Pos])
+                (*Stats)[Pos]->Sampled_Set(Sampling_Mode!=Sampling_All);
+        }
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Thumbnails_Tiles_Set(int Side)
+{
+    QMutexLocker locker(mutex);
+
+    for (size_t Pos=0; Pos<OutputDatas.size(); Pos++)
+        if (OutputDatas[Pos] && OutputDatas[Pos]->OutputMethod==Output_Jpeg && OutputDatas[Pos]->Thumbnails.Size()==0)
+            OutputDatas[Pos]->Tiles_Side=Side>1?Side:0;
+}
+
+//***************************************************************************
+// Display cache
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static size_t Frame_Bytes(const AVFrame* Frame)
+{
+    int Size=av_image_get_buffer_size((AVPixelFormat)Frame->format, Frame->width, Frame->height, 1);
+    return Size>0?Size:0;
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::DisplayCache_Set(size_t MaxBytes)
+{
+    cachethread* Thread=NULL;
+    {
+        QMutexLocker CacheLocker(&DisplayCache_Mutex);
+
+        DisplayCache_MaxBytes=FormatContext?MaxBytes:0; // Not with the frames of another instance
+        if (!DisplayCache_MaxBytes)
+        {
+            DisplayCache_Clear();
+            Thread=DisplayCache_Thread;
+            DisplayCache_Thread=NULL;
+        }
+        else if (!DisplayCache_Thread && mutex) // Background decoding only if FrameAtPosition() and the other methods are thread safe
+        {
+            DisplayCache_Thread=new cachethread(this);
+            DisplayCache_Thread->start();
+        }
+    }
+
+    // Outside of the lock, the thread may wait for it
+    delete Thread;
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::DisplayCache_Add(size_t FramePos, AVFrame* Frame)
+{
+    if (!Frame)
+        return;
+
+    std::map<size_t, AVFrame*>::iterator Item=DisplayCache.find(FramePos);
+    if (Item!=DisplayCache.end())
+    {
+        DisplayCache_Bytes-=Frame_Bytes(Item->second);
+        av_frame_free(&Item->second);
+        DisplayCache.erase(Item);
+    }
+    DisplayCache[FramePos]=Frame;
+    DisplayCache_Bytes+=Frame_Bytes(Frame);
+
+    // Ring around the displayed frame, the farthest frames are removed first
+    while (DisplayCache_Bytes>DisplayCache_MaxBytes && !DisplayCache.empty())
+    {
+        std::map<size_t, AVFrame*>::iterator First=DisplayCache.begin();
+        std::map<size_t, AVFrame*>::iterator Last=--DisplayCache.end();
+        size_t First_Distance=First->first<DisplayCache_Current?(DisplayCache_Current-First->first):(First->first-DisplayCache_Current);
+        size_t Last_Distance=Last->first<DisplayCache_Current?(DisplayCache_Current-Last->first):(Last->first-DisplayCache_Current);
+        Item=First_Distance>=Last_Distance?First:Last;
+        DisplayCache_Bytes-=Frame_Bytes(Item->second);
+        av_frame_free(&Item->second);
+        DisplayCache.erase(Item);
+    }
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::DisplayCache_Pending_Add(AVFrame* Frame)
+{
+    // NULL resets the list, before and after each search of a frame
+    if (!Frame)
+    {
+        for (size_t Pos=0; Pos<DisplayCache_Pending.size(); Pos++)
+            av_frame_free(&DisplayCache_Pending[Pos]);
+        DisplayCache_Pending.clear();
+        return;
+    }
 
-                OutputData->Thumbnails[Pos].reset();
+    // Only the frames just before the wanted one are useful, up to half of the cache
+    size_t Bytes=Frame_Bytes(Frame);
+    if (Bytes && DisplayCache_Pending.size()>=DisplayCache_MaxBytes/2/Bytes)
+    {
+        if (DisplayCache_Pending.empty())
+        {
+            av_frame_free(&Frame);
+            return;
+        }
+        av_frame_free(&DisplayCache_Pending.front());
+        DisplayCache_Pending.erase(DisplayCache_Pending.begin());
+    }
+    DisplayCache_Pending.push_back(Frame);
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::DisplayCache_Clear()
+{
+    for (std::map<size_t, AVFrame*>::iterator Item=DisplayCache.begin(); Item!=DisplayCache.end(); ++Item)
+        av_frame_free(&Item->second);
+    DisplayCache.clear();
+    DisplayCache_Bytes=0;
+    DisplayCache_Pending_Add(NULL);
+}
+
+//---------------------------------------------------------------------------
+bool FFmpeg_Glue::DisplayCache_FillNext()
+{
+    QMutexLocker CacheLocker(&DisplayCache_Mutex);
+
+    if (!DisplayCache_MaxBytes)
+        return false;
+
+    inputdata* InputData=NULL;
+    for (size_t Pos=0; Pos<InputDatas.size() && !InputData; Pos++)
+        if (InputDatas[Pos] && InputDatas[Pos]->Type==AVMEDIA_TYPE_VIDEO)
+            InputData=InputDatas[Pos];
+    if (!InputData || InputData->Decoder_FramePos==(size_t)-1 || InputData->Decoder_FramePos<=DisplayCache_Current)
+        return false;
+
+    // Frames after the displayed one use up to half of the cache, the other half is for the previous frames
+    size_t Bytes_After=0;
+    for (std::map<size_t, AVFrame*>::iterator Item=DisplayCache.upper_bound(DisplayCache_Current); Item!=DisplayCache.end(); ++Item)
+        Bytes_After+=Frame_Bytes(Item->second);
+    if (Bytes_After>=DisplayCache_MaxBytes/2)
+        return false;
+
+    DisplayCache_IsFilling=true;
+    bool IsDecoded=NextFrame();
+    DisplayCache_IsFilling=false;
+    if (!IsDecoded)
+        InputData->Decoder_FramePos=(size_t)-1; // End of the stream, a seek is needed
+    return IsDecoded;
+}
+
+//---------------------------------------------------------------------------
+void FFmpeg_Glue::Profiler_Set(Profiler* Value)
+{
+    QMutexLocker locker(mutex);
+
+    Profile=Value;
+    Profiler_Items_Set();
+}
+
+//---------------------------------------------------------------------------
+// Decoders and filter graphs are profiled one by one, items with the same
+// name (e.g. from the glues of the other segments) are merged
+void FFmpeg_Glue::Profiler_Items_Set()
+{
+    for (size_t Pos=0; Pos<InputDatas.size(); Pos++)
+    {
+        inputdata* InputData=InputDatas[Pos];
+        if (!InputData)
+            continue;
+
+        if (Profile && InputData->Stream)
+        {
+            stringstream Name;
+            Name<<"stream "<<Pos<<" ("<<avcodec_get_name(InputData->Stream->codec->codec_id)<<")";
+            InputData->Profile_Item=Profile->Item_Get(ProfilerStage_Decode, Name.str());
+        }
+        else
+            InputData->Profile_Item=(size_t)-1;
+    }
+
+    for (size_t Pos=0; Pos<OutputDatas.size(); Pos++)
+    {
+        outputdata* OutputData=OutputDatas[Pos];
+        if (!OutputData)
+            continue;
+
+        OutputData->Profile=Profile;
+        if (Profile && OutputData->Stream && !OutputData->Filter.empty())
+        {
+            stringstream Name;
+            Name<<"output "<<Pos<<": stream "<<OutputData->Stream->index;
+            switch (OutputData->OutputMethod)
+            {
+                case Output_QImage  : Name<<" display"; break;
+                case Output_Jpeg    : Name<<" thumbnails"; break;
+                case Output_Stats   : Name<<" stats"; break;
+                default             : ;
             }
+            OutputData->Profile_Item=Profile->Item_Get(ProfilerStage_Filter, Name.str());
         }
+        else
+            OutputData->Profile_Item=(size_t)-1;
     }
 }
 
+//---------------------------------------------------------------------------
 size_t FFmpeg_Glue::TotalFramesCountPerAllStreams() const
 {
     QMutexLocker locker(mutex);
@@ -1232,7 +2361,7 @@ size_t FFmpeg_Glue::TotalFramesProcessedPerAllStreams() const
         if(!InputDatas.at(i))
             continue;
 
-        totalFramesProcessed += InputDatas.at(i)->FramePos;
+        totalFramesProcessed += InputDatas.at(i)->FramePos + InputDatas.at(i)->FramesSkipped;
     }
 
     return totalFramesProcessed;
@@ -1255,7 +2384,7 @@ size_t FFmpeg_Glue::FramesProcessedPerStream(size_t index) const
     if(!InputDatas.at(index))
         return 0;
 
-    return InputDatas.at(index)->FramePos;
+    return InputDatas.at(index)->FramePos + InputDatas.at(index)->FramesSkipped;
 }
 
 std::vector<size_t> FFmpeg_Glue::FramesCountForAllStreams() const
@@ -1288,7 +2417,7 @@ std::vector<size_t> FFmpeg_Glue::FramesProcessedForAllStreams() const
         if(!InputDatas.at(i))
             continue;
 
-        totalFramesProcessedPerStream.push_back(InputDatas.at(i)->FramePos);
+        totalFramesProcessedPerStream.push_back(InputDatas.at(i)->FramePos + InputDatas.at(i)->FramesSkipped);
     }
 
     return totalFramesProcessedPerStream;
@@ -1480,6 +2609,12 @@ bool FFmpeg_Glue::withStats() const
     return WithStats;
 }
 
+//---------------------------------------------------------------------------
+bool FFmpeg_Glue::packetsOnly() const
+{
+    return PacketsOnly;
+}
+
 //---------------------------------------------------------------------------
 size_t FFmpeg_Glue::VideoFrameCount_Get()
 {
@@ -9,10 +9,12 @@
 #define FFmpeg_Glue_H
 
 #include "Core/Core.h"
+#include "Core/ThumbnailStore.h"
 
 #include <string>
 #include <vector>
 #include <memory>
+#include <map>
 #include <stdint.h>
 #include <QByteArray>
 #include <QMutex>
@@ -36,6 +38,7 @@ struct AVFilterInOut;
 class CommonStats;
 class StreamsStats;
 class FormatStats;
+class Profiler;
 
 class FFmpeg_Glue
 {
@@ -48,7 +51,7 @@ public:
         Output_Jpeg,
         Output_Stats,
     };
-    FFmpeg_Glue(const string &FileName, activealltracks ActiveAllTracks, std::vector<CommonStats*>* Stats, StreamsStats** streamsStats, FormatStats** formatStats, bool WithStats=false);
+    FFmpeg_Glue(const string &FileName, activealltracks ActiveAllTracks, std::vector<CommonStats*>* Stats, StreamsStats** streamsStats, FormatStats** formatStats, bool WithStats=false, decoderthreading DecoderThreading=DecoderThreading_Auto, int DecoderThreadCount=1, bool PacketsOnly=false);
     ~FFmpeg_Glue();
 
     typedef std::shared_ptr<AVFrame> AVFramePtr;
@@ -92,6 +95,7 @@ public:
 
     AVPacket*                   ThumbnailPacket_Get(size_t Pos, size_t FramePos);
     QByteArray                  Thumbnail_Get(size_t Pos, size_t FramePos);
+    QByteArray                  ThumbnailTile_Get(size_t Pos, size_t FramePos, thumbnailtile& Tile); // Whole sprite sheet holding the thumbnail, a single cell if not in a sheet
     size_t                      Thumbnails_Size(size_t Pos);
     
     // Status
@@ -101,6 +105,7 @@ public:
     std::vector<CommonStats*>*  Stats;
 
     bool                        withStats() const;
+    bool                        packetsOnly() const; // Stats are filled from the packets, without decoding (no filter, no image)
     // Container information
     string                      ContainerFormat_Get();
     int                         StreamCount_Get();
@@ -170,7 +175,36 @@ public:
     void                        Disable(const size_t Pos);
     double                      TimeStampOfCurrentFrame(size_t OutputPos);
     void                        Scale_Change(int Scale_Width, int Scale_Height, int index = -1 /* scale both left & right by default */);
-    void                        Thumbnails_Modulo_Change(size_t Modulo);
+
+    // Segments (parallel analysis of parts of a single file)
+    std::vector<int64_t>        SegmentsStart_Get(size_t Count);
+    void                        Segment_Set(int64_t Start, int64_t End); // In reference video stream time base, INT64_MIN or INT64_MAX if no limit, frames before Start are only a pre-roll of the filters
+    void                        Segment_Append(FFmpeg_Glue* Segment);
+
+    // Resume (analysis restarted from a checkpoint, frames before the start are already in the stats)
+    bool                        Resume_IsPossible();
+    void                        Resume_Set(int64_t Start); // In reference video stream time base, stats must be filled up to this time stamp
+
+    // Decoder threads, decoders are opened again with the new count (before the first decoded frame)
+    void                        DecoderThreadCount_Set(int DecoderThreadCount);
+
+    // Pipeline (filtering and stats of each output on its own thread, decoding and thumbnails stay on the caller thread)
+    void                        Pipeline_Set(bool Enable);
+    void                        Pipeline_Flush(); // Waits for the output threads, between 2 calls of NextFrame()
+    std::vector<size_t>         Pipeline_QueuesSize_Get() const; // Count of decoded frames waiting, per output
+
+    // Sampling (only some video frames are analyzed, for a quick triage), audio is fully analyzed
+    void                        Sampling_Set(samplingmode Mode, int Stride=1);
+
+    // Thumbnails grouped in sprite sheets of Side x Side frames (one JPEG encoding per sheet), 0 for one JPEG per frame
+    void                        Thumbnails_Tiles_Set(int Side);
+
+    // Profiling (time spent per stage, per decoder and per filter graph), NULL for no profiling
+    void                        Profiler_Set(Profiler* Value);
+
+    // Decoded frames around the displayed one (FrameAtPosition), so stepping needs only filtering and scaling
+    // Frames decoded before the wanted one after a seek are kept, next ones are decoded in the background if thread safe
+    void                        DisplayCache_Set(size_t MaxBytes); // 0 for no cache
 
     size_t                      TotalFramesCountPerAllStreams() const;
     size_t                      TotalFramesProcessedPerAllStreams() const;
@@ -215,6 +249,9 @@ private:
 
         // Status
         size_t                  FramePos;               // Current position of playback
+        size_t                  Decoder_FramePos;       // Next frame output by the decoder when frames are displayed (FrameAtPosition), (size_t)-1 if unknown
+        size_t                  FramesSkipped;          // Packets not decoded (key frames sampling), for the progress
+        bool                    Segment_Done;           // End of the segment is reached
         
         // General information
         size_t                  FrameCount;             // Total count of frames (may be estimated)
@@ -225,7 +262,11 @@ private:
         // Cache
         std::vector<AVFrame*>*  FramesCache;
         AVFrame*                FramesCache_Default;
+
+        // Performance
+        size_t                  Profile_Item;           // Decoder
     };
+    class outputthread;
     struct outputdata
     {
         // Constructor / Destructor
@@ -233,7 +274,8 @@ private:
         ~outputdata();
         
         //Actions
-        void                    Process(AVFrame* DecodedFrame);
+        void                    Process(AVFrame* DecodedFrame, bool IsPreRoll=false); // Pre-roll: only the filter history is filled, nothing is output
+        void                    Process_Queue(AVFrame* DecodedFrame, bool IsPreRoll=false); // Process, on the output thread if any
         void                    ApplyFilter(const AVFramePtr& sourceFrame);
         void                    ApplyScale(const AVFramePtr& sourceFrame);
         void                    ReplaceImage();
@@ -272,16 +314,36 @@ private:
             void operator()(AVPacket* packet);
         };
 
-        std::vector<std::unique_ptr<AVPacket, AVPacketDeleter>>  Thumbnails;
-        size_t                  Thumbnails_Modulo;
+        ThumbnailStore          Thumbnails;
+
+        // Sprite sheets
+        int                     Tiles_Side;             // Count of columns and rows, 0 for one JPEG per frame
+        AVFramePtr              Tile;                   // Sheet being filled
+        std::vector<int64_t>    Tile_Pts;               // Frames in the sheet being filled
+        AVCodecContext*         TileOutput_CodecContext;
+        AVCodecContext*         TileInput_CodecContext; // Decoding of a sheet, for a single thumbnail
+        AVFramePtr              TileDecoded;
+        size_t                  TileDecoded_FirstFrame;
+        std::unique_ptr<AVPacket, AVPacketDeleter> TileExtracted;
         CommonStats*            Stats;
 
+        // Pipeline
+        outputthread*           Thread;
+        Profiler*               Profile;
+        size_t                  Profile_Item;           // Filter graph
+
         // Status
         size_t                  FramePos;               // Current position of playback
         double                  TimeStamp;              // Current position of playback
 
         // Helpers
         bool                    InitThumnails();
+        bool                    InitTiles();
+        void                    AddToTile();
+        void                    FlushTile();
+        AVPacket*               Thumbnail_Get(size_t FramePos); // JPEG of a single frame, extracted from its sheet if needed, valid until the next call
+        int                     Tile_CellWidth() const {return (Width+1)&~1;} // Cells are aligned on chroma samples
+        int                     Tile_CellHeight() const {return (Height+1)&~1;}
         bool                    FilterGraph_Init();
         void                    FilterGraph_Free();
         bool                    Scale_Init();
@@ -304,9 +366,44 @@ private:
     // In
     string                      FileName;
     bool                        WithStats;
+    bool                        PacketsOnly;
 
     // Seek
     int64_t                     Seek_TimeStamp;
+    std::vector<size_t>         SeekIndex;              // Key frames of the video stats, built from the stats (key_frame, pkt_pts and pkt_pos are in the reports)
+    size_t                      SeekIndex_Scanned;      // Count of frames of the stats already in SeekIndex
+    size_t                      SeekIndex_KeyFrame(CommonStats* Video, size_t FramePos); // Last key frame at or before FramePos, (size_t)-1 if none
+
+    // Sampling
+    samplingmode                Sampling_Mode;
+    int                         Sampling_Stride;
+
+    // Display cache
+    class cachethread;
+    cachethread*                DisplayCache_Thread;
+    QMutex                      DisplayCache_Mutex;     // FrameAtPosition() and background decoding
+    std::map<size_t, AVFrame*>  DisplayCache;           // Decoded frames, per frame position
+    std::vector<AVFrame*>       DisplayCache_Pending;   // Frames decoded before the wanted one, their position is known when the wanted one is found
+    size_t                      DisplayCache_Bytes;
+    size_t                      DisplayCache_MaxBytes;
+    size_t                      DisplayCache_Current;   // Displayed frame
+    bool                        DisplayCache_IsFilling; // Decoded frames go to the cache, not to the outputs
+    void                        DisplayCache_Add(size_t FramePos, AVFrame* Frame); // Frame is owned by the cache
+    void                        DisplayCache_Pending_Add(AVFrame* Frame);
+    void                        DisplayCache_Clear();
+    bool                        DisplayCache_FillNext(); // Decodes the frame after the decoder position, false if nothing to do
+
+    // Profiling
+    Profiler*                   Profile;
+    void                        Profiler_Items_Set();
+    int                         Packet_Read();
+    bool                        NextPacket();
+
+    // Segment
+    AVStream*                   Segment_Stream;
+    int64_t                     Segment_Start;
+    int64_t                     Segment_End;
+    bool                        Segment_IsComplete();
 
 	friend int DecodeVideo(FFmpeg_Glue::inputdata* InputData, AVFrame* Frame, int & got_frame, AVPacket* TempPacket);
 
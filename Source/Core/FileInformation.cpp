@@ -6,12 +6,17 @@
 
 //---------------------------------------------------------------------------
 #include "Core/FileInformation.h"
+#include "Core/AnalysisScheduler.h"
 #include "Core/SignalServer.h"
 #include "Core/FFmpeg_Glue.h"
 #include "Core/VideoStats.h"
 #include "Core/AudioStats.h"
 #include "Core/FormatStats.h"
 #include "Core/StreamsStats.h"
+#include "Core/StatsBinary.h"
+#include "Core/XmlPullParser.h"
+#include "Core/ExportWriter.h"
+#include "Core/StatsXmlBuffer.h"
 
 #include "FFmpegVideoEncoder.h"
 
@@ -23,9 +28,22 @@
 #include <QUrl>
 #include <QBuffer>
 #include <QPair>
+#include <QElapsedTimer>
 #include <zlib.h>
 #include <zconf.h>
 
+extern "C"
+{
+#ifndef INT64_C
+#define INT64_C(c) (c ## LL)
+#define UINT64_C(c) (c ## ULL)
+#endif
+
+#include <libavutil/avutil.h>
+}
+
+#include <cfloat>
+#include <climits>
 #include <cmath>
 #include <string>
 #include <sstream>
@@ -36,10 +54,96 @@
     #include <algorithm>
 #endif
 
+//***************************************************************************
+// Parallel segments
+//***************************************************************************
+static int ParallelSegments_Count=1;
+
+void FileInformation::setParallelSegmentsCount(int Count)
+{
+    ParallelSegments_Count=Count>1?Count:1;
+}
+
+class SegmentParser : public QThread
+{
+public:
+    SegmentParser(const bool& WantToStop_) : Glue(NULL), WantToStop(WantToStop_) {}
+
+    FFmpeg_Glue*                Glue;
+    std::vector<CommonStats*>   Stats;
+
+private:
+    void run()
+    {
+        while (!WantToStop && Glue->NextFrame())
+            yieldCurrentThread();
+    }
+
+    const bool&                 WantToStop;
+};
+
 //***************************************************************************
 // Simultaneous parsing
 //***************************************************************************
-static int ActiveParsing_Count=0;
+static decoderthreading DecoderThreading_Type=DecoderThreading_Auto;
+static int DecoderThreading_Count=0;
+
+void FileInformation::setDecoderThreading(decoderthreading Type, int Count)
+{
+    DecoderThreading_Type=Type;
+    DecoderThreading_Count=Count>0?Count:0;
+}
+
+//***************************************************************************
+// Checkpoints
+//***************************************************************************
+static int Checkpoint_Interval=0;
+
+void FileInformation::setCheckpointInterval(int Seconds)
+{
+    Checkpoint_Interval=Seconds>0?Seconds:0;
+}
+
+//***************************************************************************
+// Sampling
+//***************************************************************************
+static samplingmode Sampling_Mode=Sampling_All;
+static int Sampling_Stride=1;
+
+void FileInformation::setSampling(samplingmode Mode, int Stride)
+{
+    Sampling_Mode=Mode;
+    Sampling_Stride=Stride>1?Stride:1;
+}
+
+//***************************************************************************
+// Packets only
+//***************************************************************************
+static bool PacketsOnly_IsEnabled=false;
+
+void FileInformation::setPacketsOnly(bool Enable)
+{
+    PacketsOnly_IsEnabled=Enable;
+}
+
+//***************************************************************************
+// Sprite sheets
+//***************************************************************************
+static int Thumbnails_Tiles=0;
+
+void FileInformation::setThumbnailsTiles(int Side)
+{
+    Thumbnails_Tiles=Side>1?Side:0;
+}
+
+static int DecoderThreadCount_Get()
+{
+    if (DecoderThreading_Count)
+        return DecoderThreading_Count;
+
+    // Cores are shared between the files being parsed and the segments of this file
+    return AnalysisScheduler::instance()->decoderThreadCount(ParallelSegments_Count);
+}
 
 void FileInformation::run()
 {
@@ -55,6 +159,13 @@ void FileInformation::run()
 
 void FileInformation::runParse()
 {
+    // Share of the cores with the jobs running when this one starts, not when the file was opened
+    if (Glue && !DecoderThreading_Count)
+    {
+        Glue_DecoderThreadCount=DecoderThreadCount_Get();
+        Glue->DecoderThreadCount_Set(Glue_DecoderThreadCount);
+    }
+
     if(signalServer->enabled() && m_autoCheckFileUploaded)
     {
         QString statsFileName = fileName() + ".qctools.xml.gz";
@@ -63,9 +174,22 @@ void FileInformation::runParse()
         checkFileUploaded(fileInfo.fileName());
     }
 
+    // Parts of the file are analyzed in parallel if requested and possible
+    std::vector<int64_t> SegmentsStart;
+    if (Glue && Glue->withStats() && ParallelSegments_Count>1 && !Stats.empty() && !Checkpoint_IsResumed)
+        SegmentsStart=Glue->SegmentsStart_Get(ParallelSegments_Count);
+
+    if (!SegmentsStart.empty())
+        runParseSegments(SegmentsStart);
+    else
     {
         int frameNumber = 1;
 
+        // Analyzed frames are regularly saved, so an interrupted analysis can be resumed
+        bool Checkpoint_IsEnabled=Checkpoint_Interval && Glue && Glue->withStats() && Glue->Resume_IsPossible();
+        QElapsedTimer Checkpoint_Timer;
+        Checkpoint_Timer.start();
+
         for (;;)
         {
             if (Glue)
@@ -74,6 +198,12 @@ void FileInformation::runParse()
                     break;
 
                 ++frameNumber;
+
+                if (Checkpoint_IsEnabled && Checkpoint_Timer.elapsed()>=(qint64)Checkpoint_Interval*1000)
+                {
+                    Checkpoint_Write();
+                    Checkpoint_Timer.restart();
+                }
             }
             if (WantToStop)
                 break;
@@ -81,15 +211,251 @@ void FileInformation::runParse()
         }
     }
 
-    ActiveParsing_Count--;
     m_parsed = !WantToStop;
+    if (m_parsed && Glue && Glue->withStats())
+        QFile::remove(FileName + ".qctools.part"); // Not needed anymore
+    AnalysisScheduler::instance()->finished(this);
 
     Q_EMIT parsingCompleted(WantToStop == false);
 }
 
+void FileInformation::runParseSegments(const std::vector<int64_t>& SegmentsStart)
+{
+    // Main glue analyzes the first segment, each other segment has its own glue and stats
+    std::vector<SegmentParser*> Segments;
+    for (size_t Pos=0; Pos<SegmentsStart.size(); Pos++)
+    {
+        SegmentParser* Segment=new SegmentParser(WantToStop);
+        for (size_t Stats_Pos=0; Stats_Pos<Stats.size(); Stats_Pos++)
+            Segment->Stats.push_back(Stats[Stats_Pos]?Stats[Stats_Pos]->Segment_Create(Stats[Stats_Pos]->x_Current_Max/(SegmentsStart.size()+1)+1, 0):NULL);
+        Segment->Glue=new FFmpeg_Glue(Glue_FileName, ActiveAllTracks, &Segment->Stats, NULL, NULL, false, DecoderThreading_Type, Glue_DecoderThreadCount);
+        Segment->Glue->Profiler_Set(&Profile);
+        Segment->Glue->Sampling_Set(Sampling_Mode, Sampling_Stride);
+        Segment->Glue->AddOutput(0, 72, 72, FFmpeg_Glue::Output_Jpeg);
+        Segment->Glue->Thumbnails_Tiles_Set(Thumbnails_Tiles);
+        Segment->Glue->AddOutput(1, 0, 0, FFmpeg_Glue::Output_Stats, 0, Glue_Filters[0]);
+        Segment->Glue->AddOutput(0, 0, 0, FFmpeg_Glue::Output_Stats, 1, Glue_Filters[1]);
+        Segment->Glue->Pipeline_Set(true);
+        Segment->Glue->Segment_Set(SegmentsStart[Pos], Pos+1<SegmentsStart.size()?SegmentsStart[Pos+1]:INT64_MAX);
+        Segment->start();
+        Segments.push_back(Segment);
+    }
+
+    Glue->Segment_Set(INT64_MIN, SegmentsStart[0]);
+    while (!WantToStop && Glue->NextFrame())
+        yieldCurrentThread();
+
+    // Stitching segments in file order
+    for (size_t Pos=0; Pos<Segments.size(); Pos++)
+    {
+        SegmentParser* Segment=Segments[Pos];
+        Segment->wait();
+        if (!WantToStop)
+        {
+            for (size_t Stats_Pos=0; Stats_Pos<Stats.size(); Stats_Pos++)
+                if (Stats[Stats_Pos] && Segment->Stats[Stats_Pos])
+                    Stats[Stats_Pos]->Data_Append(*Segment->Stats[Stats_Pos]);
+            Glue->Segment_Append(Segment->Glue);
+        }
+
+        delete Segment->Glue;
+        for (size_t Stats_Pos=0; Stats_Pos<Segment->Stats.size(); Stats_Pos++)
+            delete Segment->Stats[Stats_Pos];
+        delete Segment;
+    }
+
+    for (size_t Pos=0; Pos<Stats.size(); Pos++)
+        if (Stats[Pos])
+            Stats[Pos]->StatsFinish();
+}
+
+//---------------------------------------------------------------------------
+// Checkpoint file (.qctools.part): sequence of records, each record is its
+// size (64-bit) then a binary sidecar image with the frames analyzed since
+// the previous record, the time stamp of the video key frame the analysis
+// restarts from and the settings which change the stats.
+static void Checkpoint_Settings_Put(StatsBinaryBuffer& Checkpoint, const std::string Filters[Type_Max])
+{
+    for (size_t Type=0; Type<Type_Max; Type++)
+        Checkpoint.Put_String(Filters[Type].c_str());
+    Checkpoint.Put<uint8_t>(CommonStats::Lossless_Get()?1:0);
+    Checkpoint.Put<int32_t>(Sampling_Mode);
+    Checkpoint.Put<int32_t>(Sampling_Stride);
+}
+
+static bool Checkpoint_Settings_IsSame(StatsBinaryCursor& Checkpoint, const std::string Filters[Type_Max])
+{
+    for (size_t Type=0; Type<Type_Max; Type++)
+    {
+        string Value;
+        bool IsNull;
+        if (!Checkpoint.Get_String(Value, IsNull) || Value!=Filters[Type])
+            return false;
+    }
+    if (Checkpoint.Get<uint8_t>()!=(CommonStats::Lossless_Get()?1:0))
+        return false;
+    if (Checkpoint.Get<int32_t>()!=Sampling_Mode)
+        return false;
+    if (Checkpoint.Get<int32_t>()!=Sampling_Stride)
+        return false;
+    return Checkpoint.IsOk();
+}
+
+bool FileInformation::Checkpoint_Read(int64_t& Start)
+{
+    QFile File(FileName + ".qctools.part");
+    if (!File.open(QIODevice::ReadOnly))
+        return false;
+    qint64 FileSize=QFileInfo(FileName).size();
+
+    // One record in memory at a time
+    bool IsRead=false;
+    bool IsObsolete=false;
+    for (;;)
+    {
+        QByteArray Record_Size_Data=File.read(8);
+        if (Record_Size_Data.size()!=8)
+            break;
+        string Record_Header(Record_Size_Data.constData(), 8);
+        StatsBinaryCursor Record_Size(Record_Header);
+        uint64_t Size=Record_Size.Get<uint64_t>();
+        if (Size>(uint64_t)(File.size()-File.pos()) || Size>(uint64_t)INT_MAX)
+            break; // Incomplete record, the analysis was stopped while writing it
+        QByteArray Data=File.read((qint64)Size);
+        if ((uint64_t)Data.size()!=Size)
+            break;
+        StatsBinaryReader Reader;
+        if (!Reader.Open(Data.constData(), (size_t)Size))
+            break;
+
+        // The media file and the settings must be the ones which were used
+        string Raw;
+        if (!Reader.Block_Get(StatsBinary_Checkpoint, 0, 0, 0, Raw))
+            break;
+        StatsBinaryCursor Checkpoint(Raw);
+        int64_t Record_Start=Checkpoint.Get<int64_t>();
+        int64_t Record_FileSize=Checkpoint.Get<int64_t>();
+        if (!Checkpoint.IsOk() || Record_FileSize!=FileSize || !Checkpoint_Settings_IsSame(Checkpoint, Glue_Filters))
+        {
+            IsObsolete=!IsRead;
+            break;
+        }
+
+        // All streams are read before being appended, so a bad record does not leave stats out of sync
+        std::vector<CommonStats*> Segments(Stats.size());
+        bool IsOk=true;
+        uint32_t Stream=0;
+        for (size_t Pos=0; IsOk && Pos<Stats.size(); Pos++)
+        {
+            if (!Stats[Pos])
+                continue;
+            int Type;
+            size_t Count;
+            IsOk=Reader.Stream_Get(Stream, Type, Count) && Type==Stats[Pos]->Type_Get();
+            if (IsOk)
+            {
+                Segments[Pos]=Stats[Pos]->Segment_Create(Count+1, 0);
+                IsOk=Segments[Pos]->StatsFromBinary(Reader, Stream);
+            }
+            Stream++;
+        }
+        if (IsOk)
+        {
+            for (size_t Pos=0; Pos<Stats.size(); Pos++)
+                if (Segments[Pos])
+                    Stats[Pos]->Data_Append(*Segments[Pos]);
+            Start=Record_Start;
+            IsRead=true;
+        }
+        for (size_t Pos=0; Pos<Segments.size(); Pos++)
+            delete Segments[Pos];
+        if (!IsOk)
+            break;
+    }
+    File.close();
+    if (IsObsolete)
+        QFile::remove(FileName + ".qctools.part");
+
+    for (size_t Pos=0; Pos<Stats.size(); Pos++)
+        if (Stats[Pos])
+            Checkpoint_Frames[Pos]=Stats[Pos]->x_Current;
+    return IsRead;
+}
+
+//---------------------------------------------------------------------------
+void FileInformation::Checkpoint_Write()
+{
+    // Stats are complete up to the last decoded frame
+    Glue->Pipeline_Flush();
+
+    if (ReferenceStream_Pos>=Stats.size() || !Stats[ReferenceStream_Pos] || Stats[ReferenceStream_Pos]->Type_Get()!=Type_Video)
+        return;
+    CommonStats* Video=Stats[ReferenceStream_Pos];
+
+    // Other streams must have all their frames before the restart point
+    double Limit=DBL_MAX;
+    for (size_t Pos=0; Pos<Stats.size(); Pos++)
+        if (Pos!=ReferenceStream_Pos && Stats[Pos] && Stats[Pos]->x_Current)
+        {
+            double Last=Stats[Pos]->x.TimeStamp(Stats[Pos]->x_Current-1);
+            if (Limit>Last)
+                Limit=Last;
+        }
+
+    // Restart point is the last usable key frame after the previous checkpoint
+    size_t KeyFrame=Video->x_Current;
+    while (KeyFrame>Checkpoint_Frames[ReferenceStream_Pos]+1)
+    {
+        KeyFrame--;
+        if (Video->key_frames.Get(KeyFrame) && Video->pkt_pts[KeyFrame]!=AV_NOPTS_VALUE && Video->x.IsSet(KeyFrame) && Video->x.TimeStamp(KeyFrame)<=Limit)
+            break;
+    }
+    if (KeyFrame<=Checkpoint_Frames[ReferenceStream_Pos]+1)
+        return;
+    double KeyFrame_TimeStamp=Video->x.TimeStamp(KeyFrame);
+
+    // Frames before the restart point
+    StatsBinaryWriter Writer;
+    std::vector<size_t> Frames(Checkpoint_Frames);
+    uint32_t Stream=0;
+    for (size_t Pos=0; Pos<Stats.size(); Pos++)
+    {
+        if (!Stats[Pos])
+            continue;
+        size_t End=KeyFrame;
+        if (Pos!=ReferenceStream_Pos)
+        {
+            End=Checkpoint_Frames[Pos];
+            while (End<Stats[Pos]->x_Current && (!Stats[Pos]->x.IsSet(End) || Stats[Pos]->x.TimeStamp(End)<KeyFrame_TimeStamp))
+                End++;
+        }
+        Stats[Pos]->StatsToBinary(Writer, Stream++, Checkpoint_Frames[Pos], End);
+        Frames[Pos]=End;
+    }
+    StatsBinaryBuffer Checkpoint;
+    Checkpoint.Put<int64_t>(Video->pkt_pts[KeyFrame]);
+    Checkpoint.Put<int64_t>(QFileInfo(FileName).size());
+    Checkpoint_Settings_Put(Checkpoint, Glue_Filters);
+    Writer.Block_Add(StatsBinary_Checkpoint, 0, 0, 0, Checkpoint.Data);
+
+    string Data=Writer.Data_Get();
+    StatsBinaryBuffer Record;
+    Record.Put<uint64_t>(Data.size());
+    Record.Data+=Data;
+
+    QFile File(FileName + ".qctools.part");
+    if (!File.open(QIODevice::WriteOnly | QIODevice::Append))
+        return;
+    if (File.write(Record.Data.c_str(), Record.Data.size())==(qint64)Record.Data.size())
+        Checkpoint_Frames=Frames;
+}
+
 void FileInformation::runExport()
 {
-    Export_XmlGz(m_exportFileName, m_exportFilters);
+    if (m_exportFileName.endsWith(".qctools.bin"))
+        Export_Bin(m_exportFileName);
+    else
+        Export_XmlGz(m_exportFileName, m_exportFilters);
 }
 
 //***************************************************************************
@@ -110,16 +476,11 @@ void FileInformation::readStats(QIODevice& StatsFromExternalData_File, bool Stat
     AudioStats* Audio=new AudioStats();
     Stats.push_back(Audio);
 
-    //XML init
-    const char*  Xml_HeaderFooter="</frames></ffprobe:ffprobe><ffprobe:ffprobe><frames>";
-    const size_t Xml_HeaderSize=25;
-    const size_t Xml_FooterSize=27;
-    const size_t Xml_MaxSize=0x1000000; //Blocks of 16 MiB, arbitrary chosen
-    char* Xml=new char[Xml_MaxSize+Xml_HeaderSize+Xml_FooterSize];
-
     //Read init
     const size_t Compressed_MaxSize=0x100000; //Blocks of 1 MiB, arbitrary chosen
     char* Compressed=new char[Compressed_MaxSize];
+    const size_t Xml_MaxSize=0x100000; //Blocks of 1 MiB, arbitrary chosen
+    char* Xml=new char[Xml_MaxSize];
 
     //Uncompress init
     z_stream strm;
@@ -135,94 +496,106 @@ void FileInformation::readStats(QIODevice& StatsFromExternalData_File, bool Stat
         inflateInit2(&strm, 15 + 16); // 15 + 16 are magic values for gzip
     }
 
-    //Load and parse compressed data chunk by chunk
-    char* Xml_Pointer=Xml;
-    int inflate_Result;
-    int TEMP = 0;
-
-    for (;;)
+    //Parser, frames are sent to the stats as soon as they are complete
+    XmlPullParser Parser;
+    CommonStats* Frame_Stats=NULL; // Stats of the frame being parsed
+    size_t Streams_Depth=0; // Depth inside <streams> or <format>, kept as is for the streams and formats parsers
+    string Streams="<ffprobe:ffprobe>";
+    auto Parse=[&]()
     {
-        //Load
-        qint64 ReadSize;
-        size_t avail_out=Xml_MaxSize-(Xml_Pointer-Xml);
-        if (StatsFromExternalData_FileName_IsCompressed)
-            ReadSize=StatsFromExternalData_File.read(Compressed, Compressed_MaxSize); //Load in an intermediate buffer for decompression
-        else
-            ReadSize=StatsFromExternalData_File.read(Xml_Pointer, avail_out); //Load directly in the XML buffer
-        if (!ReadSize)
-            break;
-        TEMP += ReadSize;
-
-        //Parse compressed data, with handling of the case the output buffer is not big enough
-        strm.next_in=(Bytef*)Compressed;
-        strm.avail_in=ReadSize;
         for (;;)
         {
-            size_t Xml_Size=Xml_Pointer-Xml;
-            if (StatsFromExternalData_FileName_IsCompressed)
+            XmlPullParser::token Token=Parser.Next();
+            if (Token==XmlPullParser::Token_None)
+                break;
+
+            if (Streams_Depth)
             {
-                //inflate
-                strm.next_out=(Bytef*)Xml_Pointer;
-                strm.avail_out= (avail_out - Xml_Size);
-                if ((inflate_Result=inflate(&strm, Z_NO_FLUSH))<0)
-                    break;
-                Xml_Size+=(avail_out - Xml_Size) -strm.avail_out;
+                Streams.append(Parser.Raw(), Parser.Raw_Size_Get());
+                if (Token==XmlPullParser::Token_StartElement)
+                    Streams_Depth++;
+                else if (Token==XmlPullParser::Token_EndElement)
+                    Streams_Depth--;
+                continue;
             }
-            else
-                Xml_Size+=ReadSize;
-
-            //Cut the XML after the last XML frame footer, and keep the remaining data for the next turn
-            size_t Xml_SizeForParsing=Xml_Size;
-            //Look for XML frame footer
-            while (Xml_SizeForParsing>Xml_HeaderSize &&
-                    ( Xml[Xml_SizeForParsing-1]!='>' //"</frame>"
-                || Xml[Xml_SizeForParsing-2]!='e'
-                || Xml[Xml_SizeForParsing-3]!='m'
-                || Xml[Xml_SizeForParsing-4]!='a'
-                || Xml[Xml_SizeForParsing-5]!='r'
-                || Xml[Xml_SizeForParsing-6]!='f'
-                || Xml[Xml_SizeForParsing-7]!='/'
-                || Xml[Xml_SizeForParsing-8]!='<'))
-                Xml_SizeForParsing--;
-            if (Xml_SizeForParsing<=Xml_HeaderSize)
+
+            if (Token==XmlPullParser::Token_StartElement)
             {
-                //The block does not contain any complete frame, looping in order to get more data from the file
-                Xml_Pointer=Xml+Xml_Size;
-                break;
+                if (Parser.Name_Is("tag"))
+                {
+                    if (Frame_Stats)
+                        Frame_Stats->StatsFromExternalData_Tag(Parser.Attribute("key"), Parser.Attribute("value"));
+                }
+                else if (Parser.Name_Is("frame"))
+                {
+                    const char* media_type=Parser.Attribute("media_type");
+                    if (media_type && !strcmp(media_type, "video"))
+                        Frame_Stats=Video;
+                    else if (media_type && !strcmp(media_type, "audio"))
+                        Frame_Stats=Audio;
+                    else
+                        Frame_Stats=NULL;
+                    if (Frame_Stats)
+                        Frame_Stats->StatsFromExternalData_Frame(Parser);
+                }
+                else if (Parser.Name_Is("streams") || Parser.Name_Is("format"))
+                {
+                    Streams.append(Parser.Raw(), Parser.Raw_Size_Get());
+                    Streams_Depth=1;
+                }
             }
+            else if (Token==XmlPullParser::Token_EndElement && Frame_Stats && Parser.Name_Is("frame"))
+            {
+                Frame_Stats->StatsFromExternalData_FrameEnd();
+                Frame_Stats=NULL;
+            }
+        }
+    };
 
-            //Insert Xml_HeaderFooter inside the XML content
-            memmove(Xml+Xml_SizeForParsing+Xml_HeaderSize+Xml_FooterSize, Xml+Xml_SizeForParsing, Xml_Size-Xml_SizeForParsing);
-            memcpy(Xml+Xml_SizeForParsing, Xml_HeaderFooter, Xml_HeaderSize+Xml_FooterSize);
-            Xml_Size+=Xml_HeaderSize+Xml_FooterSize;
-            Xml_SizeForParsing+=Xml_FooterSize;
-
-            Video->StatsFromExternalData(Xml, Xml_SizeForParsing);
-            Audio->StatsFromExternalData(Xml, Xml_SizeForParsing);
+    //Load, uncompress and parse data block by block
+    for (;;)
+    {
+        qint64 ReadSize=StatsFromExternalData_File.read(Compressed, Compressed_MaxSize);
+        if (ReadSize<=0)
+            break;
 
-            //Cut the parsed content
-            memmove(Xml, Xml+Xml_SizeForParsing, Xml_Size-Xml_SizeForParsing);
-            Xml_Pointer=Xml+Xml_Size-Xml_SizeForParsing;
+        if (!StatsFromExternalData_FileName_IsCompressed)
+        {
+            Parser.Data_Add(Compressed, ReadSize);
+            Parse();
+            continue;
+        }
 
-            //Check if we need to stop
-            if (!StatsFromExternalData_FileName_IsCompressed || strm.avail_out || inflate_Result == Z_STREAM_END)
+        //Uncompress, with handling of the case the output buffer is not big enough
+        int inflate_Result;
+        strm.next_in=(Bytef*)Compressed;
+        strm.avail_in=ReadSize;
+        do
+        {
+            strm.next_out=(Bytef*)Xml;
+            strm.avail_out=Xml_MaxSize;
+            inflate_Result=inflate(&strm, Z_NO_FLUSH);
+            if (inflate_Result<0 && inflate_Result!=Z_BUF_ERROR)
                 break;
+            Parser.Data_Add(Xml, Xml_MaxSize-strm.avail_out);
+            Parse();
         }
+        while (strm.avail_out==0 && inflate_Result!=Z_STREAM_END);
 
-        //Coherency checks
-        if (Xml_Pointer>=Xml+Xml_MaxSize+Xml_HeaderSize)
+        if ((inflate_Result<0 && inflate_Result!=Z_BUF_ERROR) || inflate_Result==Z_STREAM_END)
             break;
     }
+    Parser.Data_End();
+    Parse();
 
     //Inform the parser that parsing is finished
     Video->StatsFromExternalData_Finish();
     Audio->StatsFromExternalData_Finish();
 
-    //Parse formats
-    formatStats->readFromXML(Xml, Xml_Pointer - Xml);
-
-    //Parse streams
-    streamsStats->readFromXML(Xml, Xml_Pointer - Xml);
+    //Parse streams and formats
+    Streams+="</ffprobe:ffprobe>";
+    formatStats->readFromXML(Streams.c_str(), Streams.size());
+    streamsStats->readFromXML(Streams.c_str(), Streams.size());
 
     //Cleanup
     if (StatsFromExternalData_FileName_IsCompressed)
@@ -231,6 +604,71 @@ void FileInformation::readStats(QIODevice& StatsFromExternalData_File, bool Stat
     delete[] Xml;
 }
 
+//---------------------------------------------------------------------------
+bool FileInformation::readStatsFromBinary(const QString& StatsFileName)
+{
+    // All blocks are decompressed into the stats when the file is opened, as XML
+    // sidecars are parsed, so the file is read at once; there is no text parsing
+    QFile File(StatsFileName);
+    if (!File.open(QIODevice::ReadOnly))
+        return false;
+    qint64 Size=File.size();
+    QByteArray Data=File.readAll();
+    File.close();
+    if ((qint64)Data.size()!=Size)
+        return false;
+
+    StatsBinaryReader Reader;
+    if (!Reader.Open(Data.constData(), Data.size()))
+        return false;
+
+    std::vector<CommonStats*> BinaryStats;
+    bool IsOk=true;
+    size_t Streams_Count=Reader.Streams_Count();
+    for (size_t Pos=0; IsOk && Pos<Streams_Count; Pos++)
+    {
+        int Type;
+        size_t FrameCount;
+        CommonStats* Item=NULL;
+        if (Reader.Stream_Get(Pos, Type, FrameCount))
+        {
+            if (Type==Type_Video)
+                Item=new VideoStats(FrameCount);
+            else if (Type==Type_Audio)
+                Item=new AudioStats(FrameCount);
+        }
+        if (Item && !Item->StatsFromBinary(Reader, Pos))
+        {
+            delete Item;
+            Item=NULL;
+        }
+        if (Item)
+            BinaryStats.push_back(Item);
+        else
+            IsOk=false;
+    }
+    if (!IsOk || BinaryStats.empty())
+    {
+        for (size_t Pos=0; Pos<BinaryStats.size(); Pos++)
+            delete BinaryStats[Pos];
+        return false;
+    }
+
+    m_hasStats = true;
+    Stats=BinaryStats;
+
+    streamsStats = new StreamsStats();
+    formatStats = new FormatStats();
+    string Xml;
+    if (Reader.Block_Get(StatsBinary_StreamsAndFormats, 0, 0, 0, Xml))
+    {
+        formatStats->readFromXML(Xml.c_str(), Xml.size());
+        streamsStats->readFromXML(Xml.c_str(), Xml.size());
+    }
+
+    return true;
+}
+
 FileInformation::FileInformation (SignalServer* signalServer, const QString &FileName_, activefilters ActiveFilters_, activealltracks ActiveAllTracks_,
                                   int FrameCount) :
     FileName(FileName_),
@@ -263,10 +701,25 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
     static const QString dotQctoolsDotXml = ".qctools.xml";
     static const QString dotXmlDotGz = ".xml.gz";
     static const QString dotQctoolsDotMkv = ".qctools.mkv";
+    static const QString dotQctoolsDotBin = ".qctools.bin";
 
     QByteArray attachment;
 
-    if (FileName.endsWith(dotQctoolsDotXmlDotGz))
+    // Binary sidecar first, values are read without text parsing
+    bool StatsFromBinary_IsRead=false;
+    if (FileName.endsWith(dotQctoolsDotBin))
+    {
+        FileName.resize(FileName.length() - dotQctoolsDotBin.length());
+        StatsFromBinary_IsRead=readStatsFromBinary(FileName + dotQctoolsDotBin);
+    }
+    else if (QFile::exists(FileName + dotQctoolsDotBin))
+        StatsFromBinary_IsRead=readStatsFromBinary(FileName + dotQctoolsDotBin);
+
+    if (StatsFromBinary_IsRead)
+    {
+        // XML files are not needed
+    }
+    else if (FileName.endsWith(dotQctoolsDotXmlDotGz))
     {
         StatsFromExternalData_FileName=FileName;
         FileName.resize(FileName.length() - dotQctoolsDotXmlDotGz.length());
@@ -293,7 +746,7 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
         }
     }
 
-    if (StatsFromExternalData_FileName.size()==0)
+    if (StatsFromExternalData_FileName.size()==0 && !StatsFromBinary_IsRead)
     {
         if (QFile::exists(FileName + dotQctoolsDotXmlDotGz))
         {
@@ -318,7 +771,11 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
     QString shortFileName;
     std::unique_ptr<QIODevice> StatsFromExternalData_File;
 
-    if(attachment.isEmpty()) {
+    if(StatsFromBinary_IsRead) {
+        QFileInfo fileInfo(FileName + dotQctoolsDotXmlDotGz); // Name of the uploaded report
+        shortFileName = fileInfo.fileName();
+        StatsFromExternalData_File.reset(new QBuffer());
+    } else if(attachment.isEmpty()) {
         QFileInfo fileInfo(StatsFromExternalData_FileName);
         shortFileName = fileInfo.fileName();
         StatsFromExternalData_File.reset(new QFile(StatsFromExternalData_FileName));
@@ -329,7 +786,7 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
     }
 
     // External data optional input
-    bool StatsFromExternalData_IsOpen=StatsFromExternalData_File->open(QIODevice::ReadOnly);
+    bool StatsFromExternalData_IsOpen=StatsFromBinary_IsRead || StatsFromExternalData_File->open(QIODevice::ReadOnly);
 
     // Running FFmpeg
     string FileName_string=FileName.toUtf8().data();
@@ -373,7 +830,8 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
     }
     else
     {
-        readStats(*StatsFromExternalData_File, StatsFromExternalData_FileName_IsCompressed);
+        if (!StatsFromBinary_IsRead)
+            readStats(*StatsFromExternalData_File, StatsFromExternalData_FileName_IsCompressed);
 
         if(signalServer->enabled() && m_autoCheckFileUploaded)
         {
@@ -384,8 +842,15 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
     std::string fileName = FileName_string;
     if(fileName == "-")
         fileName = "pipe:0";
+    Glue_FileName=fileName;
+    Glue_Filters[0]=Filters[0];
+    Glue_Filters[1]=Filters[1];
+
+    // Without filter, decoded frames are needed only for the thumbnails
+    bool PacketsOnly=PacketsOnly_IsEnabled && !StatsFromExternalData_IsOpen && Filters[0].empty() && Filters[1].empty();
 
-    Glue=new FFmpeg_Glue(fileName, ActiveAllTracks, &Stats, &streamsStats, &formatStats, Stats.empty());
+    Glue_DecoderThreadCount=DecoderThreadCount_Get();
+    Glue=new FFmpeg_Glue(fileName, ActiveAllTracks, &Stats, &streamsStats, &formatStats, Stats.empty(), DecoderThreading_Type, Glue_DecoderThreadCount, PacketsOnly);
     if (!FileName_string.empty() && Glue->ContainerFormat_Get().empty())
     {
         delete Glue;
@@ -396,9 +861,24 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
 
     if (Glue)
     {
+        Glue->Profiler_Set(&Profile);
+        if (Glue->withStats())
+            Glue->Sampling_Set(Sampling_Mode, Sampling_Stride);
         Glue->AddOutput(0, 72, 72, FFmpeg_Glue::Output_Jpeg);
+        Glue->Thumbnails_Tiles_Set(Thumbnails_Tiles);
         Glue->AddOutput(1, 0, 0, FFmpeg_Glue::Output_Stats, 0, Filters[0]);
         Glue->AddOutput(0, 0, 0, FFmpeg_Glue::Output_Stats, 1, Filters[1]);
+        Glue->Pipeline_Set(!PacketsOnly);
+    }
+
+    // Resume from the last checkpoint of a previous analysis, if any
+    Checkpoint_Frames.resize(Stats.size());
+    Checkpoint_IsResumed=false;
+    int64_t Checkpoint_Start;
+    if (Glue && Glue->withStats() && Checkpoint_Interval && Glue->Resume_IsPossible() && Checkpoint_Read(Checkpoint_Start))
+    {
+        Glue->Resume_Set(Checkpoint_Start);
+        Checkpoint_IsResumed=true;
     }
 
     // Looking for the reference stream (video or audio)
@@ -424,6 +904,7 @@ FileInformation::FileInformation (SignalServer* signalServer, const QString &Fil
 //---------------------------------------------------------------------------
 FileInformation::~FileInformation ()
 {
+    AnalysisScheduler::instance()->remove(this);
     WantToStop=true;
     bool result = wait();
     assert(result);
@@ -443,21 +924,27 @@ FileInformation::~FileInformation ()
 //---------------------------------------------------------------------------
 void FileInformation::startParse ()
 {
+    // Started by the scheduler as soon as there is a free slot
+    if(Glue)
+        AnalysisScheduler::instance()->enqueue(this);
+}
+
+//---------------------------------------------------------------------------
+bool FileInformation::startParseThread ()
+{
+    if (isRunning())
+        return false;
+
     m_jobType = Parsing;
+    start();
+    return true;
+}
 
-    int Max=QThread::idealThreadCount();
-    if (Max>2)
-        Max-=2;
-    else
-        Max=1;
-    if (!isRunning() && ActiveParsing_Count<Max)
-    {
-        if(Glue)
-        {
-            start();
-            ActiveParsing_Count++;
-        }
-    }
+//---------------------------------------------------------------------------
+void FileInformation::parseStartFailed ()
+{
+    m_parsed = false;
+    Q_EMIT parsingCompleted(false);
 }
 
 void FileInformation::startExport(const QString &exportFileName)
@@ -481,59 +968,6 @@ void FileInformation::startExport(const QString &exportFileName)
 //---------------------------------------------------------------------------
 void FileInformation::Export_XmlGz (const QString &ExportFileName, const activefilters& filters)
 {
-    stringstream Data;
-
-    // Header
-    Data<<"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    Data<<"<!-- Created by QCTools " << Version << " -->\n";
-    Data<<"<ffprobe:ffprobe xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance' xmlns:ffprobe='http://www.ffmpeg.org/schema/ffprobe' xsi:schemaLocation='http://www.ffmpeg.org/schema/ffprobe ffprobe.xsd'>\n";
-    Data<<"    <program_version version=\"" << FFmpeg_Glue::FFmpeg_Version() << "\" copyright=\"Copyright (c) 2007-" << FFmpeg_Glue::FFmpeg_Year() << " the FFmpeg developers\" build_date=\"" __DATE__ "\" build_time=\"" __TIME__ "\" compiler_ident=\"" << FFmpeg_Glue::FFmpeg_Compiler() << "\" configuration=\"" << FFmpeg_Glue::FFmpeg_Configuration() << "\"/>\n";
-    Data<<"\n";
-    Data<<"    <library_versions>\n";
-    Data<<FFmpeg_Glue::FFmpeg_LibsVersion();
-    Data<<"    </library_versions>\n";
-
-    Data<<"    <frames>\n";
-
-    // From stats
-    for (size_t Pos=0; Pos<Stats.size(); Pos++)
-    {
-        if (Stats[Pos])
-        {
-            if(Stats[Pos]->Type_Get() == Type_Video && Glue)
-            {
-                auto videoStats = static_cast<VideoStats*>(Stats[Pos]);
-                videoStats->setWidth(Glue->Width_Get());
-                videoStats->setHeight(Glue->Height_Get());
-            }
-            Data<<Stats[Pos]->StatsToXML(filters);
-        }
-    }
-
-    // Footer
-    Data<<"    </frames>";
-
-    QString streamsAndFormats;
-    QXmlStreamWriter writer(&streamsAndFormats);
-    writer.setAutoFormatting(true);
-    writer.setAutoFormattingIndent(4);
-
-    if(streamsStats)
-        streamsStats->writeToXML(&writer);
-
-    if(formatStats)
-        formatStats->writeToXML(&writer);
-
-    // add indentation
-    QStringList splitted = streamsAndFormats.split("\n");
-    for(size_t i = 0; i < splitted.length(); ++i)
-        splitted[i] = QString(qAbs(writer.autoFormattingIndent()), writer.autoFormattingIndent() > 0 ? ' ' : '\t') + splitted[i];
-    streamsAndFormats = splitted.join("\n");
-
-    Data<<streamsAndFormats.toStdString() << "\n\n";
-
-    Data<<"</ffprobe:ffprobe>";
-
     SharedFile file;
     QString name;
 
@@ -548,57 +982,97 @@ void FileInformation::Export_XmlGz (const QString &ExportFileName, const activef
         name = info.fileName();
     }
 
-    string DataS=Data.str();
-    uLongf Buffer_Size=65536;
+    if(!file->open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        Q_EMIT statsFileGenerationFailed(name);
+        return;
+    }
 
-    if(file->open(QIODevice::ReadWrite))
     {
-        if(name.endsWith(".qctools.xml"))
+        // Frames are serialized by blocks and sent to the file (compressed if needed) as soon as the buffer is full
+        ProfilerScope Scope(&Profile, ProfilerStage_Export);
+        ExportWriter Writer(file.data(), !name.endsWith(".qctools.xml"));
+        Writer.Profiler_Set(&Profile);
+        const size_t Export_FramesPerBlock=256;
+
+        // Header
+        stringstream Data;
+        Data<<"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        Data<<"<!-- Created by QCTools " << Version << " -->\n";
+        Data<<"<ffprobe:ffprobe xmlns:xsi='http://www.w3.org/2001/XMLSchema-instance' xmlns:ffprobe='http://www.ffmpeg.org/schema/ffprobe' xsi:schemaLocation='http://www.ffmpeg.org/schema/ffprobe ffprobe.xsd'>\n";
+        Data<<"    <program_version version=\"" << FFmpeg_Glue::FFmpeg_Version() << "\" copyright=\"Copyright (c) 2007-" << FFmpeg_Glue::FFmpeg_Year() << " the FFmpeg developers\" build_date=\"" __DATE__ "\" build_time=\"" __TIME__ "\" compiler_ident=\"" << FFmpeg_Glue::FFmpeg_Compiler() << "\" configuration=\"" << FFmpeg_Glue::FFmpeg_Configuration() << "\"/>\n";
+        Data<<"\n";
+        Data<<"    <library_versions>\n";
+        Data<<FFmpeg_Glue::FFmpeg_LibsVersion();
+        Data<<"    </library_versions>\n";
+
+        Data<<"    <frames>\n";
+        Writer.Write(Data.str());
+
+        // From stats
+        size_t Frames_Total=0;
+        for (size_t Pos=0; Pos<Stats.size(); Pos++)
+            if (Stats[Pos])
+                Frames_Total+=Stats[Pos]->x_Current;
+        size_t Frames_Done=0;
+        StatsXmlBuffer Frames; // Reused for all blocks
+        for (size_t Pos=0; Pos<Stats.size(); Pos++)
         {
-            auto bytesLeft = Data.str().size();
-            auto writePtr = DataS.c_str();
-            auto totalBytesWritten = 0;
-
-            while(bytesLeft) {
-                auto bytesToWrite = std::min(size_t(Buffer_Size), bytesLeft);
-                auto bytesWritten = file->write(writePtr, bytesToWrite);
-                totalBytesWritten += bytesWritten;
-
-                Q_EMIT statsFileGenerationProgress(totalBytesWritten, DataS.size());
-
-                writePtr += bytesToWrite;
-                bytesLeft -= bytesWritten;
-
-                if(bytesWritten != bytesToWrite)
-                    break;
-            }
-        } else {
-            char* Buffer=new char[Buffer_Size];
-            z_stream strm;
-            strm.next_in = (Bytef *) DataS.c_str();
-            strm.avail_in = DataS.size() ;
-            strm.total_out = 0;
-            strm.zalloc = Z_NULL;
-            strm.zfree = Z_NULL;
-            if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY)>=0) // 15 + 16 are magic values for gzip
+            if (Stats[Pos])
             {
-                do
+                if(Stats[Pos]->Type_Get() == Type_Video && Glue)
                 {
-                    strm.next_out = (unsigned char*) Buffer;
-                    strm.avail_out = Buffer_Size;
-                    if (deflate(&strm, Z_FINISH)<0)
-                        break;
-                    file->write(Buffer, Buffer_Size-strm.avail_out);
+                    auto videoStats = static_cast<VideoStats*>(Stats[Pos]);
+                    videoStats->setWidth(Glue->Width_Get());
+                    videoStats->setHeight(Glue->Height_Get());
+                }
 
-                    Q_EMIT statsFileGenerationProgress((char*) strm.next_in - DataS.c_str(), DataS.size());
+                size_t Frames_Count=Stats[Pos]->x_Current;
+                for (size_t x_Begin=0; x_Begin<Frames_Count; x_Begin+=Export_FramesPerBlock)
+                {
+                    size_t x_End=std::min(x_Begin+Export_FramesPerBlock, Frames_Count);
+                    Frames.Clear();
+                    Stats[Pos]->StatsToXML(Frames, filters, x_Begin, x_End);
+                    Writer.Write(Frames.Data);
+                    Frames_Done+=x_End-x_Begin;
+
+                    // Total size is estimated from the frames already written
+                    Q_EMIT statsFileGenerationProgress(Writer.Written_Get(), Writer.Written_Get()*Frames_Total/Frames_Done);
                 }
-                while (strm.avail_out == 0);
-                deflateEnd (&strm);
             }
-            delete[] Buffer;
         }
 
-        file->flush();
+        // Footer
+        QString streamsAndFormats;
+        QXmlStreamWriter writer(&streamsAndFormats);
+        writer.setAutoFormatting(true);
+        writer.setAutoFormattingIndent(4);
+
+        if(streamsStats)
+            streamsStats->writeToXML(&writer);
+
+        if(formatStats)
+            formatStats->writeToXML(&writer);
+
+        // add indentation
+        QStringList splitted = streamsAndFormats.split("\n");
+        for(size_t i = 0; i < splitted.length(); ++i)
+            splitted[i] = QString(qAbs(writer.autoFormattingIndent()), writer.autoFormattingIndent() > 0 ? ' ' : '\t') + splitted[i];
+        streamsAndFormats = splitted.join("\n");
+
+        Writer.Write("    </frames>");
+        Writer.Write(streamsAndFormats.toStdString() + "\n\n");
+        Writer.Write("</ffprobe:ffprobe>");
+        if(!Writer.Finish() || !file->flush())
+        {
+            // A truncated report would be found as a sidecar when the media file is opened again
+            file->remove();
+            Q_EMIT statsFileGenerationFailed(name);
+            return;
+        }
+
+        Q_EMIT statsFileGenerationProgress(Writer.Written_Get(), Writer.Written_Get());
+
         file->seek(0);
     }
 
@@ -618,6 +1092,9 @@ void FileInformation::Export_QCTools_Mkv(const QString &ExportFileName, const ac
     });
 
     Export_XmlGz(QString(), filters);
+    disconnect(connection);
+    if (attachmentFileName.isEmpty())
+        return; // Report could not be generated, statsFileGenerationFailed() was sent
 
     FFmpegVideoEncoder encoder;
     int thumbnailsCount = Glue->Thumbnails_Size(0);
@@ -643,8 +1120,62 @@ void FileInformation::Export_QCTools_Mkv(const QString &ExportFileName, const ac
 
         return Glue->ThumbnailPacket_Get(0, thumbnailIndex++);
     }, attachment, attachmentFileName);
+}
 
-    disconnect(connection);
+//---------------------------------------------------------------------------
+void FileInformation::Export_Bin(const QString &ExportFileName)
+{
+    ProfilerScope Scope(&Profile, ProfilerStage_Export);
+    StatsBinaryWriter Writer;
+
+    // From stats
+    uint32_t Stream=0;
+    for (size_t Pos=0; Pos<Stats.size(); Pos++)
+    {
+        if (Stats[Pos])
+        {
+            if(Stats[Pos]->Type_Get() == Type_Video && Glue)
+            {
+                auto videoStats = static_cast<VideoStats*>(Stats[Pos]);
+                videoStats->setWidth(Glue->Width_Get());
+                videoStats->setHeight(Glue->Height_Get());
+            }
+            Stats[Pos]->StatsToBinary(Writer, Stream++);
+        }
+    }
+
+    // Streams and formats, in the XML form read by StreamsStats and FormatStats
+    QString streamsAndFormats;
+    QXmlStreamWriter writer(&streamsAndFormats);
+    writer.writeStartElement("ffprobe:ffprobe");
+    if(streamsStats)
+        streamsStats->writeToXML(&writer);
+    if(formatStats)
+        formatStats->writeToXML(&writer);
+    writer.writeEndElement();
+    Writer.Block_Add(StatsBinary_StreamsAndFormats, 0, 0, 0, streamsAndFormats.toStdString());
+
+    string Data=Writer.Data_Get();
+
+    SharedFile file(new QFile(ExportFileName));
+    QString name=QFileInfo(ExportFileName).fileName();
+    if(!file->open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        Q_EMIT statsFileGenerationFailed(name);
+        return;
+    }
+    if(file->write(Data.c_str(), Data.size())!=(qint64)Data.size() || !file->flush())
+    {
+        // A truncated sidecar would be preferred to the XML ones when the file is opened again
+        file->remove();
+        Q_EMIT statsFileGenerationFailed(name);
+        return;
+    }
+    Q_EMIT statsFileGenerationProgress(Data.size(), Data.size());
+    file->seek(0);
+
+    Q_EMIT statsFileGenerated(file, name);
+    m_commentsUpdated = false;
 }
 
 //***************************************************************************
@@ -660,6 +1191,15 @@ QByteArray FileInformation::Picture_Get (size_t Pos)
     return Glue->Thumbnail_Get(0, Pos);
 }
 
+//---------------------------------------------------------------------------
+QByteArray FileInformation::PictureTile_Get (size_t Pos, thumbnailtile& Tile)
+{
+    if (!Glue || Pos>=ReferenceStat()->x_Current || Pos>=Glue->Thumbnails_Size(0))
+        return QByteArray();
+
+    return Glue->ThumbnailTile_Get(0, Pos, Tile);
+}
+
 QString FileInformation::fileName() const
 {
     return FileName;
@@ -846,7 +1386,7 @@ int FileInformation::BitsPerRawSample(int streamType) const
             return Glue->BitsPerRawSample_Get();
 
         if(ReferenceStat()) {
-            auto guessedBitsPerRawSample = FFmpeg_Glue::guessBitsPerRawSampleFromFormat(*ReferenceStat()->pix_fmt);
+            auto guessedBitsPerRawSample = FFmpeg_Glue::guessBitsPerRawSampleFromFormat(ReferenceStat()->pix_fmt[0]);
             if(guessedBitsPerRawSample != 0)
                 return guessedBitsPerRawSample;
         }
@@ -12,8 +12,11 @@
 //---------------------------------------------------------------------------
 #include "Core/Core.h"
 #include "Core/SignalServer.h"
+#include "Core/Profiler.h"
 
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 #include <QThread>
 #include <QFile>
@@ -33,7 +36,11 @@ class FileInformation : public QThread
     Q_OBJECT
     void run();
     void runParse();
+    void runParseSegments(const std::vector<int64_t>& SegmentsStart);
     void runExport();
+    bool startParseThread();
+    void parseStartFailed(); // Thread is busy, the file is reported as not parsed
+    friend class AnalysisScheduler;
 
 public:
     enum JobTypes
@@ -52,13 +59,21 @@ public:
     // Parsing
     void startParse();
     void startExport(const QString& exportFileName = QString());
+    static void setParallelSegmentsCount(int Count); // Count of parts of a single file analyzed in parallel, 1 for sequential analysis
+    static void setDecoderThreading(decoderthreading Type, int Count); // Count of decoder threads per file, 0 for sharing the cores between files being parsed
+    static void setCheckpointInterval(int Seconds); // Delay between 2 checkpoints of the analysis (.qctools.part), 0 for no checkpoint
+    static void setSampling(samplingmode Mode, int Stride); // Video frames analyzed (all, key frames only, one out of Stride), for a quick triage
+    static void setPacketsOnly(bool Enable); // Files analyzed without filter are not decoded, only packet values are filled (no thumbnails)
+    static void setThumbnailsTiles(int Side); // Thumbnails grouped in sprite sheets of Side x Side frames, 0 for one JPEG per frame
 
     // Dumps
     void                        Export_XmlGz                (const QString &ExportFileName, const activefilters& filters);
     void                        Export_QCTools_Mkv          (const QString &ExportFileName, const activefilters& filters);
+    void                        Export_Bin                  (const QString &ExportFileName); // Native binary sidecar (.qctools.bin), all stats are kept
 
     // Infos
     QByteArray Picture_Get (size_t Pos);
+    QByteArray PictureTile_Get (size_t Pos, thumbnailtile& Tile); // Sprite sheet holding the thumbnail, see FFmpeg_Glue::ThumbnailTile_Get()
     QString	fileName() const;
 
     activefilters               ActiveFilters;
@@ -75,6 +90,9 @@ public:
 
     qreal                       averageFrameRate        () const;
 
+    // Performance
+    const Profiler&             Profiler_Get                () const {return Profile;} // Time per stage of the analysis and of the export
+
     bool isValid() const;
 
     // FFmpeg glue
@@ -131,6 +149,7 @@ public:
     bool commentsUpdated() const;
 
     void readStats(QIODevice& StatsFromExternalData_FileName, bool StatsFromExternalData_FileName_IsCompressed);
+    bool readStatsFromBinary(const QString& StatsFileName);
 
 public Q_SLOTS:
 
@@ -144,6 +163,7 @@ Q_SIGNALS:
     void positionChanged();
     void statsFileGenerated(SharedFile statsFile, const QString& name);
     void statsFileGenerationProgress(quint64 bytesWritten, quint64 totalBytes);
+    void statsFileGenerationFailed(const QString& name); // Instead of statsFileGenerated, nothing usable was written
 
     void statsFileLoaded(SharedFile statsFile);
     void parsingCompleted(bool success);
@@ -168,6 +188,18 @@ private:
 
     // FFmpeg part
     bool                        WantToStop;
+    std::string                 Glue_FileName;
+    std::string                 Glue_Filters[Type_Max];
+    int                         Glue_DecoderThreadCount;
+
+    // Checkpoints
+    bool                        Checkpoint_Read(int64_t& Start);
+    void                        Checkpoint_Write();
+    std::vector<size_t>         Checkpoint_Frames;          // Per stats, count of frames already in the checkpoint file
+    bool                        Checkpoint_IsResumed;
+
+    // Performance
+    Profiler                    Profile;
 
     SignalServer* signalServer;
     QSharedPointer<CheckFileUploadedOperation> checkFileUploadedOperation;
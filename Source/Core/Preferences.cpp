@@ -26,6 +26,13 @@ QString KeySignalServerPassword = "SignalServerPassword";
 
 QString KeyActiveFilters = "ActiveFilters";
 QString KeyActiveAllTracks = "ActiveAllTracks";
+QString KeyDecoderThreading = "DecoderThreading";
+QString KeyDecoderThreadCount = "DecoderThreadCount";
+QString KeyThumbnailsTiles = "ThumbnailsTiles";
+QString KeyDisplayCacheSize = "DisplayCacheSize";
+QString KeyLosslessStats = "LosslessStats";
+QString KeyCheckpointInterval = "CheckpointInterval";
+QString KeyProfiling = "Profiling";
 QString KeyFilterSelectorsOrder = "filterSelectorsOrder";
 
 Preferences::Preferences(QObject *parent) : QObject(parent)
@@ -66,6 +73,94 @@ void Preferences::setActiveAllTracks(const activealltracks &alltracks)
     settings.setValue(KeyActiveAllTracks, (uint) alltracks.to_ulong());
 }
 
+decoderthreading Preferences::decoderThreading() const
+{
+    QSettings settings;
+    int threading = settings.value(KeyDecoderThreading, DecoderThreading_Auto).toInt();
+    if(threading < 0 || threading >= DecoderThreading_Max)
+        threading = DecoderThreading_Auto;
+
+    return (decoderthreading) threading;
+}
+
+void Preferences::setDecoderThreading(decoderthreading threading)
+{
+    QSettings settings;
+    settings.setValue(KeyDecoderThreading, (int) threading);
+}
+
+int Preferences::decoderThreadCount() const
+{
+    QSettings settings;
+    return settings.value(KeyDecoderThreadCount, 0).toInt();
+}
+
+void Preferences::setDecoderThreadCount(int count)
+{
+    QSettings settings;
+    settings.setValue(KeyDecoderThreadCount, count);
+}
+
+int Preferences::thumbnailsTiles() const
+{
+    QSettings settings;
+    return settings.value(KeyThumbnailsTiles, 0).toInt();
+}
+
+void Preferences::setThumbnailsTiles(int side)
+{
+    QSettings settings;
+    settings.setValue(KeyThumbnailsTiles, side);
+}
+
+int Preferences::displayCacheSize() const
+{
+    QSettings settings;
+    return settings.value(KeyDisplayCacheSize, 256).toInt();
+}
+
+void Preferences::setDisplayCacheSize(int megabytes)
+{
+    QSettings settings;
+    settings.setValue(KeyDisplayCacheSize, megabytes);
+}
+
+bool Preferences::losslessStats() const
+{
+    QSettings settings;
+    return settings.value(KeyLosslessStats, false).toBool();
+}
+
+void Preferences::setLosslessStats(bool lossless)
+{
+    QSettings settings;
+    settings.setValue(KeyLosslessStats, lossless);
+}
+
+int Preferences::checkpointInterval() const
+{
+    QSettings settings;
+    return settings.value(KeyCheckpointInterval, 0).toInt();
+}
+
+void Preferences::setCheckpointInterval(int seconds)
+{
+    QSettings settings;
+    settings.setValue(KeyCheckpointInterval, seconds);
+}
+
+bool Preferences::profiling() const
+{
+    QSettings settings;
+    return settings.value(KeyProfiling, false).toBool();
+}
+
+void Preferences::setProfiling(bool enable)
+{
+    QSettings settings;
+    settings.setValue(KeyProfiling, enable);
+}
+
 FilterSelectorsOrder Preferences::loadFilterSelectorsOrder()
 {
     QSettings settings;
@@ -29,6 +29,27 @@ public:
     activealltracks activeAllTracks() const;
     void setActiveAllTracks(const activealltracks& alltracks);
 
+    decoderthreading decoderThreading() const;
+    void setDecoderThreading(decoderthreading threading);
+
+    int decoderThreadCount() const;
+    void setDecoderThreadCount(int count);
+
+    int thumbnailsTiles() const;
+    void setThumbnailsTiles(int side);
+
+    int displayCacheSize() const; // In MiB, 0 for no cache
+    void setDisplayCacheSize(int megabytes);
+
+    bool losslessStats() const;
+    void setLosslessStats(bool lossless);
+
+    int checkpointInterval() const;
+    void setCheckpointInterval(int seconds);
+
+    bool profiling() const;
+    void setProfiling(bool enable);
+
     FilterSelectorsOrder loadFilterSelectorsOrder();
     void saveFilterSelectorsOrder(const FilterSelectorsOrder& order);
 
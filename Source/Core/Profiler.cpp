@@ -0,0 +1,262 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Core/Profiler.h"
+
+#include <QThread>
+
+#include <iomanip>
+#include <sstream>
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <psapi.h>
+    #ifdef _MSC_VER
+        #pragma comment(lib, "psapi.lib")
+    #endif
+#else
+    #include <sys/resource.h>
+#endif
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Configuration
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+std::atomic<bool> Profiler::Enabled(false);
+static std::atomic<quint64> Profiler_Id(0);
+
+// Last slot used by the thread, most threads work for a single profiler
+struct profiler_cache
+{
+    quint64                     Id;
+    void*                       Slot;
+};
+static thread_local profiler_cache Profiler_Cache={0, NULL};
+
+//***************************************************************************
+// Constructor / Destructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+Profiler::Profiler() :
+    Id(++Profiler_Id)
+{
+}
+
+//---------------------------------------------------------------------------
+Profiler::~Profiler()
+{
+    for (std::map<Qt::HANDLE, slot*>::iterator Slot=Slots.begin(); Slot!=Slots.end(); ++Slot)
+        delete Slot->second;
+}
+
+//***************************************************************************
+// Items
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+size_t Profiler::Item_Get(profilerstage Stage, const std::string& Name)
+{
+    QMutexLocker Locker(&Mutex);
+
+    for (size_t Item=0; Item<Items.size(); Item++)
+        if (Items[Item].first==Stage && Items[Item].second==Name)
+            return Item;
+    if (Items.size()>=Items_Max)
+        return (size_t)-1;
+    Items.push_back(std::make_pair(Stage, Name));
+    return Items.size()-1;
+}
+
+//***************************************************************************
+// Data
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+Profiler::slot* Profiler::Slot_Get()
+{
+    if (Profiler_Cache.Id==Id)
+        return (slot*)Profiler_Cache.Slot;
+
+    QMutexLocker Locker(&Mutex);
+
+    slot*& Slot=Slots[QThread::currentThreadId()];
+    if (!Slot)
+    {
+        Slot=new slot;
+        for (size_t Counter=0; Counter<Counter_Max; Counter++)
+            Slot->Values[Counter]=0;
+    }
+    Profiler_Cache.Id=Id;
+    Profiler_Cache.Slot=Slot;
+    return Slot;
+}
+
+//---------------------------------------------------------------------------
+// Only the owner thread writes in the slot, no atomic read-modify-write is needed
+static inline void Increment(std::atomic<quint64>& Value, quint64 ToAdd)
+{
+    Value.store(Value.load(std::memory_order_relaxed)+ToAdd, std::memory_order_relaxed);
+}
+
+//---------------------------------------------------------------------------
+void Profiler::Add(profilerstage Stage, size_t Item, quint64 Nanoseconds)
+{
+    slot* Slot=Slot_Get();
+    Increment(Slot->Values[Counter_Time+Stage], Nanoseconds);
+    Increment(Slot->Values[Counter_Count+Stage], 1);
+    if (Item<Items_Max)
+    {
+        Increment(Slot->Values[Counter_Item_Time+Item], Nanoseconds);
+        Increment(Slot->Values[Counter_Item_Count+Item], 1);
+    }
+}
+
+//---------------------------------------------------------------------------
+void Profiler::Bytes_Add(quint64 Size)
+{
+    if (!Enabled_Get())
+        return;
+
+    Increment(Slot_Get()->Values[Counter_Bytes], Size);
+}
+
+//***************************************************************************
+// Info
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+quint64 Profiler::Sum(size_t Counter) const
+{
+    QMutexLocker Locker(&Mutex);
+
+    quint64 Value=0;
+    for (std::map<Qt::HANDLE, slot*>::const_iterator Slot=Slots.begin(); Slot!=Slots.end(); ++Slot)
+        Value+=Slot->second->Values[Counter].load(std::memory_order_relaxed);
+    return Value;
+}
+
+//---------------------------------------------------------------------------
+quint64 Profiler::Time_Get(profilerstage Stage) const
+{
+    return Sum(Counter_Time+Stage);
+}
+
+//---------------------------------------------------------------------------
+quint64 Profiler::Count_Get(profilerstage Stage) const
+{
+    return Sum(Counter_Count+Stage);
+}
+
+//---------------------------------------------------------------------------
+quint64 Profiler::Bytes_Get() const
+{
+    return Sum(Counter_Bytes);
+}
+
+//---------------------------------------------------------------------------
+size_t Profiler::Items_Count() const
+{
+    QMutexLocker Locker(&Mutex);
+
+    return Items.size();
+}
+
+//---------------------------------------------------------------------------
+std::string Profiler::Item_Name(size_t Item) const
+{
+    QMutexLocker Locker(&Mutex);
+
+    return Item<Items.size()?Items[Item].second:std::string();
+}
+
+//---------------------------------------------------------------------------
+profilerstage Profiler::Item_Stage(size_t Item) const
+{
+    QMutexLocker Locker(&Mutex);
+
+    return Item<Items.size()?Items[Item].first:ProfilerStage_Max;
+}
+
+//---------------------------------------------------------------------------
+quint64 Profiler::Item_Time_Get(size_t Item) const
+{
+    return Item<Items_Max?Sum(Counter_Item_Time+Item):0;
+}
+
+//---------------------------------------------------------------------------
+quint64 Profiler::Item_Count_Get(size_t Item) const
+{
+    return Item<Items_Max?Sum(Counter_Item_Count+Item):0;
+}
+
+//---------------------------------------------------------------------------
+std::string Profiler::Summary_Get() const
+{
+    std::stringstream Summary;
+    Summary<<std::fixed<<std::setprecision(3);
+    size_t Items_Size=Items_Count();
+    for (size_t Stage=0; Stage<ProfilerStage_Max; Stage++)
+    {
+        quint64 Count=Count_Get((profilerstage)Stage);
+        if (!Count)
+            continue;
+        quint64 Time=Time_Get((profilerstage)Stage);
+        Summary<<std::left<<std::setw(32)<<Stage_Name((profilerstage)Stage)<<std::right<<std::setw(12)<<Time/1000000000.0<<" s"
+               <<std::setw(12)<<Count<<" calls"<<std::setw(12)<<Time/1000.0/Count<<" us/call\n";
+
+        for (size_t Item=0; Item<Items_Size; Item++)
+        {
+            quint64 Item_Count=Item_Count_Get(Item);
+            if (Item_Stage(Item)!=Stage || !Item_Count)
+                continue;
+            quint64 Item_Time=Item_Time_Get(Item);
+            Summary<<"  "<<std::left<<std::setw(30)<<Item_Name(Item)<<std::right<<std::setw(12)<<Item_Time/1000000000.0<<" s"
+                   <<std::setw(12)<<Item_Count<<" calls"<<std::setw(12)<<Item_Time/1000.0/Item_Count<<" us/call\n";
+        }
+    }
+    return Summary.str();
+}
+
+//---------------------------------------------------------------------------
+const char* Profiler::Stage_Name(profilerstage Stage)
+{
+    switch (Stage)
+    {
+        case ProfilerStage_Demux        : return "demux";
+        case ProfilerStage_Decode       : return "decode";
+        case ProfilerStage_Filter       : return "filter";
+        case ProfilerStage_Stats        : return "stats";
+        case ProfilerStage_Scale        : return "scale";
+        case ProfilerStage_Jpeg         : return "jpeg";
+        case ProfilerStage_Export       : return "export";
+        case ProfilerStage_Compress     : return "compress";
+        default                         : return "";
+    }
+}
+
+//---------------------------------------------------------------------------
+quint64 Profiler::PeakMemory_Get()
+{
+    #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS Counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+            return 0;
+        return Counters.PeakWorkingSetSize;
+    #else
+        struct rusage Usage;
+        if (getrusage(RUSAGE_SELF, &Usage))
+            return 0;
+        #if defined(__APPLE__)
+            return Usage.ru_maxrss; // Bytes
+        #else
+            return ((quint64)Usage.ru_maxrss)*1024; // KiB
+        #endif
+    #endif
+}
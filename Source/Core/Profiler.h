@@ -0,0 +1,134 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef Profiler_H
+#define Profiler_H
+
+#include <QtGlobal>
+#include <QMutex>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+enum profilerstage
+{
+    ProfilerStage_Demux,
+    ProfilerStage_Decode,
+    ProfilerStage_Filter,
+    ProfilerStage_Stats,
+    ProfilerStage_Scale,                                    // sws_scale
+    ProfilerStage_Jpeg,                                     // JPEG encoding of the thumbnails
+    ProfilerStage_Export,                                   // Serialization of the report
+    ProfilerStage_Compress,                                 // Compression of the report, summed over the compression threads
+    ProfilerStage_Max
+};
+
+//---------------------------------------------------------------------------
+// Time spent in each stage of the analysis of a file, and in some items of
+// a stage (each decoder, each filter graph). Stages run on several threads
+// (decoding, outputs, compression), so times are summed over the threads
+// and may be greater than the elapsed time.
+//
+// Each thread adds to its own counters, summed only when read, so threads
+// do not contend on shared counters. Nothing is measured while profiling
+// is disabled.
+class Profiler
+{
+public:
+    // Configuration
+    static void                 Enabled_Set(bool Value) {Enabled.store(Value, std::memory_order_relaxed);}
+    static bool                 Enabled_Get() {return Enabled.load(std::memory_order_relaxed);}
+
+    // Constructor / Destructor
+    Profiler();
+    ~Profiler();
+
+    // Items
+    static const size_t         Items_Max=64;               // Next items are counted in their stage only
+    size_t                      Item_Get(profilerstage Stage, const std::string& Name); // Created if needed, (size_t)-1 if no more room
+
+    // Data
+    void                        Add(profilerstage Stage, size_t Item, quint64 Nanoseconds);
+    void                        Bytes_Add(quint64 Size);
+
+    // Info
+    quint64                     Time_Get(profilerstage Stage) const; // In nanoseconds
+    quint64                     Count_Get(profilerstage Stage) const;
+    quint64                     Bytes_Get() const; // Demuxed bytes
+    size_t                      Items_Count() const;
+    std::string                 Item_Name(size_t Item) const;
+    profilerstage               Item_Stage(size_t Item) const;
+    quint64                     Item_Time_Get(size_t Item) const; // In nanoseconds
+    quint64                     Item_Count_Get(size_t Item) const;
+    std::string                 Summary_Get() const; // Human readable report, one line per stage then per item
+    static const char*          Stage_Name(profilerstage Stage);
+    static quint64              PeakMemory_Get(); // Peak resident memory of the process in bytes, 0 if unknown
+
+private:
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+
+    // Counters of a thread, written by this thread only
+    enum counter
+    {
+        Counter_Time=0,
+        Counter_Count=Counter_Time+ProfilerStage_Max,
+        Counter_Item_Time=Counter_Count+ProfilerStage_Max,
+        Counter_Item_Count=Counter_Item_Time+Items_Max,
+        Counter_Bytes=Counter_Item_Count+Items_Max,
+        Counter_Max
+    };
+    struct slot
+    {
+        std::atomic<quint64>    Values[Counter_Max];
+    };
+    slot*                       Slot_Get();
+    quint64                     Sum(size_t Counter) const;
+
+    static std::atomic<bool>    Enabled;
+    quint64                     Id;                         // Unique for the process, for the per thread cache of slots
+    mutable QMutex              Mutex;
+    std::map<Qt::HANDLE, slot*> Slots;
+    std::vector<std::pair<profilerstage, std::string> > Items;
+};
+
+//---------------------------------------------------------------------------
+// Time of the scope is added to the stage (and to the item if any), nothing
+// is done without profiler or while profiling is disabled
+class ProfilerScope
+{
+public:
+    ProfilerScope(Profiler* Target_, profilerstage Stage_, size_t Item_=(size_t)-1) :
+        Target(Profiler::Enabled_Get()?Target_:NULL),
+        Stage(Stage_),
+        Item(Item_)
+    {
+        if (Target)
+            Begin=std::chrono::steady_clock::now();
+    }
+    ~ProfilerScope()
+    {
+        if (Target)
+            Target->Add(Stage, Item, (quint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-Begin).count());
+    }
+
+private:
+    ProfilerScope(const ProfilerScope&);
+    ProfilerScope& operator=(const ProfilerScope&);
+
+    Profiler*                   Target;
+    profilerstage               Stage;
+    size_t                      Item;
+    std::chrono::steady_clock::time_point Begin;
+};
+
+#endif // Profiler_H
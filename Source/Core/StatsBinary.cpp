@@ -0,0 +1,200 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Core/StatsBinary.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const char       StatsBinary_Magic[6]={'Q', 'C', 'T', 'B', 'I', 'N'};
+static const uint16_t   StatsBinary_Version=1;
+static const uint32_t   StatsBinary_ByteOrder=0x01020304;
+static const size_t     StatsBinary_HeaderSize=6+2+4+4+4;
+static const size_t     StatsBinary_EntrySize=4*4+8+4+4;
+
+//***************************************************************************
+// Writer
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void StatsBinaryWriter::Block_Add(uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, const std::string& Raw)
+{
+    uLongf Compressed_Size=compressBound(Raw.size());
+    std::vector<Bytef> Compressed(Compressed_Size);
+    if (compress2(Compressed.data(), &Compressed_Size, (const Bytef*)Raw.data(), Raw.size(), Z_DEFAULT_COMPRESSION)!=Z_OK)
+        return;
+
+    StatsBinaryEntry Entry;
+    Entry.Kind=Kind;
+    Entry.Stream=Stream;
+    Entry.Item=Item;
+    Entry.Chunk=Chunk;
+    Entry.Offset=Blocks.size();
+    Entry.Size=(uint32_t)Compressed_Size;
+    Entry.Size_Raw=(uint32_t)Raw.size();
+    Entries.push_back(Entry);
+
+    Blocks.append((const char*)Compressed.data(), Compressed_Size);
+}
+
+//---------------------------------------------------------------------------
+std::string StatsBinaryWriter::Data_Get() const
+{
+    // Index is sorted for binary search, blocks stay in creation order
+    std::vector<StatsBinaryEntry> Index(Entries);
+    std::sort(Index.begin(), Index.end());
+
+    StatsBinaryBuffer Header;
+    Header.Data.append(StatsBinary_Magic, sizeof(StatsBinary_Magic));
+    Header.Put<uint16_t>(StatsBinary_Version);
+    Header.Put<uint32_t>(StatsBinary_ByteOrder);
+    Header.Put<uint32_t>(ChunkFrames);
+    Header.Put<uint32_t>((uint32_t)Index.size());
+    for (size_t Pos=0; Pos<Index.size(); Pos++)
+    {
+        Header.Put<uint32_t>(Index[Pos].Kind);
+        Header.Put<uint32_t>(Index[Pos].Stream);
+        Header.Put<uint32_t>(Index[Pos].Item);
+        Header.Put<uint32_t>(Index[Pos].Chunk);
+        Header.Put<uint64_t>(Index[Pos].Offset);
+        Header.Put<uint32_t>(Index[Pos].Size);
+        Header.Put<uint32_t>(Index[Pos].Size_Raw);
+    }
+
+    return Header.Data+Blocks;
+}
+
+//***************************************************************************
+// Reader
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool StatsBinaryReader::Open(const char* Data_, size_t Size_)
+{
+    Data=Data_;
+    Size=Size_;
+    Entries.clear();
+
+    if (!Data || Size<StatsBinary_HeaderSize || memcmp(Data, StatsBinary_Magic, sizeof(StatsBinary_Magic)))
+        return false;
+
+    uint16_t Version;
+    uint32_t ByteOrder, Count;
+    memcpy(&Version, Data+6, 2);
+    memcpy(&ByteOrder, Data+8, 4);
+    memcpy(&ChunkFrames, Data+12, 4);
+    memcpy(&Count, Data+16, 4);
+    if (Version!=StatsBinary_Version || ByteOrder!=StatsBinary_ByteOrder || !ChunkFrames)
+        return false;
+    if ((Size-StatsBinary_HeaderSize)/StatsBinary_EntrySize<Count)
+        return false;
+
+    const char* Index=Data+StatsBinary_HeaderSize;
+    Blocks=Index+Count*StatsBinary_EntrySize;
+    size_t Blocks_Size=Size-(Blocks-Data);
+    Entries.resize(Count);
+    for (uint32_t Pos=0; Pos<Count; Pos++)
+    {
+        StatsBinaryEntry& Entry=Entries[Pos];
+        memcpy(&Entry.Kind, Index, 4);
+        memcpy(&Entry.Stream, Index+4, 4);
+        memcpy(&Entry.Item, Index+8, 4);
+        memcpy(&Entry.Chunk, Index+12, 4);
+        memcpy(&Entry.Offset, Index+16, 8);
+        memcpy(&Entry.Size, Index+24, 4);
+        memcpy(&Entry.Size_Raw, Index+28, 4);
+        Index+=StatsBinary_EntrySize;
+
+        if (Entry.Offset>Blocks_Size || Entry.Size>Blocks_Size-Entry.Offset)
+        {
+            Entries.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+size_t StatsBinaryReader::Streams_Count() const
+{
+    size_t Count=0;
+    while (Block_Find(StatsBinary_Info, (uint32_t)Count))
+        Count++;
+    return Count;
+}
+
+//---------------------------------------------------------------------------
+bool StatsBinaryReader::Stream_Get(uint32_t Stream, int& Type, size_t& FrameCount) const
+{
+    std::string Raw;
+    if (!Block_Get(StatsBinary_Info, Stream, 0, 0, Raw))
+        return false;
+
+    StatsBinaryCursor Cursor(Raw);
+    Type=Cursor.Get<int32_t>();
+    uint64_t Count=Cursor.Get<uint64_t>();
+    if (!Cursor.IsOk() || !FrameCount_IsValid(Stream, Count))
+        return false;
+    FrameCount=(size_t)Count;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool StatsBinaryReader::FrameCount_IsValid(uint32_t Stream, uint64_t FrameCount) const
+{
+    // The count is used for reserving memory, it must not be trusted before it is checked against the index
+    if (FrameCount>(uint64_t)((size_t)-1)/sizeof(double))
+        return false;
+    uint64_t Chunks=(FrameCount+ChunkFrames-1)/ChunkFrames;
+    if (Chunks>Entries.size())
+        return false;
+    for (uint64_t Chunk=0; Chunk<Chunks; Chunk++)
+    {
+        const StatsBinaryEntry* Entry=Block_Find(StatsBinary_TimeStamps, Stream, 0, (uint32_t)Chunk);
+        uint64_t Frames=std::min((uint64_t)ChunkFrames, FrameCount-Chunk*ChunkFrames);
+        if (!Entry || Entry->Size_Raw!=Frames*sizeof(double))
+            return false;
+    }
+    return !Block_Find(StatsBinary_TimeStamps, Stream, 0, (uint32_t)Chunks);
+}
+
+//---------------------------------------------------------------------------
+const StatsBinaryEntry* StatsBinaryReader::Block_Find(uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk) const
+{
+    StatsBinaryEntry ToFind;
+    ToFind.Kind=Kind;
+    ToFind.Stream=Stream;
+    ToFind.Item=Item;
+    ToFind.Chunk=Chunk;
+
+    std::vector<StatsBinaryEntry>::const_iterator Entry=std::lower_bound(Entries.begin(), Entries.end(), ToFind);
+    if (Entry==Entries.end() || ToFind<*Entry)
+        return NULL;
+    return &*Entry;
+}
+
+//---------------------------------------------------------------------------
+bool StatsBinaryReader::Block_Get(uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, std::string& Raw) const
+{
+    const StatsBinaryEntry* Entry=Block_Find(Kind, Stream, Item, Chunk);
+    if (!Entry)
+        return false;
+
+    Raw.resize(Entry->Size_Raw);
+    uLongf Raw_Size=Entry->Size_Raw;
+    if (uncompress((Bytef*)&Raw[0], &Raw_Size, (const Bytef*)Blocks+Entry->Offset, Entry->Size)!=Z_OK || Raw_Size!=Entry->Size_Raw)
+    {
+        Raw.clear();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,177 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef StatsBinary_H
+#define StatsBinary_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Native binary sidecar (.qctools.bin), little endian:
+// - Header: "QCTBIN", version, byte order mark, frames per block, count of blocks
+// - Index: one entry per block (kind, stream, item, chunk, offset, sizes), sorted
+// - Blocks: zlib compressed, each one is a property of a stream or a range of
+//   frames of one column, so any part can be decoded without reading the rest
+enum statsbinarykind
+{
+    StatsBinary_Info,                                       // Per stream: type, frame count, item names and encodings...
+    StatsBinary_TimeStamps,                                 // double, NaN if not set
+    StatsBinary_Durations,                                  // double
+    StatsBinary_KeyFrames,                                  // uint8_t
+    StatsBinary_PktPos,                                     // int64_t
+    StatsBinary_PktPts,                                     // int64_t
+    StatsBinary_PktSize,                                    // int32_t
+    StatsBinary_PixFmt,                                     // int32_t
+    StatsBinary_PictType,                                   // char
+    StatsBinary_Comments,                                   // Strings
+    StatsBinary_Item,                                       // Item is the position in the item list of Info, type from its encoding
+    StatsBinary_AdditionalKeys,                             // Keys, types and first values of the additional stats
+    StatsBinary_AdditionalInt,                              // int32_t, item is the index of the additional stat
+    StatsBinary_AdditionalDouble,                           // double
+    StatsBinary_AdditionalString,                           // Strings
+    StatsBinary_Dimensions,                                 // Video only: width and height
+    StatsBinary_StreamsAndFormats,                          // XML, stream 0
+    StatsBinary_Checkpoint,                                 // Checkpoints (.qctools.part) only, stream 0: restart time stamp, media file size
+    StatsBinary_Gaps,                                       // uint8_t, set after frames not analyzed (sampled analysis)
+};
+
+//---------------------------------------------------------------------------
+struct StatsBinaryEntry
+{
+    uint32_t                    Kind;
+    uint32_t                    Stream;
+    uint32_t                    Item;
+    uint32_t                    Chunk;
+    uint64_t                    Offset;                     // From the end of the index
+    uint32_t                    Size;                       // Compressed
+    uint32_t                    Size_Raw;
+
+    bool                        operator< (const StatsBinaryEntry& Other) const
+    {
+        if (Kind!=Other.Kind)
+            return Kind<Other.Kind;
+        if (Stream!=Other.Stream)
+            return Stream<Other.Stream;
+        if (Item!=Other.Item)
+            return Item<Other.Item;
+        return Chunk<Other.Chunk;
+    }
+};
+
+//---------------------------------------------------------------------------
+// Content of a block, before compression
+class StatsBinaryBuffer
+{
+public:
+    template<typename T>
+    void                        Put(T Value) {Data.append((const char*)&Value, sizeof(T));}
+    void                        Put_String(const char* Value) // NULL is kept
+    {
+        if (!Value)
+        {
+            Put<uint32_t>((uint32_t)-1);
+            return;
+        }
+        uint32_t Size=(uint32_t)strlen(Value);
+        Put<uint32_t>(Size);
+        Data.append(Value, Size);
+    }
+
+    std::string                 Data;
+};
+
+//---------------------------------------------------------------------------
+// Content of a block, after decompression
+class StatsBinaryCursor
+{
+public:
+    StatsBinaryCursor(const std::string& Data_) : Data(Data_), Pos(0), Error(false) {}
+
+    template<typename T>
+    T                           Get()
+    {
+        T Value=T();
+        if (Pos+sizeof(T)>Data.size())
+        {
+            Error=true;
+            return Value;
+        }
+        memcpy(&Value, Data.data()+Pos, sizeof(T));
+        Pos+=sizeof(T);
+        return Value;
+    }
+    bool                        Get_String(std::string& Value, bool& IsNull)
+    {
+        uint32_t Size=Get<uint32_t>();
+        IsNull=Size==(uint32_t)-1;
+        if (IsNull)
+        {
+            Value.clear();
+            return !Error;
+        }
+        if (Pos+Size>Data.size())
+        {
+            Error=true;
+            return false;
+        }
+        Value.assign(Data.data()+Pos, Size);
+        Pos+=Size;
+        return true;
+    }
+    bool                        IsOk() const {return !Error;}
+
+private:
+    const std::string&          Data;
+    size_t                      Pos;
+    bool                        Error;
+};
+
+//---------------------------------------------------------------------------
+class StatsBinaryWriter
+{
+public:
+    StatsBinaryWriter(uint32_t ChunkFrames_=0x10000) : ChunkFrames(ChunkFrames_) {}
+
+    uint32_t                    ChunkFrames_Get() const {return ChunkFrames;}
+    void                        Block_Add(uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, const std::string& Raw);
+    std::string                 Data_Get() const; // The whole file
+
+private:
+    uint32_t                    ChunkFrames;
+    std::vector<StatsBinaryEntry> Entries;
+    std::string                 Blocks;
+};
+
+//---------------------------------------------------------------------------
+// Reads from a memory block, e.g. a mapped file, which must stay available
+// while the reader is used. Only the index is read when opening.
+class StatsBinaryReader
+{
+public:
+    StatsBinaryReader() : Data(NULL), Size(0), Blocks(NULL), ChunkFrames(0) {}
+
+    bool                        Open(const char* Data, size_t Size);
+    uint32_t                    ChunkFrames_Get() const {return ChunkFrames;}
+    size_t                      Streams_Count() const;
+    bool                        Stream_Get(uint32_t Stream, int& Type, size_t& FrameCount) const; // From the start of Info, FrameCount is checked
+    bool                        FrameCount_IsValid(uint32_t Stream, uint64_t FrameCount) const; // There is a time stamps block of the right size for each range of frames
+    const StatsBinaryEntry*     Block_Find(uint32_t Kind, uint32_t Stream, uint32_t Item=0, uint32_t Chunk=0) const;
+    bool                        Block_Get(uint32_t Kind, uint32_t Stream, uint32_t Item, uint32_t Chunk, std::string& Raw) const;
+
+private:
+    const char*                 Data;
+    size_t                      Size;
+    const char*                 Blocks;
+    uint32_t                    ChunkFrames;
+    std::vector<StatsBinaryEntry> Entries;
+};
+
+#endif // StatsBinary_H
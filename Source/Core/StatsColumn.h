@@ -0,0 +1,443 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef StatsColumn_H
+#define StatsColumn_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Per frame values, stored in fixed size chunks.
+// Reserving more frames adds chunks, existing values are never moved so
+// readers can keep references while the column is filled up by the parser.
+// Old chunk directories are kept until destruction for the same reason.
+// Only one thread may reserve or write; the directory and the chunk count
+// are published with release stores so readers on other threads see either
+// the previous or the new state, never a directory without its chunks.
+template<typename T>
+class StatsColumn
+{
+public:
+    // Constructor / Destructor
+    StatsColumn() : Chunks(NULL), Chunks_Count(0), Chunks_Max(0), Chunk_Bits(Chunk_Bits_Default) {}
+    ~StatsColumn()
+    {
+        T** Chunks_Current=Chunks.load();
+        size_t Chunks_Count_Current=Chunks_Count.load();
+        for (size_t Pos=0; Pos<Chunks_Count_Current; Pos++)
+            delete[] Chunks_Current[Pos];
+        delete[] Chunks_Current;
+        for (size_t Pos=0; Pos<Chunks_Retired.size(); Pos++)
+            delete[] Chunks_Retired[Pos];
+    }
+
+    // Configuration
+    static const size_t         Chunk_Bits_Default=16; // 64K frames per chunk
+    void                        Chunk_Bits_Set(size_t Bits) {if (!Chunks_Count) Chunk_Bits=Bits;} // Must be called before the first reservation
+
+    // Memory management
+    size_t                      Reserved() const {return Chunks_Count.load(std::memory_order_acquire)<<Chunk_Bits;}
+    void                        Reserve(size_t Count)
+    {
+        size_t Chunks_Needed=(Count+(((size_t)1)<<Chunk_Bits)-1)>>Chunk_Bits;
+        size_t Chunks_Count_Current=Chunks_Count.load(std::memory_order_relaxed); // Only the writer modifies it
+        if (Chunks_Needed<=Chunks_Count_Current)
+            return;
+
+        T** Chunks_Current=Chunks.load(std::memory_order_relaxed);
+        if (Chunks_Needed>Chunks_Max)
+        {
+            size_t Chunks_Max_New=Chunks_Max?Chunks_Max:16;
+            while (Chunks_Max_New<Chunks_Needed)
+                Chunks_Max_New<<=1;
+
+            T** Chunks_New=new T*[Chunks_Max_New];
+            std::copy(Chunks_Current, Chunks_Current+Chunks_Count_Current, Chunks_New);
+            std::fill(Chunks_New+Chunks_Count_Current, Chunks_New+Chunks_Max_New, (T*)NULL);
+            if (Chunks_Current)
+                Chunks_Retired.push_back(Chunks_Current); // Readers may still use it
+            Chunks_Current=Chunks_New;
+            Chunks.store(Chunks_Current, std::memory_order_release);
+            Chunks_Max=Chunks_Max_New;
+        }
+
+        while (Chunks_Count_Current<Chunks_Needed)
+        {
+            Chunks_Current[Chunks_Count_Current]=new T[((size_t)1)<<Chunk_Bits](); // Zeroed
+            Chunks_Count_Current++;
+            Chunks_Count.store(Chunks_Count_Current, std::memory_order_release); // After the chunk pointer
+        }
+    }
+
+    // Data
+    T&                          operator[] (size_t Pos) // Writer only
+    {
+        size_t Chunk_Pos=Pos>>Chunk_Bits;
+        T* Chunk=Chunk_Get(Chunk_Pos);
+        if (!Chunk)
+        {
+            assert(!"StatsColumn: Reserve() must be called before writing");
+            Reserve(Pos+1); // The value is kept in release builds
+            Chunk=Chunk_Get(Chunk_Pos);
+        }
+        return Chunk[Pos&((((size_t)1)<<Chunk_Bits)-1)];
+    }
+    const T&                    operator[] (size_t Pos) const
+    {
+        static const T Empty=T(); // Not reserved yet, never written
+        const T* Chunk=Chunk_Get(Pos>>Chunk_Bits);
+        if (!Chunk)
+            return Empty;
+        return Chunk[Pos&((((size_t)1)<<Chunk_Bits)-1)];
+    }
+
+    // Copies Count values from the start of Source to Pos, by runs within chunks
+    void                        Copy(size_t Pos, const StatsColumn& Source, size_t Count)
+    {
+        Reserve(Pos+Count);
+
+        size_t Source_Pos=0;
+        while (Count)
+        {
+            size_t Run=(((size_t)1)<<Chunk_Bits)-(Pos&((((size_t)1)<<Chunk_Bits)-1));
+            size_t Source_Run=(((size_t)1)<<Source.Chunk_Bits)-(Source_Pos&((((size_t)1)<<Source.Chunk_Bits)-1));
+            if (Run>Source_Run)
+                Run=Source_Run;
+            if (Run>Count)
+                Run=Count;
+
+            const T* Source_Data=&Source[Source_Pos];
+            std::copy(Source_Data, Source_Data+Run, &(*this)[Pos]);
+
+            Pos+=Run;
+            Source_Pos+=Run;
+            Count-=Run;
+        }
+    }
+
+private:
+    StatsColumn(const StatsColumn&);
+    StatsColumn& operator=(const StatsColumn&);
+
+    // Chunk Chunk_Pos, NULL if not reserved yet. The count is loaded first:
+    // any directory loaded after it contains at least that many chunks.
+    T*                          Chunk_Get(size_t Chunk_Pos) const
+    {
+        if (Chunk_Pos>=Chunks_Count.load(std::memory_order_acquire))
+            return NULL;
+        return Chunks.load(std::memory_order_acquire)[Chunk_Pos];
+    }
+
+    std::atomic<T**>            Chunks;
+    std::atomic<size_t>         Chunks_Count;
+    size_t                      Chunks_Max;
+    size_t                      Chunk_Bits;
+    std::vector<T**>            Chunks_Retired;
+};
+
+//---------------------------------------------------------------------------
+// Flags, 1 bit per frame
+class StatsFlagColumn
+{
+public:
+    class Reference
+    {
+    public:
+        Reference(StatsFlagColumn& Column_, size_t Pos_) : Column(Column_), Pos(Pos_) {}
+        operator bool () const {return Column.Get(Pos);}
+        Reference& operator= (bool Value) {Column.Set(Pos, Value); return *this;}
+        Reference& operator= (const Reference& Value) {Column.Set(Pos, (bool)Value); return *this;}
+
+    private:
+        StatsFlagColumn&        Column;
+        size_t                  Pos;
+    };
+
+    // Configuration
+    void                        Chunk_Bits_Set(size_t Bits) {Words.Chunk_Bits_Set(Bits>6?(Bits-6):1);}
+
+    // Memory management
+    size_t                      Reserved() const {return Words.Reserved()<<6;}
+    void                        Reserve(size_t Count) {Words.Reserve((Count+63)>>6);}
+
+    // Data
+    bool                        Get(size_t Pos) const {return (Words[Pos>>6]>>(Pos&63))&1;}
+    void                        Set(size_t Pos, bool Value)
+    {
+        uint64_t& Word=Words[Pos>>6];
+        if (Value)
+            Word|=((uint64_t)1)<<(Pos&63);
+        else
+            Word&=~(((uint64_t)1)<<(Pos&63));
+    }
+    Reference                   operator[] (size_t Pos) {return Reference(*this, Pos);}
+    bool                        operator[] (size_t Pos) const {return Get(Pos);}
+
+    void                        Copy(size_t Pos, const StatsFlagColumn& Source, size_t Count)
+    {
+        Reserve(Pos+Count);
+        for (size_t Source_Pos=0; Source_Pos<Count; Source_Pos++)
+            Set(Pos+Source_Pos, Source.Get(Source_Pos));
+    }
+
+private:
+    StatsColumn<uint64_t>       Words;
+};
+
+//---------------------------------------------------------------------------
+// How a StatsValueColumn stores its values, widened to double on read
+enum statsencoding
+{
+    StatsEncoding_Double,                                   // Lossless
+    StatsEncoding_Float,
+    StatsEncoding_Delta,                                    // Float offset from the first value of each chunk, for time stamps
+    StatsEncoding_UInt16,                                   // Rounded, e.g. sample values up to 16-bit
+    StatsEncoding_Int32,                                    // Rounded, e.g. sizes and counts
+};
+
+//---------------------------------------------------------------------------
+// Per frame values with a compact storage type
+class StatsValueColumn
+{
+public:
+    class Reference
+    {
+    public:
+        Reference(StatsValueColumn& Column_, size_t Pos_) : Column(Column_), Pos(Pos_) {}
+        operator double () const {return Column.Get(Pos);}
+        Reference& operator= (double Value) {Column.Set(Pos, Value); return *this;}
+        Reference& operator= (const Reference& Value) {Column.Set(Pos, (double)Value); return *this;}
+        Reference& operator+= (double Value) {Column.Set(Pos, Column.Get(Pos)+Value); return *this;}
+        Reference& operator-= (double Value) {Column.Set(Pos, Column.Get(Pos)-Value); return *this;}
+
+    private:
+        StatsValueColumn&       Column;
+        size_t                  Pos;
+    };
+
+    // Constructor / Destructor
+    StatsValueColumn() : Encoding(StatsEncoding_Double), Chunk_Bits(StatsColumn<double>::Chunk_Bits_Default)
+    {
+        // 1 anchor per chunk of values
+        Anchors.Chunk_Bits_Set(8);
+        Anchors_Set.Chunk_Bits_Set(8);
+    }
+
+    // Configuration, must be called before the first reservation
+    void                        Encoding_Set(statsencoding Encoding_) {Encoding=Encoding_;}
+    statsencoding               Encoding_Get() const {return Encoding;}
+    void                        Chunk_Bits_Set(size_t Bits)
+    {
+        Chunk_Bits=Bits;
+        Doubles.Chunk_Bits_Set(Bits);
+        Floats.Chunk_Bits_Set(Bits);
+        UInt16s.Chunk_Bits_Set(Bits);
+        Int32s.Chunk_Bits_Set(Bits);
+    }
+
+    // Memory management
+    size_t                      Reserved() const
+    {
+        switch (Encoding)
+        {
+            case StatsEncoding_Float    :
+            case StatsEncoding_Delta    : return Floats.Reserved();
+            case StatsEncoding_UInt16   : return UInt16s.Reserved();
+            case StatsEncoding_Int32    : return Int32s.Reserved();
+            default                     : return Doubles.Reserved();
+        }
+    }
+    void                        Reserve(size_t Count)
+    {
+        switch (Encoding)
+        {
+            case StatsEncoding_Delta    : Anchors.Reserve((Count>>Chunk_Bits)+1);
+                                          Anchors_Set.Reserve((Count>>Chunk_Bits)+1);
+                                          // Fall through
+            case StatsEncoding_Float    : Floats.Reserve(Count); break;
+            case StatsEncoding_UInt16   : UInt16s.Reserve(Count); break;
+            case StatsEncoding_Int32    : Int32s.Reserve(Count); break;
+            default                     : Doubles.Reserve(Count);
+        }
+    }
+
+    // Data
+    double                      Get(size_t Pos) const
+    {
+        switch (Encoding)
+        {
+            case StatsEncoding_Float    : return Floats[Pos];
+            case StatsEncoding_Delta    : return Anchors[Pos>>Chunk_Bits]+Floats[Pos];
+            case StatsEncoding_UInt16   : return UInt16s[Pos];
+            case StatsEncoding_Int32    : return Int32s[Pos];
+            default                     : return Doubles[Pos];
+        }
+    }
+    void                        Set(size_t Pos, double Value)
+    {
+        switch (Encoding)
+        {
+            case StatsEncoding_Float    : Floats[Pos]=(float)Value; break;
+            case StatsEncoding_Delta    : {
+                                          size_t Chunk_Pos=Pos>>Chunk_Bits;
+                                          if (!Anchors_Set[Chunk_Pos])
+                                          {
+                                              Anchors[Chunk_Pos]=Value;
+                                              Anchors_Set[Chunk_Pos]=true;
+                                          }
+                                          Floats[Pos]=(float)(Value-Anchors[Chunk_Pos]);
+                                          }
+                                          break;
+            case StatsEncoding_UInt16   : Value=std::floor(Value+0.5);
+                                          UInt16s[Pos]=Value<=0?0:(Value>=0xFFFF?0xFFFF:(uint16_t)Value);
+                                          break;
+            case StatsEncoding_Int32    : Value=std::floor(Value+0.5);
+                                          Int32s[Pos]=Value<=INT32_MIN?INT32_MIN:(Value>=INT32_MAX?INT32_MAX:(int32_t)Value);
+                                          break;
+            default                     : Doubles[Pos]=Value;
+        }
+    }
+    Reference                   operator[] (size_t Pos) {return Reference(*this, Pos);}
+    double                      operator[] (size_t Pos) const {return Get(Pos);}
+
+    // Copies Count values from the start of Source to Pos
+    void                        Copy(size_t Pos, const StatsValueColumn& Source, size_t Count)
+    {
+        if (Encoding==Source.Encoding)
+        {
+            switch (Encoding)
+            {
+                case StatsEncoding_Float    : Floats.Copy(Pos, Source.Floats, Count); return;
+                case StatsEncoding_UInt16   : UInt16s.Copy(Pos, Source.UInt16s, Count); return;
+                case StatsEncoding_Int32    : Int32s.Copy(Pos, Source.Int32s, Count); return;
+                case StatsEncoding_Double   : Doubles.Copy(Pos, Source.Doubles, Count); return;
+                default                     : ; // Anchors differ
+            }
+        }
+
+        Reserve(Pos+Count);
+        for (size_t Source_Pos=0; Source_Pos<Count; Source_Pos++)
+            Set(Pos+Source_Pos, Source.Get(Source_Pos));
+    }
+
+private:
+    StatsValueColumn(const StatsValueColumn&);
+    StatsValueColumn& operator=(const StatsValueColumn&);
+
+    statsencoding               Encoding;
+    size_t                      Chunk_Bits;
+    StatsColumn<double>         Doubles;
+    StatsColumn<float>          Floats;
+    StatsColumn<uint16_t>       UInt16s;
+    StatsColumn<int32_t>        Int32s;
+    StatsColumn<double>         Anchors;                    // Delta only, first value of each chunk
+    StatsFlagColumn             Anchors_Set;
+};
+
+//---------------------------------------------------------------------------
+// Time axis: only time stamps are stored, other units are derived on read.
+// Values are relative to Origin (the first time stamp of the stream), so
+// lowering Origin does not need to update the stored values.
+class StatsTimeAxis
+{
+public:
+    enum unit
+    {
+        Unit_Frames,
+        Unit_Seconds,
+        Unit_Minutes,
+        Unit_Hours,
+        Unit_Max
+    };
+
+    // One unit of the axis, x[Unit][Pos]
+    class Unit
+    {
+    public:
+        double                  operator[] (size_t Pos) const {return Axis->Get(Index, Pos);}
+
+    private:
+        friend class StatsTimeAxis;
+        const StatsTimeAxis*    Axis;
+        size_t                  Index;
+    };
+
+    // Constructor / Destructor
+    StatsTimeAxis(const double* Origin_) : Origin(Origin_)
+    {
+        for (size_t Pos=0; Pos<Unit_Max; Pos++)
+        {
+            Units[Pos].Axis=this;
+            Units[Pos].Index=Pos;
+        }
+    }
+
+    // Configuration, must be called before the first reservation
+    void                        Encoding_Set(statsencoding Encoding) {TimeStamps.Encoding_Set(Encoding);}
+    void                        Chunk_Bits_Set(size_t Bits)
+    {
+        TimeStamps.Chunk_Bits_Set(Bits);
+        TimeStamps_Set.Chunk_Bits_Set(Bits);
+    }
+
+    // Memory management
+    size_t                      Reserved() const {return TimeStamps.Reserved();}
+    void                        Reserve(size_t Count)
+    {
+        TimeStamps.Reserve(Count);
+        TimeStamps_Set.Reserve(Count);
+    }
+
+    // Data
+    void                        Set(size_t Pos, double TimeStamp) // In seconds, not relative to Origin
+    {
+        TimeStamps.Set(Pos, TimeStamp);
+        TimeStamps_Set.Set(Pos, true);
+    }
+    bool                        IsSet(size_t Pos) const {return TimeStamps_Set.Get(Pos);}
+    double                      TimeStamp(size_t Pos) const {return IsSet(Pos)?TimeStamps.Get(Pos):0;} // In seconds, not relative to Origin
+    double                      Get(size_t Unit, size_t Pos) const
+    {
+        if (Unit==Unit_Frames)
+            return (double)Pos;
+        if (!IsSet(Pos))
+            return 0;
+
+        double Seconds=TimeStamps.Get(Pos)-*Origin;
+        switch (Unit)
+        {
+            case Unit_Seconds   : return Seconds;
+            case Unit_Minutes   : return Seconds/60;
+            default             : return Seconds/3600;
+        }
+    }
+    const Unit&                 operator[] (size_t Unit) const {return Units[Unit];}
+
+    // Copies Count values from the start of Source to Pos
+    void                        Copy(size_t Pos, const StatsTimeAxis& Source, size_t Count)
+    {
+        TimeStamps.Copy(Pos, Source.TimeStamps, Count);
+        TimeStamps_Set.Copy(Pos, Source.TimeStamps_Set, Count);
+    }
+
+private:
+    StatsTimeAxis(const StatsTimeAxis&);
+    StatsTimeAxis& operator=(const StatsTimeAxis&);
+
+    const double*               Origin;
+    StatsValueColumn            TimeStamps;
+    StatsFlagColumn             TimeStamps_Set;
+    Unit                        Units[Unit_Max];
+};
+
+#endif // StatsColumn_H
@@ -0,0 +1,94 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Core/StatsXmlBuffer.h"
+
+#include <cmath>
+#include <cstdio>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const double   StatsXmlBuffer_Pow10[]={1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+static const uint64_t StatsXmlBuffer_Pow10_Int[]={1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL};
+static const int      StatsXmlBuffer_Precision_Max=9;
+static const double   StatsXmlBuffer_Scaled_Max=4503599627370496.0; // 2^52, integers and fractional parts are exact below
+
+//***************************************************************************
+// Numbers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static char* Digits_Put(char* End, uint64_t Value) // Written backwards, returns the first digit
+{
+    do
+    {
+        *--End='0'+(char)(Value%10);
+        Value/=10;
+    }
+    while (Value);
+    return End;
+}
+
+//---------------------------------------------------------------------------
+void StatsXmlBuffer::Put_Int(int64_t Value)
+{
+    char Temp[24];
+    char* End=Temp+sizeof(Temp);
+    char* Begin=Digits_Put(End, Value<0?(0-(uint64_t)Value):(uint64_t)Value);
+    if (Value<0)
+        *--Begin='-';
+    Data.append(Begin, End-Begin);
+}
+
+//---------------------------------------------------------------------------
+void StatsXmlBuffer::Put_Fixed(double Value, int Precision)
+{
+    // Fast path: the value is scaled to an integer count of the last digit,
+    // the result of printf (exact decimal value, rounded to nearest) is known
+    // if the fractional part is not too close to 0.5 for the error of the
+    // scaling (1/2 ulp). Other values (ties, huge values, NaN...) are sent
+    // to printf.
+    if (Precision>=0 && Precision<=StatsXmlBuffer_Precision_Max && std::isfinite(Value))
+    {
+        bool Negative=std::signbit(Value);
+        double Scaled=std::fabs(Value)*StatsXmlBuffer_Pow10[Precision];
+        if (Scaled<StatsXmlBuffer_Scaled_Max)
+        {
+            double Integer=std::floor(Scaled);
+            double Fraction=Scaled-Integer;
+            double Error=Scaled*(1.0/4503599627370496.0)+1e-300; // 2^-52, larger than 1/2 ulp
+            if (std::fabs(Fraction-0.5)>Error)
+            {
+                uint64_t Rounded=(uint64_t)Integer+(Fraction>0.5?1:0);
+
+                char Temp[48];
+                char* End=Temp+sizeof(Temp);
+                char* Begin=End;
+                if (Precision)
+                {
+                    uint64_t Decimals=Rounded%StatsXmlBuffer_Pow10_Int[Precision];
+                    for (int Pos=0; Pos<Precision; Pos++)
+                    {
+                        *--Begin='0'+(char)(Decimals%10);
+                        Decimals/=10;
+                    }
+                    *--Begin='.';
+                }
+                Begin=Digits_Put(Begin, Rounded/StatsXmlBuffer_Pow10_Int[Precision]);
+                if (Negative)
+                    *--Begin='-';
+                Data.append(Begin, End-Begin);
+                return;
+            }
+        }
+    }
+
+    char Temp[512]; // Large enough for DBL_MAX with the maximum precision
+    int Size=snprintf(Temp, sizeof(Temp), "%.*f", Precision, Value);
+    if (Size>0)
+        Data.append(Temp, (size_t)Size<sizeof(Temp)?(size_t)Size:sizeof(Temp)-1);
+}
@@ -0,0 +1,34 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef StatsXmlBuffer_H
+#define StatsXmlBuffer_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+
+//---------------------------------------------------------------------------
+// Output of the XML serialization of the stats. Numbers are formatted
+// directly in the buffer, without stream or temporary string, and the
+// memory is kept between blocks of frames when the content is cleared.
+class StatsXmlBuffer
+{
+public:
+    std::string                 Data;
+
+    void                        Clear() {Data.clear();} // Memory is kept
+    void                        Put(char Value) {Data+=Value;}
+    void                        Put(const char* Value) {if (Value) Data.append(Value);} // NULL is ignored
+    void                        Put(const char* Value, size_t Size) {Data.append(Value, Size);}
+    void                        Put(const std::string& Value) {Data.append(Value);}
+    void                        Put_Int(int64_t Value);
+    void                        Put_Fixed(double Value, int Precision); // Same output as printf("%.*f"), std::to_string(double) is Precision 6
+};
+
+#endif // StatsXmlBuffer_H
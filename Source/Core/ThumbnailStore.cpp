@@ -0,0 +1,259 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Core/ThumbnailStore.h"
+
+#include <QDir>
+#include <QTemporaryFile>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+#include <cstring>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+static const size_t Buffer_MaxSize=1024*1024;
+
+//***************************************************************************
+// Constructor / Destructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+ThumbnailStore::ThumbnailStore() :
+    File(NULL),
+    File_Size(0),
+    File_IsBroken(false),
+    Packet(NULL)
+{
+}
+
+//---------------------------------------------------------------------------
+ThumbnailStore::~ThumbnailStore()
+{
+    delete File; // The temporary file is removed
+    if (Packet)
+        av_packet_free(&Packet);
+}
+
+//***************************************************************************
+// Actions
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void ThumbnailStore::Add(const AVPacket* Source)
+{
+    QMutexLocker Locker(&Mutex);
+
+    if (Source && Source->data && Source->size>0)
+        Add_Internal(Write_Internal((const char*)Source->data, Source->size), Source->size, -1, Source->pts);
+    else
+        Add_Internal(0, 0, -1, AV_NOPTS_VALUE);
+}
+
+//---------------------------------------------------------------------------
+void ThumbnailStore::Add_Tile(const AVPacket* Source, const std::vector<int64_t>& Pts)
+{
+    QMutexLocker Locker(&Mutex);
+
+    if (!Source || !Source->data || Source->size<=0)
+    {
+        for (size_t Pos=0; Pos<Pts.size(); Pos++)
+            Add_Internal(0, 0, -1, AV_NOPTS_VALUE);
+        return;
+    }
+
+    qint64 Offset=Write_Internal((const char*)Source->data, Source->size);
+    for (size_t Pos=0; Pos<Pts.size(); Pos++)
+        Add_Internal(Offset, Source->size, (int)Pos, Pts[Pos]);
+}
+
+//---------------------------------------------------------------------------
+void ThumbnailStore::Append(ThumbnailStore& Segment)
+{
+    if (&Segment==this)
+        return;
+
+    QMutexLocker Locker(&Mutex);
+    QMutexLocker Segment_Locker(&Segment.Mutex);
+
+    std::vector<char> Data;
+    qint64 Offset=0;
+    for (size_t Pos=0; Pos<Segment.Entries.size(); Pos++)
+    {
+        const entry& Entry=Segment.Entries[Pos];
+        if (Entry.Size && Entry.Slot<=0) // Sprite sheets are copied once, with their first frame
+        {
+            Data.resize(Entry.Size);
+            Segment.Read_Internal(Entry, Data.data());
+            Offset=Write_Internal(Data.data(), Entry.Size);
+        }
+        Add_Internal(Entry.Size?Offset:0, Entry.Size, Entry.Slot, Entry.Pts);
+    }
+
+    Segment.Entries.clear();
+    Segment.Buffer.clear();
+    delete Segment.File;
+    Segment.File=NULL;
+    Segment.File_Size=0;
+}
+
+//***************************************************************************
+// Info
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+size_t ThumbnailStore::Size()
+{
+    QMutexLocker Locker(&Mutex);
+
+    return Entries.size();
+}
+
+//---------------------------------------------------------------------------
+QByteArray ThumbnailStore::Get(size_t FramePos, int* Slot, size_t* Count)
+{
+    QMutexLocker Locker(&Mutex);
+
+    if (FramePos>=Entries.size() || !Entries[FramePos].Size)
+        return QByteArray();
+
+    if (Slot)
+        *Slot=Entries[FramePos].Slot;
+    if (Count)
+        *Count=Count_Internal(FramePos);
+
+    QByteArray Data(Entries[FramePos].Size, Qt::Uninitialized);
+    Read_Internal(Entries[FramePos], Data.data());
+    return Data;
+}
+
+//---------------------------------------------------------------------------
+AVPacket* ThumbnailStore::Packet_Get(size_t FramePos, int* Slot)
+{
+    QMutexLocker Locker(&Mutex);
+
+    if (FramePos>=Entries.size())
+        return NULL;
+
+    if (Slot)
+        *Slot=Entries[FramePos].Slot;
+
+    if (!Packet)
+    {
+        Packet=av_packet_alloc();
+        if (!Packet)
+            return NULL;
+    }
+    av_packet_unref(Packet);
+
+    const entry& Entry=Entries[FramePos];
+    if (Entry.Size)
+    {
+        Packet_Data.resize(Entry.Size);
+        Read_Internal(Entry, Packet_Data.data());
+        Packet->data=(uint8_t*)Packet_Data.data();
+        Packet->size=Entry.Size;
+        Packet->pts=Entry.Pts;
+        Packet->dts=Entry.Pts;
+        Packet->flags|=AV_PKT_FLAG_KEY;
+    }
+    else
+    {
+        Packet->data=NULL;
+        Packet->size=0;
+    }
+
+    return Packet;
+}
+
+//***************************************************************************
+// Helpers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+qint64 ThumbnailStore::Write_Internal(const char* Data, int Size)
+{
+    qint64 Offset=File_Size+Buffer.size();
+
+    Buffer.insert(Buffer.end(), Data, Data+Size);
+    if (Buffer.size()>=Buffer_MaxSize)
+        Flush();
+
+    return Offset;
+}
+
+//---------------------------------------------------------------------------
+void ThumbnailStore::Add_Internal(qint64 Offset, int Size, int Slot, int64_t Pts)
+{
+    entry Entry;
+    Entry.Offset=Offset;
+    Entry.Size=Size;
+    Entry.Slot=Slot;
+    Entry.Pts=Pts;
+    Entries.push_back(Entry);
+}
+
+//---------------------------------------------------------------------------
+size_t ThumbnailStore::Count_Internal(size_t FramePos)
+{
+    const entry& Entry=Entries[FramePos];
+    if (Entry.Slot<0)
+        return 1;
+
+    size_t First=FramePos-Entry.Slot;
+    size_t Last=FramePos+1;
+    while (Last<Entries.size() && Entries[Last].Offset==Entry.Offset && Entries[Last].Slot==(int)(Last-First))
+        Last++;
+    return Last-First;
+}
+
+//---------------------------------------------------------------------------
+void ThumbnailStore::Read_Internal(const entry& Entry, char* Data)
+{
+    // Entries are never split between the file and the buffer
+    if (Entry.Offset>=File_Size)
+    {
+        std::memcpy(Data, Buffer.data()+(Entry.Offset-File_Size), Entry.Size);
+        return;
+    }
+
+    if (!File->seek(Entry.Offset) || File->read(Data, Entry.Size)!=Entry.Size)
+        std::memset(Data, 0, Entry.Size);
+}
+
+//---------------------------------------------------------------------------
+void ThumbnailStore::Flush()
+{
+    if (File_IsBroken || Buffer.empty())
+        return;
+
+    if (!File)
+    {
+        File=new QTemporaryFile(QDir(QDir::tempPath()).filePath("qctools-thumbnails-XXXXXX"));
+        if (!File->open())
+        {
+            delete File;
+            File=NULL;
+            File_IsBroken=true; // Thumbnails stay in memory
+            return;
+        }
+    }
+
+    if (!File->seek(File_Size) || File->write(Buffer.data(), Buffer.size())!=(qint64)Buffer.size())
+    {
+        // Disk full or similar, the bytes not written stay in memory
+        File->resize(File_Size);
+        File_IsBroken=true;
+        return;
+    }
+
+    File_Size+=Buffer.size();
+    Buffer.clear();
+}
@@ -0,0 +1,74 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef ThumbnailStore_H
+#define ThumbnailStore_H
+
+#include <QByteArray>
+#include <QMutex>
+
+#include <stdint.h>
+#include <vector>
+//---------------------------------------------------------------------------
+
+struct AVPacket;
+class QTemporaryFile;
+
+//---------------------------------------------------------------------------
+// JPEG thumbnails of a stream, one per frame. The bytes are appended to a
+// temporary file (through a write buffer) and only an index of offsets is
+// kept in memory, so long files do not need to drop thumbnails. If the
+// temporary file can not be written, the bytes stay in memory.
+// Thumbnails may be grouped in sprite sheets: the JPEG of a sheet is stored
+// once and each frame points to its cell (slot) in the sheet.
+// Thread safe: thumbnails are added by the analysis and read by the UI.
+//---------------------------------------------------------------------------
+
+class ThumbnailStore
+{
+public:
+    // Constructor / Destructor
+    ThumbnailStore();
+    ~ThumbnailStore();
+
+    // Actions
+    void                        Add(const AVPacket* Packet);        // NULL or empty packet if no thumbnail for this frame
+    void                        Add_Tile(const AVPacket* Packet, const std::vector<int64_t>& Pts); // Sprite sheet of Pts.size() frames
+    void                        Append(ThumbnailStore& Segment);    // Moves the thumbnails of a segment at the end
+
+    // Info
+    size_t                      Size();
+    QByteArray                  Get(size_t FramePos, int* Slot=NULL, size_t* Count=NULL); // Empty if no thumbnail for this frame, Slot is -1 if not in a sprite sheet
+    AVPacket*                   Packet_Get(size_t FramePos, int* Slot=NULL); // Valid until the next call
+
+private:
+    struct entry
+    {
+        qint64                  Offset;
+        int                     Size;
+        int                     Slot;
+        int64_t                 Pts;
+    };
+
+    // Helpers
+    qint64                      Write_Internal(const char* Data, int Size); // Returns the offset
+    void                        Add_Internal(qint64 Offset, int Size, int Slot, int64_t Pts);
+    size_t                      Count_Internal(size_t FramePos);  // Count of frames in the sprite sheet of this frame
+    void                        Read_Internal(const entry& Entry, char* Data);
+    void                        Flush();
+
+    std::vector<entry>          Entries;
+    QTemporaryFile*             File;
+    qint64                      File_Size;
+    bool                        File_IsBroken;
+    std::vector<char>           Buffer;                             // Bytes after File_Size, not yet written
+    AVPacket*                   Packet;
+    QByteArray                  Packet_Data;
+    QMutex                      Mutex;
+};
+
+#endif // ThumbnailStore_H
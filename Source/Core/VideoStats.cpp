@@ -7,6 +7,9 @@
 //---------------------------------------------------------------------------
 #include "Core/VideoStats.h"
 #include "Core/VideoCore.h"
+#include "Core/StatsBinary.h"
+#include "Core/StatsXmlBuffer.h"
+#include "Core/XmlPullParser.h"
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -17,17 +20,14 @@ extern "C"
 #define UINT64_C(c) (c ## ULL)
 #endif
 
+#include <libavcodec/avcodec.h>
 #include <libavutil/frame.h>
 #include <libavutil/pixdesc.h>
 }
 
-#include "tinyxml2.h"
-#include <sstream>
-#include <iomanip>
 #include <cstdlib>
 #include <cfloat>
 #include <QString>
-using namespace tinyxml2;
 //---------------------------------------------------------------------------
 
 //***************************************************************************
@@ -46,246 +46,123 @@ VideoStats::~VideoStats()
 {
 }
 
+//***************************************************************************
+// Segments
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+CommonStats* VideoStats::Segment_Create(size_t FrameCount, double Duration) const
+{
+    VideoStats* Segment=new VideoStats(FrameCount, Duration);
+    Segment->Frequency=Frequency;
+    Segment->streamIndex=streamIndex;
+    return Segment;
+}
+
+//***************************************************************************
+// Binary sidecar
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void VideoStats::StatsToBinary(StatsBinaryWriter& Writer, uint32_t Stream, size_t x_Begin, size_t x_End) const
+{
+    CommonStats::StatsToBinary(Writer, Stream, x_Begin, x_End);
+
+    StatsBinaryBuffer Dimensions;
+    Dimensions.Put<int32_t>(width);
+    Dimensions.Put<int32_t>(height);
+    Writer.Block_Add(StatsBinary_Dimensions, Stream, 0, 0, Dimensions.Data);
+}
+
+//---------------------------------------------------------------------------
+bool VideoStats::StatsFromBinary(const StatsBinaryReader& Reader, uint32_t Stream)
+{
+    if (!CommonStats::StatsFromBinary(Reader, Stream))
+        return false;
+
+    string Raw;
+    if (Reader.Block_Get(StatsBinary_Dimensions, Stream, 0, 0, Raw))
+    {
+        StatsBinaryCursor Dimensions(Raw);
+        width=Dimensions.Get<int32_t>();
+        height=Dimensions.Get<int32_t>();
+    }
+
+    return true;
+}
+
 //***************************************************************************
 // External data
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-void VideoStats::StatsFromExternalData (const char* Data, size_t Size)
+void VideoStats::StatsFromExternalData_Frame(const XmlPullParser& Frame)
 {
-    // VideoStats from external data
-    // XML input
-    XMLDocument Document;
-    if (Document.Parse(Data, Size))
-       return;
-
-    XMLElement* Root=Document.FirstChildElement("ffprobe:ffprobe");
-    if (Root)
+    CommonStats::StatsFromExternalData_Frame(Frame);
+
+    // Video only attributes
+    ExternalData_Width=0;
+    ExternalData_Height=0;
+    for (size_t Pos=0; Pos<Frame.Attributes_Count(); Pos++)
     {
-        XMLElement* Frames=Root->FirstChildElement("frames");
-        if (Frames)
+        const char* Name=Frame.Attribute_Name(Pos);
+        const char* Value=Frame.Attribute_Value(Pos);
+        if (!strcmp(Name, "pkt_duration_time"))
         {
-            XMLElement* Frame=Frames->FirstChildElement();
-            while (Frame)
-            {
-                bool statsMapInitialized = !statsValueInfoByKeys.empty();
-
-                if (!strcmp(Frame->Value(), "frame"))
-                {
-                    const char* media_type=Frame->Attribute("media_type");
-                    if (media_type && !strcmp(media_type, "video"))
-                    {
-                        const char* stream_index_value = Frame->Attribute("stream_index");
-                        if(stream_index_value)
-                            streamIndex = std::stoi(stream_index_value);
-
-                        if (x_Current>=Data_Reserved)
-                            Data_Reserve(x_Current);
-
-                        const char* Attribute;
-                            
-                        x[0][x_Current]=x_Current;
-
-                        Attribute=Frame->Attribute("pkt_duration_time");
-                        if (Attribute)
-                        {
-                            durations[x_Current]=std::atof(Attribute);
-                            y[Item_pkt_duration_time][x_Current] = durations[x_Current];
-
-                            {
-                                double& group1Max = y_Max[PerItem[Item_pkt_duration_time].Group1];
-                                double& group1Min = y_Min[PerItem[Item_pkt_duration_time].Group1];
-                                double& current = durations[x_Current];
-
-                                if(group1Max < current)
-                                    group1Max = current;
-                                if(group1Min > current)
-                                    group1Min = current;
-                            }
-                        }
-
-                        Attribute=Frame->Attribute("key_frame");
-                        if (Attribute)
-                            key_frames[x_Current]=std::atof(Attribute)?true:false;
-
-                        Attribute = Frame->Attribute("pkt_pos");
-                        if(Attribute)
-                            pkt_pos[x_Current] = std::atoll(Attribute);
-
-                        Attribute = Frame->Attribute("pkt_size");
-                        if (Attribute)
-                        {
-                            pkt_size[x_Current] = std::atoi(Attribute);
-                            y[Item_pkt_size][x_Current] = pkt_size[x_Current];
-
-                            {
-                                double& group1Max = y_Max[PerItem[Item_pkt_size].Group1];
-                                double& group1Min = y_Min[PerItem[Item_pkt_size].Group1];
-                                int& current = pkt_size[x_Current];
-
-                                if(group1Max < current)
-                                    group1Max = current;
-                                if(group1Min > current)
-                                    group1Min = current;
-                            }
-                        }
-
-                        Attribute = Frame->Attribute("pkt_pts");
-                        if (Attribute)
-                            pkt_pts[x_Current] = std::atoi(Attribute);
-
-                        Attribute = Frame->Attribute("pix_fmt");
-                        if (Attribute)
-                            pix_fmt[x_Current] = av_get_pix_fmt(Attribute);
-
-                        Attribute = Frame->Attribute("pict_type");
-                        if (Attribute)
-                            pict_type_char[x_Current] = *Attribute;
-
-                        Attribute=Frame->Attribute("pkt_pts_time");
-                        if (!Attribute || !strcmp(Attribute, "N/A"))
-                            Attribute=Frame->Attribute("pkt_dts_time");
-                        if (Attribute && strcmp(Attribute, "N/A"))
-                        {
-                            x[1][x_Current]=std::atof(Attribute);
-                            if (FirstTimeStamp==DBL_MAX)
-                                FirstTimeStamp=x[1][x_Current];
-                            if (x[1][x_Current]<FirstTimeStamp)
-                            {
-                                double Difference=FirstTimeStamp-x[1][x_Current];
-                                for (size_t Pos=0; Pos<x_Current; Pos++)
-                                {
-                                    x[1][Pos]-=Difference;
-                                    x[2][Pos]=x[1][Pos]/60;
-                                    x[3][Pos]=x[2][Pos]/60;
-                                }
-                            }
-                            x[1][x_Current]-=FirstTimeStamp;
-                            x[2][x_Current]=x[1][x_Current]/60;
-                            x[3][x_Current]=x[2][x_Current]/60;
-                        }
-
-                        int Width;
-                        Attribute=Frame->Attribute("width");
-                        if (Attribute)
-                            Width=std::atoi(Attribute);
-                        else
-                            Width=0;
-
-                        setWidth(Width);
-
-                        int Height;
-                        Attribute=Frame->Attribute("width");
-                        if (Attribute)
-                            Height=std::atoi(Attribute);
-                        else
-                            Height=0;
-
-                        setHeight(Height);
-
-                        XMLElement* Tag=Frame->FirstChildElement();
-                        while (Tag)
-                        {
-                            if (!strcmp(Tag->Value(), "tag"))
-                            {
-                                size_t j=Item_VideoMax;
-                                const char* key=Tag->Attribute("key");
-                                if (key)
-                                {
-                                    if(strcmp(key, "qctools.comment") == 0)
-                                    {
-                                        const char* value = Tag->Attribute("value");
-                                        if(value)
-                                        {
-                                            comments[x_Current] = strdup(QString::fromUtf8(value).toHtmlEscaped().toUtf8().data());
-                                        }
-                                    }
-                                    else
-                                    {
-                                        for (size_t Plot_Pos=0; Plot_Pos<Item_VideoMax; Plot_Pos++)
-                                            if (!strcmp(key, PerItem[Plot_Pos].FFmpeg_Name))
-                                            {
-                                                j=Plot_Pos;
-                                                break;
-                                            }
-                                    }
-                                }
-
-                                if (j!=Item_VideoMax)
-                                {
-                                    double value;
-                                    Attribute=Tag->Attribute("value");
-                                    if (Attribute)
-                                        value=std::atof(Attribute);
-                                    else
-                                        value=0;
-
-                                    // Special cases: crop: x2, y2
-                                    if (Width && !strcmp(key, "lavfi.cropdetect.x2"))
-                                        y[j][x_Current]=Width-value;
-                                    else if (Height && !strcmp(key, "lavfi.cropdetect.y2"))
-                                        y[j][x_Current]=Height-value;
-                                    else if (Width && !strcmp(key, "lavfi.cropdetect.w"))
-                                        y[j][x_Current]=Width-value;
-                                    else if (Height && !strcmp(key, "lavfi.cropdetect.h"))
-                                        y[j][x_Current]=Height-value;
-                                    else
-                                        y[j][x_Current]=value;
-
-                                    if (PerItem[j].Group1!=Group_VideoMax && y_Max[PerItem[j].Group1]<y[j][x_Current])
-                                        y_Max[PerItem[j].Group1]=y[j][x_Current];
-                                    if (PerItem[j].Group2!=Group_VideoMax && y_Max[PerItem[j].Group2]<y[j][x_Current])
-                                        y_Max[PerItem[j].Group2]=y[j][x_Current];
-                                    if (PerItem[j].Group1!=Group_VideoMax && y_Min[PerItem[j].Group1]>y[j][x_Current])
-                                        y_Min[PerItem[j].Group1]=y[j][x_Current];
-                                    if (PerItem[j].Group2!=Group_VideoMax && y_Min[PerItem[j].Group2]>y[j][x_Current])
-                                        y_Min[PerItem[j].Group2]=y[j][x_Current];
-
-                                    //VideoStats
-                                    Stats_Totals[j]+=y[j][x_Current];
-                                    if (PerItem[j].DefaultLimit!=DBL_MAX)
-                                    {
-                                        if (y[j][x_Current]>PerItem[j].DefaultLimit)
-                                            Stats_Counts[j]++;
-                                        if (PerItem[j].DefaultLimit2!=DBL_MAX && y[j][x_Current]>PerItem[j].DefaultLimit2)
-                                            Stats_Counts2[j]++;
-                                    }
-                                } else {
-                                    auto value = Tag->Attribute("value");
-                                    processAdditionalStats(key, value ? value : "", statsMapInitialized);
-                                }
-                            }
-
-                            Tag=Tag->NextSiblingElement();
-                        }
-
-                        if(!statsMapInitialized) {
-                            initializeAdditionalStats();
-                            statsMapInitialized=true;
-                        }
-
-                        if (x_Max[0]<=x[0][x_Current])
-                        {
-                            x_Max[0]=x[0][x_Current];
-                            x_Max[1]=x[1][x_Current];
-                            x_Max[2]=x[2][x_Current];
-                            x_Max[3]=x[3][x_Current];
-                        }
-
-                        x_Current++;
-                        if (x_Current_Max<=x_Current)
-                            x_Current_Max=x_Current;
-                    }
-                }
-
-                if(!statsMapInitialized) {
-                    initializeAdditionalStats();
-                }
-
-                Frame=Frame->NextSiblingElement();
-            }
+            y[Item_pkt_duration_time][x_Current] = durations[x_Current];
+
+            double& group1Max = y_Max[PerItem[Item_pkt_duration_time].Group1];
+            double& group1Min = y_Min[PerItem[Item_pkt_duration_time].Group1];
+            double current = durations[x_Current];
+
+            if(group1Max < current)
+                group1Max = current;
+            if(group1Min > current)
+                group1Min = current;
         }
+        else if (!strcmp(Name, "pkt_size"))
+        {
+            y[Item_pkt_size][x_Current] = pkt_size[x_Current];
+
+            double& group1Max = y_Max[PerItem[Item_pkt_size].Group1];
+            double& group1Min = y_Min[PerItem[Item_pkt_size].Group1];
+            int current = pkt_size[x_Current];
+
+            if(group1Max < current)
+                group1Max = current;
+            if(group1Min > current)
+                group1Min = current;
+        }
+        else if (!strcmp(Name, "pix_fmt"))
+            pix_fmt[x_Current] = av_get_pix_fmt(Value);
+        else if (!strcmp(Name, "pict_type"))
+            pict_type_char[x_Current] = *Value;
+        else if (!strcmp(Name, "width"))
+            ExternalData_Width = std::atoi(Value);
+        else if (!strcmp(Name, "height"))
+            ExternalData_Height = std::atoi(Value);
     }
+
+    setWidth(ExternalData_Width);
+    setHeight(ExternalData_Height);
+}
+
+//---------------------------------------------------------------------------
+void VideoStats::StatsFromExternalData_Tag(const char* Key, const char* Value)
+{
+    if (Key && !strcmp(Key, "qctools.comment"))
+    {
+        if (Value)
+            comments[x_Current] = strdup(QString::fromUtf8(Value).toHtmlEscaped().toUtf8().data());
+        return;
+    }
+    if (Key && !strcmp(Key, "qctools.gap"))
+    {
+        gaps[x_Current] = Value && std::atoi(Value);
+        return;
+    }
+
+    CommonStats::StatsFromExternalData_Tag(Key, Value);
 }
 
 //---------------------------------------------------------------------------
@@ -301,47 +178,23 @@ void VideoStats::StatsFromFrame (struct AVFrame* Frame, int Width, int Height)
         e=av_dict_get     (m, "", e, AV_DICT_IGNORE_SUFFIX);
         if (!e)
             break;
-        size_t j=0;
-        for (; j<Item_VideoMax; j++)
-        {
-            if (strcmp(e->key, PerItem[j].FFmpeg_Name)==0)
-                break;
-        }
-
-        if (j<Item_VideoMax)
+        const KeyEntry* Entry=Key_Find(e->key);
+        if (Entry && Entry->Item<Item_VideoMax)
         {
+            size_t j=Entry->Item;
             double value=std::atof(e->value);
 
-            // Special cases: crop: x2, y2
-            if (string(e->key)=="lavfi.cropdetect.x2")
-                y[j][x_Current]=Width-value;
-            else if (string(e->key)=="lavfi.cropdetect.y2")
-                y[j][x_Current]=Height-value;
-            else if (string(e->key)=="lavfi.cropdetect.w")
-                y[j][x_Current]=Width-value;
-            else if (string(e->key)=="lavfi.cropdetect.h")
-                y[j][x_Current]=Height-value;
-            else
-                y[j][x_Current]=value;
-
-            if (PerItem[j].Group1!=Group_VideoMax && y_Max[PerItem[j].Group1]<y[j][x_Current])
-                y_Max[PerItem[j].Group1]=y[j][x_Current];
-            if (PerItem[j].Group2!=Group_VideoMax && y_Max[PerItem[j].Group2]<y[j][x_Current])
-                y_Max[PerItem[j].Group2]=y[j][x_Current];
-            if (PerItem[j].Group1!=Group_VideoMax && y_Min[PerItem[j].Group1]>y[j][x_Current])
-                y_Min[PerItem[j].Group1]=y[j][x_Current];
-            if (PerItem[j].Group2!=Group_VideoMax && y_Min[PerItem[j].Group2]>y[j][x_Current])
-                y_Min[PerItem[j].Group2]=y[j][x_Current];
-
-            //Stats
-            Stats_Totals[j]+=y[j][x_Current];
-            if (PerItem[j].DefaultLimit!=DBL_MAX)
+            // Special cases: crop: x2, y2, w, h
+            switch (Item_Transforms[j])
             {
-                if (y[j][x_Current]>PerItem[j].DefaultLimit)
-                    Stats_Counts[j]++;
-                if (PerItem[j].DefaultLimit2!=DBL_MAX && y[j][x_Current]>PerItem[j].DefaultLimit2)
-                    Stats_Counts2[j]++;
+                case ItemTransform_WidthMinus   : value=Width-value; break;
+                case ItemTransform_HeightMinus  : value=Height-value; break;
+                default                         : ;
             }
+
+            Item_Set(j, value);
+        } else if (Entry && statsMapInitialized) {
+            additionalStats_Set(Entry->Info, e->value);
         } else {
 
             // not found among plot groups
@@ -389,6 +242,7 @@ void VideoStats::StatsFromFrame (struct AVFrame* Frame, int Width, int Height)
     }
     pix_fmt[x_Current] = Frame->format;
     pict_type_char[x_Current] = av_get_picture_type_char(Frame->pict_type);
+    Gap_Check();
 
     if (x_Max[0]<=x[0][x_Current])
     {
@@ -415,34 +269,73 @@ void VideoStats::TimeStampFromFrame (struct AVFrame* Frame, size_t FramePos)
             Data_Reserve(x_Current_Max);
     }
 
-    x[0][FramePos]=FramePos;
-
     int64_t ts=(Frame->pts == AV_NOPTS_VALUE) ? Frame->pkt_dts : Frame->pts; // Using DTS is PTS is not available
     if (ts==AV_NOPTS_VALUE && FramePos)
-        ts=(int64_t)((FirstTimeStamp+x[1][FramePos-1]+durations[FramePos-1])*Frequency); // If time stamp is not present, creating a fake one from last frame duration
+        ts=(int64_t)((x.TimeStamp(FramePos-1)+durations[FramePos-1])*Frequency); // If time stamp is not present, creating a fake one from last frame duration
     if (ts!=AV_NOPTS_VALUE)
     {
-        if (FirstTimeStamp==DBL_MAX)
-            FirstTimeStamp=ts/Frequency;
-        x[1][FramePos]=((double)ts)/Frequency;
-        if (x[1][FramePos]<FirstTimeStamp)
-        {
-            double Difference=FirstTimeStamp-x[1][x_Current];
-            for (size_t Pos=0; Pos<x_Current; Pos++)
-            {
-                x[1][Pos]-=Difference;
-                x[2][Pos]=x[1][Pos]/60;
-                x[3][Pos]=x[2][Pos]/60;
-            }
-        }
-        x[1][FramePos]-=FirstTimeStamp;
-        x[2][FramePos]=x[1][FramePos]/60;
-        x[3][FramePos]=x[2][FramePos]/60;
+        double TimeStamp=((double)ts)/Frequency;
+        if (TimeStamp<FirstTimeStamp)
+            FirstTimeStamp=TimeStamp; // Previous frames are relative to the new origin too
+        x.Set(FramePos, TimeStamp);
     }
     if (Frame->pkt_duration!=AV_NOPTS_VALUE)
         durations[FramePos]=((double)Frame->pkt_duration)/Frequency;
 }
 
+//---------------------------------------------------------------------------
+// Container values only: no filter metadata, picture type is known only for key frames
+void VideoStats::StatsFromPacket (struct AVPacket* Packet, int PixFmt)
+{
+    TimeStampFromPacket(Packet, x_Current);
+
+    y[Item_pkt_duration_time][x_Current] = durations[x_Current];
+
+    {
+        double& group1Max = y_Max[PerItem[Item_pkt_duration_time].Group1];
+        double& group1Min = y_Min[PerItem[Item_pkt_duration_time].Group1];
+        double& current = durations[x_Current];
+
+        if(group1Max < current)
+            group1Max = current;
+        if(group1Min > current)
+            group1Min = current;
+    }
+
+    bool IsKey=(Packet->flags&AV_PKT_FLAG_KEY)?true:false;
+    key_frames[x_Current]=IsKey;
+
+    pkt_pos[x_Current] = Packet->pos;
+    pkt_size[x_Current] = Packet->size;
+    pkt_pts[x_Current] = Packet->pts;
+
+    y[Item_pkt_size][x_Current] = pkt_size[x_Current];
+
+    {
+        double& group1Max = y_Max[PerItem[Item_pkt_size].Group1];
+        double& group1Min = y_Min[PerItem[Item_pkt_size].Group1];
+        int& current = pkt_size[x_Current];
+
+        if(group1Max < current)
+            group1Max = current;
+        if(group1Min > current)
+            group1Min = current;
+    }
+    pix_fmt[x_Current] = PixFmt;
+    pict_type_char[x_Current] = av_get_picture_type_char(IsKey?AV_PICTURE_TYPE_I:AV_PICTURE_TYPE_NONE);
+
+    if (x_Max[0]<=x[0][x_Current])
+    {
+        x_Max[0]=x[0][x_Current];
+        x_Max[1]=x[1][x_Current];
+        x_Max[2]=x[2][x_Current];
+        x_Max[3]=x[3][x_Current];
+    }
+    x_Current++;
+    if (x_Current_Max<=x_Current)
+        x_Current_Max=x_Current;
+}
+
 //---------------------------------------------------------------------------
 int VideoStats::getWidth() const
 {
@@ -465,33 +358,28 @@ void VideoStats::setHeight(int height)
 }
 
 //---------------------------------------------------------------------------
-string VideoStats::StatsToXML (const activefilters& filters)
+void VideoStats::StatsToXML (StatsXmlBuffer& Data, const activefilters& filters, size_t x_Begin, size_t x_End)
 {
-    stringstream Data;
+    if (x_End>x_Current)
+        x_End=x_Current;
 
     // Per frame (note: the XML header and footer are not created here)
-    stringstream widthStream; widthStream<<width; // Note: we use the same value for all frame, we should later use the right value per frame
-    stringstream heightStream; heightStream<<height; // Note: we use the same value for all frame, we should later use the right value per frame
-    for (size_t x_Pos=0; x_Pos<x_Current; ++x_Pos)
+    for (size_t x_Pos=x_Begin; x_Pos<x_End; ++x_Pos)
     {
-        stringstream pkt_pts_time; pkt_pts_time<<fixed<<setprecision(7)<<(x[1][x_Pos]+FirstTimeStamp);
-        stringstream pkt_duration_time; pkt_duration_time<<fixed<<setprecision(7)<<durations[x_Pos];
-        stringstream key_frame; key_frame<<key_frames[x_Pos]?'1':'0';
-        Data<<"        <frame media_type=\"video\"";
-        Data << " stream_index=\"" << streamIndex << "\"";
-
-        Data<<" key_frame=\"" << key_frame.str() << "\"";
-        Data << " pkt_pts=\"" << pkt_pts[x_Pos] << "\"";
-        Data<<" pkt_pts_time=\"" << pkt_pts_time.str() << "\"";
-        if (pkt_duration_time)
-            Data<<" pkt_duration_time=\"" << pkt_duration_time.str() << "\"";
-        Data << " pkt_pos=\"" << pkt_pos[x_Pos] << "\"";
-        Data << " pkt_size=\"" << pkt_size[x_Pos] << "\"";
-        Data<<" width=\"" << widthStream.str() << "\" height=\"" << heightStream.str() <<"\"";
-        Data << " pix_fmt=\"" << av_get_pix_fmt_name((AVPixelFormat) pix_fmt[x_Pos]) << "\"";
-        Data << " pict_type=\"" << pict_type_char[x_Pos] << "\"";
-
-        Data << ">\n";
+        Data.Put("        <frame media_type=\"video\"");
+        Data.Put(" stream_index=\""); Data.Put_Int(streamIndex); Data.Put('"');
+
+        Data.Put(" key_frame=\""); Data.Put(key_frames[x_Pos]?'1':'0'); Data.Put('"');
+        Data.Put(" pkt_pts=\""); Data.Put_Int(pkt_pts[x_Pos]); Data.Put('"');
+        Data.Put(" pkt_pts_time=\""); Data.Put_Fixed(x[1][x_Pos]+FirstTimeStamp, 7); Data.Put('"');
+        Data.Put(" pkt_duration_time=\""); Data.Put_Fixed(durations[x_Pos], 7); Data.Put('"');
+        Data.Put(" pkt_pos=\""); Data.Put_Int(pkt_pos[x_Pos]); Data.Put('"');
+        Data.Put(" pkt_size=\""); Data.Put_Int(pkt_size[x_Pos]); Data.Put('"');
+        Data.Put(" width=\""); Data.Put_Int(width); Data.Put("\" height=\""); Data.Put_Int(height); Data.Put('"'); // Note: we use the same value for all frame, we should later use the right value per frame
+        Data.Put(" pix_fmt=\""); Data.Put(av_get_pix_fmt_name((AVPixelFormat) pix_fmt[x_Pos])); Data.Put('"');
+        Data.Put(" pict_type=\""); Data.Put(pict_type_char[x_Pos]); Data.Put('"');
+
+        Data.Put(">\n");
 
         for (size_t Plot_Pos=0; Plot_Pos<Item_VideoMax; Plot_Pos++)
         {
@@ -502,35 +390,43 @@ string VideoStats::StatsToXML (const activefilters& filters)
             if(!filters.test(filter))
                 continue;
 
-            const std::string& key = PerItem[Plot_Pos].FFmpeg_Name;
-            std::string value;
-
+            double value;
             switch (Plot_Pos)
             {
             case Item_Crop_x2 :
             case Item_Crop_w :
                 // Special case, values are from width
-                value = std::to_string(width-y[Plot_Pos][x_Pos]);
+                value = width-y[Plot_Pos][x_Pos];
                 break;
             case Item_Crop_y2 :
             case Item_Crop_h :
                 // Special case, values are from height
-                value = std::to_string(height-y[Plot_Pos][x_Pos]);
+                value = height-y[Plot_Pos][x_Pos];
                 break;
             default:
-                value = std::to_string(y[Plot_Pos][x_Pos]);
+                value = y[Plot_Pos][x_Pos];
             }
 
-            Data<<"            <tag key=\""+key+"\" value=\""+value+"\"/>\n";
+            Data.Put("            <tag key=\"");
+            Data.Put(PerItem[Plot_Pos].FFmpeg_Name);
+            Data.Put("\" value=\"");
+            Data.Put_Fixed(value, 6);
+            Data.Put("\"/>\n");
         }
 
         writeAdditionalStats(Data, x_Pos);
 
+        // Sampled analysis, frames before this one are not analyzed
+        if(gaps[x_Pos])
+            Data.Put("            <tag key=\"qctools.gap\" value=\"1\"/>\n");
+
         if(comments[x_Pos])
-            Data<<"            <tag key=\"qctools.comment\" value=\"" << comments[x_Pos] << "\"/>\n";
+        {
+            Data.Put("            <tag key=\"qctools.comment\" value=\"");
+            Data.Put(comments[x_Pos]);
+            Data.Put("\"/>\n");
+        }
 
-        Data<<"        </frame>\n";
+        Data.Put("        </frame>\n");
     }
-
-    return Data.str();
 }
@@ -28,10 +28,18 @@ public:
     ~VideoStats();
 
     // External data
-    void                        StatsFromExternalData(const char* Data, size_t Size);
+    void                        StatsFromExternalData_Frame(const XmlPullParser& Frame);
+    void                        StatsFromExternalData_Tag(const char* Key, const char* Value);
     void                        StatsFromFrame(struct AVFrame* Frame, int Width, int Height);
     void                        TimeStampFromFrame(struct AVFrame* Frame, size_t FramePos);
-    string                      StatsToXML(const activefilters& filters);
+    void                        StatsFromPacket(struct AVPacket* Packet, int PixFmt);
+    void                        StatsToXML(StatsXmlBuffer& Data, const activefilters& filters, size_t x_Begin=0, size_t x_End=(size_t)-1);
+
+    // Segments
+    CommonStats*                Segment_Create(size_t FrameCount, double Duration) const;
+
+    void                        StatsToBinary(StatsBinaryWriter& Writer, uint32_t Stream, size_t x_Begin=0, size_t x_End=(size_t)-1) const;
+    bool                        StatsFromBinary(const StatsBinaryReader& Reader, uint32_t Stream);
 
     int getWidth() const;
     void setWidth(int getWidth);
@@ -0,0 +1,327 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#include "Core/XmlPullParser.h"
+
+#include <cstdlib>
+#include <cstring>
+//---------------------------------------------------------------------------
+
+//***************************************************************************
+// Helpers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static bool IsSpace(char Value)
+{
+    return Value==' ' || Value=='\t' || Value=='\n' || Value=='\r';
+}
+
+//---------------------------------------------------------------------------
+static const char* Find(const char* Begin, size_t Size, const char* ToFind)
+{
+    size_t ToFind_Size=strlen(ToFind);
+    while (Size>=ToFind_Size)
+    {
+        const char* Candidate=(const char*)memchr(Begin, ToFind[0], Size-ToFind_Size+1);
+        if (!Candidate)
+            return NULL;
+        if (!memcmp(Candidate, ToFind, ToFind_Size))
+            return Candidate;
+        Size-=Candidate+1-Begin;
+        Begin=Candidate+1;
+    }
+    return NULL;
+}
+
+//---------------------------------------------------------------------------
+static void Utf8_Append(std::string& Output, unsigned long Value)
+{
+    if (Value<0x80)
+        Output+=(char)Value;
+    else if (Value<0x800)
+    {
+        Output+=(char)(0xC0|(Value>>6));
+        Output+=(char)(0x80|(Value&0x3F));
+    }
+    else if (Value<0x10000)
+    {
+        Output+=(char)(0xE0|(Value>>12));
+        Output+=(char)(0x80|((Value>>6)&0x3F));
+        Output+=(char)(0x80|(Value&0x3F));
+    }
+    else
+    {
+        Output+=(char)(0xF0|((Value>>18)&0x07));
+        Output+=(char)(0x80|((Value>>12)&0x3F));
+        Output+=(char)(0x80|((Value>>6)&0x3F));
+        Output+=(char)(0x80|(Value&0x3F));
+    }
+}
+
+//---------------------------------------------------------------------------
+static void Entities_Decode(std::string& Output, const char* Begin, const char* End)
+{
+    while (Begin<End)
+    {
+        const char* Amp=(const char*)memchr(Begin, '&', End-Begin);
+        if (!Amp)
+        {
+            Output.append(Begin, End-Begin);
+            return;
+        }
+        Output.append(Begin, Amp-Begin);
+
+        const char* Semicolon=(const char*)memchr(Amp, ';', End-Amp);
+        if (!Semicolon)
+        {
+            Output.append(Amp, End-Amp); // Not an entity, kept as is
+            return;
+        }
+
+        std::string Entity(Amp+1, Semicolon-Amp-1);
+        if (Entity=="lt")
+            Output+='<';
+        else if (Entity=="gt")
+            Output+='>';
+        else if (Entity=="amp")
+            Output+='&';
+        else if (Entity=="quot")
+            Output+='"';
+        else if (Entity=="apos")
+            Output+='\'';
+        else if (Entity.size()>1 && Entity[0]=='#')
+        {
+            if (Entity[1]=='x' || Entity[1]=='X')
+                Utf8_Append(Output, strtoul(Entity.c_str()+2, NULL, 16));
+            else
+                Utf8_Append(Output, strtoul(Entity.c_str()+1, NULL, 10));
+        }
+        else
+            Output.append(Amp, Semicolon+1-Amp); // Unknown, kept as is
+        Begin=Semicolon+1;
+    }
+}
+
+//***************************************************************************
+// Input
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void XmlPullParser::Data_Add(const char* Data, size_t Size)
+{
+    // Only the incomplete token is kept
+    if (Pos)
+    {
+        Buffer.erase(0, Pos);
+        Pos=0;
+    }
+    Raw_Begin=0;
+    Raw_Size=0;
+
+    Buffer.append(Data, Size);
+}
+
+//***************************************************************************
+// Tokens
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+const char* XmlPullParser::Attribute(const char* Name) const
+{
+    for (size_t Index=0; Index<Attributes.size(); Index++)
+        if (!strcmp(Attribute_Name(Index), Name))
+            return Attribute_Value(Index);
+    return NULL;
+}
+
+//---------------------------------------------------------------------------
+void XmlPullParser::Raw_Set(size_t Size)
+{
+    Raw_Begin=Pos;
+    Raw_Size=Size;
+    Pos+=Size;
+}
+
+//---------------------------------------------------------------------------
+XmlPullParser::token XmlPullParser::Next()
+{
+    if (Pending_End)
+    {
+        Pending_End=false;
+        Raw_Begin=Pos;
+        Raw_Size=0;
+        Attributes.clear();
+        return Token_EndElement;
+    }
+
+    for (;;)
+    {
+        if (Pos>=Buffer.size() || IsError)
+            return Token_None;
+
+        const char* Begin=Buffer.data()+Pos;
+        size_t Size=Buffer.size()-Pos;
+
+        // Text
+        if (*Begin!='<')
+        {
+            const char* Lower=(const char*)memchr(Begin, '<', Size);
+            if (!Lower && !IsEnd)
+                return Token_None;
+            Raw_Set(Lower?(Lower-Begin):Size);
+            return Token_Text;
+        }
+
+        // Declarations, comments, CDATA
+        if (Size>1 && (Begin[1]=='?' || Begin[1]=='!'))
+        {
+            if (Size<9 && !IsEnd)
+                return Token_None;
+
+            const char* Terminator;
+            bool IsText=false;
+            if (Begin[1]=='?')
+                Terminator="?>";
+            else if (Size>=4 && !memcmp(Begin, "<!--", 4))
+                Terminator="-->";
+            else if (Size>=9 && !memcmp(Begin, "<![CDATA[", 9))
+            {
+                Terminator="]]>";
+                IsText=true;
+            }
+            else
+                Terminator=">";
+
+            const char* End=Find(Begin+2, Size-2, Terminator);
+            if (!End)
+            {
+                if (IsEnd)
+                    Pos=Buffer.size();
+                return Token_None;
+            }
+            size_t Token_Size=End+strlen(Terminator)-Begin;
+            if (IsText)
+            {
+                Raw_Set(Token_Size);
+                return Token_Text;
+            }
+            Pos+=Token_Size;
+            continue;
+        }
+
+        // Elements, the end is the first '>' not in a quoted value
+        char Quote=0;
+        size_t End=1;
+        for (; End<Size; End++)
+        {
+            char Value=Begin[End];
+            if (Quote)
+            {
+                if (Value==Quote)
+                    Quote=0;
+            }
+            else if (Value=='"' || Value=='\'')
+                Quote=Value;
+            else if (Value=='>')
+                break;
+        }
+        if (End>=Size)
+        {
+            if (IsEnd)
+                Pos=Buffer.size();
+            return Token_None;
+        }
+
+        if (Begin[1]=='/')
+            return Element_End(Begin, End+1);
+        return Element_Start(Begin, End+1);
+    }
+}
+
+//---------------------------------------------------------------------------
+XmlPullParser::token XmlPullParser::Element_Start(const char* Begin, size_t Size)
+{
+    const char* End=Begin+Size-1; // '>'
+    Pending_End=End[-1]=='/';
+    if (Pending_End)
+        End--;
+
+    // Name
+    const char* Current=Begin+1;
+    const char* Name_Begin=Current;
+    while (Current<End && !IsSpace(*Current))
+        Current++;
+    Name_.assign(Name_Begin, Current-Name_Begin);
+
+    // Attributes
+    Attributes.clear();
+    Attributes_Data.clear();
+    for (;;)
+    {
+        while (Current<End && IsSpace(*Current))
+            Current++;
+        if (Current>=End)
+            break;
+
+        const char* Attribute_Begin=Current;
+        while (Current<End && *Current!='=' && !IsSpace(*Current))
+            Current++;
+        const char* Attribute_End=Current;
+        while (Current<End && IsSpace(*Current))
+            Current++;
+        if (Current>=End || *Current!='=')
+        {
+            IsError=true;
+            break;
+        }
+        Current++;
+        while (Current<End && IsSpace(*Current))
+            Current++;
+        if (Current>=End || (*Current!='"' && *Current!='\''))
+        {
+            IsError=true;
+            break;
+        }
+        char Quote=*Current++;
+        const char* Value_Begin=Current;
+        while (Current<End && *Current!=Quote)
+            Current++;
+        if (Current>=End)
+        {
+            IsError=true;
+            break;
+        }
+
+        std::pair<size_t, size_t> Offsets;
+        Offsets.first=Attributes_Data.size();
+        Attributes_Data.append(Attribute_Begin, Attribute_End-Attribute_Begin);
+        Attributes_Data+='\0';
+        Offsets.second=Attributes_Data.size();
+        Entities_Decode(Attributes_Data, Value_Begin, Current);
+        Attributes_Data+='\0';
+        Attributes.push_back(Offsets);
+        Current++;
+    }
+
+    Raw_Set(Size);
+    return Token_StartElement;
+}
+
+//---------------------------------------------------------------------------
+XmlPullParser::token XmlPullParser::Element_End(const char* Begin, size_t Size)
+{
+    const char* Name_Begin=Begin+2;
+    const char* Name_End=Begin+Size-1;
+    while (Name_End>Name_Begin && IsSpace(Name_End[-1]))
+        Name_End--;
+    Name_.assign(Name_Begin, Name_End-Name_Begin);
+    Attributes.clear();
+
+    Raw_Set(Size);
+    return Token_EndElement;
+}
@@ -0,0 +1,69 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifndef XmlPullParser_H
+#define XmlPullParser_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+//---------------------------------------------------------------------------
+// Streaming XML tokenizer: data is added block by block (e.g. while it is
+// decompressed) and tokens are pulled as soon as they are complete, so only
+// the last incomplete token is kept in memory. No tree is built.
+class XmlPullParser
+{
+public:
+    enum token
+    {
+        Token_None,                                         // More data is needed, or end of data
+        Token_StartElement,
+        Token_EndElement,                                   // Also sent after Token_StartElement for empty elements (<a/>)
+        Token_Text,                                         // Raw content between elements, entities are not decoded
+    };
+
+    // Constructor / Destructor
+    XmlPullParser() : Pos(0), IsEnd(false), IsError(false), Pending_End(false), Raw_Begin(0), Raw_Size(0) {}
+
+    // Input, pointers from the previous tokens are no more valid after a call
+    void                        Data_Add(const char* Data, size_t Size);
+    void                        Data_End() {IsEnd=true;}    // Incomplete content is then returned as text or dropped
+    bool                        Error_Get() const {return IsError;}
+
+    // Tokens
+    token                       Next();
+    const std::string&          Name() const {return Name_;}
+    bool                        Name_Is(const char* Value) const {return Name_==Value;}
+    size_t                      Attributes_Count() const {return Attributes.size();}
+    const char*                 Attribute_Name(size_t Index) const {return Attributes_Data.c_str()+Attributes[Index].first;}
+    const char*                 Attribute_Value(size_t Index) const {return Attributes_Data.c_str()+Attributes[Index].second;} // Entities are decoded
+    const char*                 Attribute(const char* Name) const; // NULL if not present
+    const char*                 Raw() const {return Buffer.data()+Raw_Begin;} // Token as in the input
+    size_t                      Raw_Size_Get() const {return Raw_Size;}
+
+private:
+    token                       Element_Start(const char* Begin, size_t Size);
+    token                       Element_End(const char* Begin, size_t Size);
+    void                        Raw_Set(size_t Size);
+
+    std::string                 Buffer;
+    size_t                      Pos;                        // Start of the data not yet parsed
+    bool                        IsEnd;
+    bool                        IsError;
+
+    // Current token
+    bool                        Pending_End;
+    size_t                      Raw_Begin;
+    size_t                      Raw_Size;
+    std::string                 Name_;
+    std::string                 Attributes_Data;            // Names and values, each one terminated by NUL
+    std::vector<std::pair<size_t, size_t> > Attributes;     // Offsets of names and values in Attributes_Data
+};
+
+#endif // XmlPullParser_H
@@ -20,6 +20,7 @@
 #include "GUI/Plots.h"
 #include "Core/FileInformation.h"
 #include "Core/FFmpeg_Glue.h"
+#include "Core/Preferences.h"
 
 #include <QDesktopWidget>
 #include <QGridLayout>
@@ -251,6 +252,7 @@ void BigDisplay::InitPicture()
 
         if (FileName_string.empty())
             Picture->InputData_Set(FileInfoData->Glue->InputData_Get()); // Using data from the analyzed file
+        Picture->DisplayCache_Set((size_t)Preferences().displayCacheSize()*1024*1024);
         Picture->AddOutput(0, width, height, FFmpeg_Glue::Output_QImage);
         Picture->AddOutput(1, width, height, FFmpeg_Glue::Output_QImage);
 
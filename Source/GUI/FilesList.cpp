@@ -15,6 +15,7 @@
 #include "Core/VideoCore.h"
 #include "Core/AudioCore.h"
 #include "Core/FFmpeg_Glue.h"
+#include "Core/Profiler.h"
 #include <QFileInfo>
 #include <QHeaderView>
 #include <QMenu>
@@ -376,6 +377,8 @@ void FilesList::Update()
         QTableWidgetItem* Item=item((int)Files_Pos, 0);
         if (!Item || Item->text()!="100%")
             Update(Files_Pos);
+        else
+            Profiler_Update(Files_Pos); // Export is also profiled
     }
 
     resizeColumnsToContents();
@@ -394,6 +397,7 @@ void FilesList::Update(size_t Files_Pos)
     stringstream Message;
     Message<<(int)(Stats->State_Get()*100)<<"%";
     setItem((int)Files_Pos, Col_Processed, new QTableWidgetItem(QString::fromStdString(Message.str())));
+    Profiler_Update(Files_Pos);
     
     // Stats
     for (size_t Col=0; Col<Col_Max; Col++)
@@ -424,6 +428,17 @@ void FilesList::Update(size_t Files_Pos)
         }
 }
 
+//---------------------------------------------------------------------------
+void FilesList::Profiler_Update(size_t Files_Pos)
+{
+    QTableWidgetItem* Item=item((int)Files_Pos, Col_Processed);
+    if (!Item)
+        return;
+
+    std::string Summary=Main->Files[Files_Pos]->Profiler_Get().Summary_Get();
+    Item->setToolTip(Summary.empty()?QString():"<pre>"+QString::fromStdString(Summary).toHtmlEscaped()+"</pre>");
+}
+
 //***************************************************************************
 // Events
 //***************************************************************************
@@ -33,6 +33,7 @@ protected:
 
     void showEvent(QShowEvent * Event);
     void contextMenuEvent   (QContextMenuEvent* Event);
+    void Profiler_Update(size_t Files_Pos); // Time spent per stage, in the tooltip of the progress
 
 private Q_SLOTS:
 
@@ -247,6 +247,22 @@ public:
     }
 
 protected:
+    void drawCurve(QPainter *p, int style, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect, int from, int to) const {
+
+        // Frames not analyzed (sampled analysis) are not interpolated, isolated frames are drawn as dots
+        const PlotSeriesData* plotSeriesData = static_cast<const PlotSeriesData*>(data());
+        int begin = from;
+        for ( int i = from + 1; i <= to; ++i )
+        {
+            if(plotSeriesData->isGap(i))
+            {
+                QwtPlotCurve::drawCurve(p, (begin == i - 1 && style == Lines) ? Dots : style, xMap, yMap, canvasRect, begin, i - 1);
+                begin = i;
+            }
+        }
+        QwtPlotCurve::drawCurve(p, (begin == to && begin != from && style == Lines) ? Dots : style, xMap, yMap, canvasRect, begin, to);
+    }
+
     void drawSymbols(QPainter *p, const QwtSymbol &s, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect, int from, int to) const {
 
         QwtPointMapper mapper;
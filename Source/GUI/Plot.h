@@ -129,21 +129,25 @@ public:
     }
     QPointF sample(size_t i) const {
 
-        auto xData = m_stats->x[m_xDataIndex];
-        auto yData = m_stats->y[m_yDataIndex];
+        const auto& xData = m_stats->x[m_xDataIndex];
+        const auto& yData = m_stats->y[m_yDataIndex];
 
         return QPointF(xData[i], (m_barchart ? toBarchart(yData, i, 1.0) : yData[i]));
     }
 
+    bool isGap(size_t i) const {
+        return m_stats->gaps.Get(i);
+    }
+
     QPointF originalSample(size_t i) const {
 
-        auto xData = m_stats->x[m_xDataIndex];
-        auto yData = m_stats->y[m_yDataIndex];
+        const auto& xData = m_stats->x[m_xDataIndex];
+        const auto& yData = m_stats->y[m_yDataIndex];
 
         return QPointF(xData[i], yData[i]);
     }
 
-    double toBarchart(double* yData, int index) const {
+    double toBarchart(const StatsValueColumn& yData, int index) const {
 
         auto y = yData[index];
         for(auto i = 0; i < m_conditions.m_items.size(); ++i) {
@@ -169,7 +173,7 @@ public:
         return 0.0;
     }
 
-    double toBarchart(double* yData, int index, double globalMax) const {
+    double toBarchart(const StatsValueColumn& yData, int index, double globalMax) const {
         auto value = toBarchart(yData, index);
 
         auto min = globalMax * (m_curveIndex) / m_curvesCount;
@@ -370,7 +370,7 @@ void Plots::setVisibleFrames( int from, int to , bool force)
         m_frameInterval.from = from;
         m_frameInterval.to = to;
 
-        const double* x = stats()->x[m_dataTypeIndex];
+        const StatsTimeAxis::Unit& x = stats()->x[m_dataTypeIndex];
         m_timeInterval.from = x[from];
         m_timeInterval.to = x[to];
 
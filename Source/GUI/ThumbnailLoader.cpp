@@ -0,0 +1,151 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+#include "GUI/ThumbnailLoader.h"
+#include "Core/FileInformation.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+//***************************************************************************
+// Job
+//***************************************************************************
+
+class ThumbnailLoader_Job : public QRunnable
+{
+public:
+    ThumbnailLoader_Job(ThumbnailLoader* loader_, int generation_, unsigned long framePos_)
+        : loader(loader_), generation(generation_), framePos(framePos_) {}
+
+    void run()
+    {
+        // Stale request, the display moved since
+        if (generation != loader->generation())
+            return;
+
+        thumbnailtile tile;
+        QByteArray bytes = loader->FileInfoData->PictureTile_Get(framePos, tile);
+        if (bytes.isEmpty())
+        {
+            post(framePos, QImage());
+            return;
+        }
+
+        // Frames of the sheet are posted by the job which decodes it
+        bool isTile = tile.Count > 1;
+        if (isTile && !loader->tileStart(tile.FirstFrame))
+            return;
+
+        QImage sheet;
+        bool isDecoded = sheet.loadFromData(bytes);
+        for (size_t i = 0; i < tile.Count; ++i)
+        {
+            int x = (int) (i % tile.Columns) * tile.Width;
+            int y = (int) (i / tile.Columns) * tile.Height;
+            post(tile.FirstFrame + i, isDecoded ? sheet.copy(x, y, qMin(72, tile.Width), qMin(72, tile.Height)) : QImage());
+        }
+        if (isTile)
+            loader->tileDone(tile.FirstFrame);
+    }
+
+    void post(qulonglong pos, const QImage& image)
+    {
+        QMetaObject::invokeMethod(loader, "jobDone", Qt::QueuedConnection, Q_ARG(int, generation), Q_ARG(qulonglong, pos), Q_ARG(QImage, image));
+    }
+
+private:
+    ThumbnailLoader*            loader;
+    int                         generation;
+    unsigned long               framePos;
+};
+
+//***************************************************************************
+// Constructor / Destructor
+//***************************************************************************
+
+ThumbnailLoader::ThumbnailLoader(FileInformation* FileInfoData_, QObject *parent)
+    : QObject(parent),
+      FileInfoData(FileInfoData_),
+      currentGeneration(0)
+{
+    Pool = new QThreadPool(this);
+    Pool->setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4));
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+    // Jobs use FileInfoData and this object
+    Pool->clear();
+    Pool->waitForDone();
+}
+
+//***************************************************************************
+// Commands
+//***************************************************************************
+
+void ThumbnailLoader::request(unsigned long framePos)
+{
+    if (pending.contains(framePos))
+        return;
+
+    pending.insert(framePos);
+    Pool->start(new ThumbnailLoader_Job(this, generation(), framePos));
+}
+
+void ThumbnailLoader::nextGeneration()
+{
+    currentGeneration.fetchAndAddOrdered(1);
+    Pool->clear();
+    pending.clear();
+
+    QMutexLocker locker(&tilesMutex);
+    tilesStarted.clear();
+}
+
+bool ThumbnailLoader::tileStart(qulonglong firstFrame)
+{
+    QMutexLocker locker(&tilesMutex);
+
+    if (tilesStarted.contains(firstFrame))
+        return false;
+
+    tilesStarted.insert(firstFrame);
+    return true;
+}
+
+void ThumbnailLoader::tileDone(qulonglong firstFrame)
+{
+    QMutexLocker locker(&tilesMutex);
+    tilesStarted.remove(firstFrame);
+}
+
+//***************************************************************************
+// Info
+//***************************************************************************
+
+int ThumbnailLoader::generation() const
+{
+    return currentGeneration.load();
+}
+
+//***************************************************************************
+// Events
+//***************************************************************************
+
+void ThumbnailLoader::jobDone(int generation, qulonglong framePos, QImage image)
+{
+    if (generation != this->generation())
+    {
+        // Decoded anyway, still useful for the cache
+        if (!image.isNull())
+            Q_EMIT thumbnailReady(framePos, image);
+        return;
+    }
+
+    pending.remove(framePos);
+    Q_EMIT thumbnailReady(framePos, image);
+}
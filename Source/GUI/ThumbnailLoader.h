@@ -0,0 +1,59 @@
+/*  Copyright (c) BAVC. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+#ifndef GUI_ThumbnailLoader_H
+#define GUI_ThumbnailLoader_H
+
+#include <QObject>
+#include <QImage>
+#include <QSet>
+#include <QAtomicInt>
+#include <QMutex>
+
+class FileInformation;
+class QThreadPool;
+
+// Reads and decodes thumbnails on a thread pool, so the UI thread never waits
+// for the analysis (FFmpeg_Glue mutex) nor for the JPEG decoder.
+// Requests of an older generation which are not yet started are dropped.
+// A sprite sheet being decoded is not decoded again by another job, all its
+// thumbnails are posted back.
+class ThumbnailLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailLoader(FileInformation* FileInfoData, QObject *parent = 0);
+    ~ThumbnailLoader();
+
+    // Commands
+    void                        request(unsigned long framePos);
+    void                        nextGeneration();           // Drops the pending requests
+
+    // Info
+    int                         generation() const;
+
+Q_SIGNALS:
+    void                        thumbnailReady(qulonglong framePos, QImage image); // Null image if not available yet
+
+private Q_SLOTS:
+    void                        jobDone(int generation, qulonglong framePos, QImage image);
+
+private:
+    friend class ThumbnailLoader_Job;
+
+    bool                        tileStart(qulonglong firstFrame); // False if the sheet is being decoded by another job
+    void                        tileDone(qulonglong firstFrame);
+
+    FileInformation*            FileInfoData;
+    QThreadPool*                Pool;
+    QSet<qulonglong>            pending;
+    QAtomicInt                  currentGeneration;
+    QMutex                      tilesMutex;
+    QSet<qulonglong>            tilesStarted;               // Sheets being decoded, a sheet is decoded again if its thumbnails are evicted then requested
+};
+
+#endif
@@ -8,7 +8,9 @@
 #include "GUI/player.h"
 
 #include "GUI/BigDisplay.h"
+#include "GUI/ThumbnailLoader.h"
 #include "Core/FileInformation.h"
+#include "Core/FFmpeg_Glue.h"
 #include "Core/CommonStats.h"
 
 #include <QBoxLayout>
@@ -21,6 +23,8 @@
 
 TinyDisplay::TinyDisplay(QWidget *parent, FileInformation* FileInformationData_)
     : QWidget(parent),
+      thumbsCache(CACHED_THUMBS),
+      thumbsMissing_Size(0),
       lastWidth(0),
       FileInfoData(FileInformationData_)
 {
@@ -35,15 +39,21 @@ TinyDisplay::TinyDisplay(QWidget *parent, FileInformation* FileInformationData_)
     Layout->setContentsMargins(1, 0, 1, 0);
 
     scaledLogo = QPixmap(":/icon/logo.jpg").scaled(72, 72);
+    loadingPixmap = QPixmap(":/icon/logo.png").scaled(72, 72);
     thumbnails = QVector<QToolButton*>();
 
     setLayout(Layout);
 
     connect(this, SIGNAL(resized()), this, SLOT(thumbsLayoutResized()));
+
+    loader = new ThumbnailLoader(FileInfoData, this);
+    connect(loader, SIGNAL(thumbnailReady(qulonglong, QImage)), this, SLOT(on_thumbnailReady(qulonglong, QImage)));
 }
 
 TinyDisplay::~TinyDisplay()
 {
+    delete loader; // Waits for the running jobs
+
     while (!thumbnails.empty()) {
         QToolButton *t = thumbnails.takeLast();
         delete t;
@@ -121,19 +131,15 @@ void TinyDisplay::thumbsLayoutResized()
 // Actions
 //***************************************************************************
 
-QPixmap toPixmap(const QByteArray& bytes)
+QPixmap TinyDisplay::thumbnailPixmap(unsigned long framePos)
 {
-    QPixmap pixmap;
-
-    if (!bytes.isEmpty())
-        pixmap.loadFromData(bytes);
-    else
-    {
-        pixmap.load(":/icon/logo.png");
-        pixmap = pixmap.scaled(72, 72);
-    }
+    if (QPixmap* cached = thumbsCache.object(framePos))
+        return *cached;
 
-    return pixmap;
+    // Decoded in the background, see on_thumbnailReady()
+    if (!thumbsMissing.contains(framePos))
+        loader->request(framePos);
+    return loadingPixmap;
 }
 
 void TinyDisplay::Update(bool updateBigDisplay)
@@ -157,6 +163,15 @@ void TinyDisplay::Update(bool updateBigDisplay)
     unsigned long current = FileInfoData->ReferenceStat()->x_Current;
     unsigned long current_max = FileInfoData->ReferenceStat()->x_Current_Max;
 
+    // Thumbnails not available at the previous request may be available now
+    if (!thumbsMissing.isEmpty() && FileInfoData->Glue) {
+        size_t thumbnailsSize = FileInfoData->Glue->Thumbnails_Size(0);
+        if (thumbnailsSize != thumbsMissing_Size) {
+            thumbsMissing.clear();
+            thumbsMissing_Size = thumbnailsSize;
+        }
+    }
+
     // do we need to update thumbnails?
     if (needsUpdate || lastFramePos != currentFrame) {
         unsigned long framePos = currentFrame;
@@ -167,41 +182,37 @@ void TinyDisplay::Update(bool updateBigDisplay)
 
         unsigned long total_thumbs = thumbnails.size();
         unsigned int center = total_thumbs / 2;
+        bool forward = framePos >= lastFramePos;
+
+        // Requests for the previous position are no longer needed
+        if (framePos != lastFramePos) {
+            loader->nextGeneration();
+            thumbsMissing.clear();
+        }
 
-        if (needsUpdate || framePos > lastFramePos) {
-            // movie is moving forward
-            unsigned long diff = framePos - lastFramePos;
-            for (unsigned i = 0; i < total_thumbs; ++i) {
-                if (framePos + i >= center && framePos - center + i < current) {
-                    if (!needsUpdate && (diff < total_thumbs && i < total_thumbs - diff)) {
-                        thumbnails[i]->setIcon(thumbnails[i+diff]->icon());
-                    } else {
-                        QPixmap pixmap = toPixmap(FileInfoData->Picture_Get(framePos - center + i));
-                        thumbnails[i]->setIcon(pixmap.copy(0, 0, 72, 72));
-                    }
-                } else {
-                    thumbnails[i]->setIcon(emptyPixmap);
-                    needsUpdate = true;
-                }
+        for (unsigned i = 0; i < total_thumbs; ++i) {
+            if (framePos + i >= center && framePos - center + i < current) {
+                thumbnails[i]->setIcon(thumbnailPixmap(framePos - center + i));
+            } else {
+                thumbnails[i]->setIcon(emptyPixmap);
+                needsUpdate = true;
             }
+        }
 
-        } else {
-            // movie is moving backward
-            unsigned long diff = lastFramePos - framePos;
-            for (int i = total_thumbs - 1; i >= 0; --i) {
-                unsigned ui = (unsigned) i;
-                if (framePos + ui >= center && framePos - center + ui < current) {
-                    if (diff < total_thumbs && i - (int) diff >= 0) {
-                        thumbnails[ui]->setIcon(thumbnails[ui-diff]->icon());
-					} else {
-                        QPixmap pixmap = toPixmap(FileInfoData->Picture_Get(framePos - center + ui));
-                        thumbnails[ui]->setIcon(pixmap.copy(0, 0, 72, 72));
-					}
-                } else {
-                    thumbnails[ui]->setIcon(emptyPixmap);
-                    needsUpdate = true;
-                }
+        // Prefetch in the direction of the move, so scrubbing finds decoded thumbnails
+        for (unsigned long i = 1; total_thumbs && i <= (unsigned long) PREFETCH_THUMBS; ++i) {
+            unsigned long pos;
+            if (forward) {
+                pos = framePos + (total_thumbs - 1 - center) + i;
+                if (pos >= current)
+                    break;
+            } else {
+                if (framePos < center + i)
+                    break;
+                pos = framePos - center - i;
             }
+            if (!thumbsCache.contains(pos) && !thumbsMissing.contains(pos))
+                loader->request(pos);
         }
 
         lastFramePos = framePos;
@@ -222,6 +233,26 @@ void TinyDisplay::Filters_Show()
 // Events
 //***************************************************************************
 
+void TinyDisplay::on_thumbnailReady(qulonglong framePos, QImage image)
+{
+    if (image.isNull()) {
+        // Not yet available, requested again at an update after more thumbnails are available
+        if (thumbsMissing.isEmpty() && FileInfoData->Glue)
+            thumbsMissing_Size = FileInfoData->Glue->Thumbnails_Size(0);
+        thumbsMissing.insert(framePos);
+        needsUpdate = true;
+        return;
+    }
+
+    QPixmap pixmap = QPixmap::fromImage(image);
+    thumbsCache.insert(framePos, new QPixmap(pixmap));
+
+    // Slot of the frame, if still visible
+    unsigned long center = thumbnails.size() / 2;
+    if (framePos + center >= lastFramePos && framePos + center - lastFramePos < (unsigned long) thumbnails.size())
+        thumbnails[framePos + center - lastFramePos]->setIcon(pixmap);
+}
+
 void TinyDisplay::on_thumbnails_clicked(bool)
 {
     int total_thumbs = thumbnails.size();
@@ -9,11 +9,16 @@
 
 #include <QWidget>
 #include <QVector>
+#include <QCache>
+#include <QSet>
+#include <QPixmap>
+#include <QImage>
 #include <QResizeEvent>
 
 class FileInformation;
 class Control;
 class Player;
+class ThumbnailLoader;
 
 class QLabel;
 class QToolButton;
@@ -40,6 +45,18 @@ private:
     static const int            TOTAL_THUMBS = 9;
     static const int            THUMB_WIDTH = 84;
     static const int            THUMB_HEIGHT = 84;
+    static const int            CACHED_THUMBS = 512;
+    static const int            PREFETCH_THUMBS = 16;
+
+    // Decoded thumbnails, most recently used ones are kept
+    QCache<unsigned long, QPixmap> thumbsCache;
+    ThumbnailLoader*            loader;
+    QPixmap                     loadingPixmap;
+    QPixmap                     thumbnailPixmap(unsigned long framePos); // Loading pixmap if not yet decoded
+
+    // Thumbnails not available yet, requested again only when more thumbnails are available
+    QSet<unsigned long>         thumbsMissing;
+    size_t                      thumbsMissing_Size;
 
     QPixmap                     emptyPixmap;
     QPixmap                     scaledLogo;
@@ -65,6 +82,7 @@ Q_SIGNALS:
 private Q_SLOTS:
     void                        thumbsLayoutResized();
     void                        on_thumbnails_clicked(bool checked);
+    void                        on_thumbnailReady(qulonglong framePos, QImage image);
 };
 
 #endif
@@ -9,6 +9,9 @@
 #include "player.h"
 #include "ui_mainwindow.h"
 #include "Core/FFmpeg_Glue.h"
+#include "Core/AnalysisScheduler.h"
+#include "Core/Profiler.h"
+#include "Core/CommonStats.h"
 #include "GUI/Plots.h"
 #include "GUI/preferences.h"
 
@@ -94,7 +97,6 @@ QAction *MainWindow::uploadAllAction() const
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    Thumbnails_Modulo(1),
     ui(new Ui::MainWindow)
 {
     qRegisterMetaType<SharedFile>("SharedFile");
@@ -276,7 +278,7 @@ void MainWindow::on_Toolbar_visibilityChanged(bool visible)
 void MainWindow::on_actionImport_XmlGz_Prompt_triggered()
 {
     QString FileName=QFileDialog::getOpenFileName(this, "Import from .qctools.xml.gz / .qctools.mkv", "",
-                                                  "Statistic files (*.qctools.xml *.qctools.xml.gz *.xml.gz *.xml);;\
+                                                  "Statistic files (*.qctools.bin *.qctools.xml *.qctools.xml.gz *.xml.gz *.xml);;\
                                                    Statistic files with thumbnails (*.qctools.mkv)",
                                                    0, QFileDialog::DontUseNativeDialog);
     if (FileName.size()==0)
@@ -295,8 +297,7 @@ void MainWindow::on_actionExport_XmlGz_Prompt_triggered()
     if (FileName.size()==0)
         return;
 
-    Files[getFilesCurrentPos()]->Export_XmlGz(FileName, Prefs->ActiveFilters);
-    statusBar()->showMessage("Exported to "+FileName);
+    Files[getFilesCurrentPos()]->Export_XmlGz(FileName, Prefs->ActiveFilters); // Result is shown by exportDone() or exportFailed()
 }
 
 void MainWindow::on_actionExport_Mkv_Prompt_triggered()
@@ -308,8 +309,13 @@ void MainWindow::on_actionExport_Mkv_Prompt_triggered()
     if (FileName.size()==0)
         return;
 
+    // The report is generated first, the video is not created if it fails
+    bool Failed=false;
+    auto connection = connect(Files[getFilesCurrentPos()], &FileInformation::statsFileGenerationFailed, [&](const QString&) {Failed=true;});
     Files[getFilesCurrentPos()]->Export_QCTools_Mkv(FileName, Prefs->ActiveFilters);
-    statusBar()->showMessage("Exported to "+FileName);
+    disconnect(connection);
+    if (!Failed)
+        statusBar()->showMessage("Exported to "+FileName);
 }
 
 //---------------------------------------------------------------------------
@@ -320,22 +326,43 @@ void MainWindow::on_actionExport_XmlGz_Sidecar_triggered()
 
     QString FileName=Files[getFilesCurrentPos()]->fileName() + ".qctools.xml.gz";
 
-    Files[getFilesCurrentPos()]->Export_XmlGz(FileName, Prefs->ActiveFilters);
-    statusBar()->showMessage("Exported to "+FileName);
-
+    Files[getFilesCurrentPos()]->Export_XmlGz(FileName, Prefs->ActiveFilters); // Result is shown by exportDone() or exportFailed()
 }
 
 //---------------------------------------------------------------------------
 void MainWindow::on_actionExport_XmlGz_SidecarAll_triggered()
 {
+    size_t Failed=0;
     for (size_t Pos=0; Pos<Files.size(); ++Pos)
     {
         QString FileName=Files[Pos]->fileName() + ".qctools.xml.gz";
 
+        auto connection = connect(Files[Pos], &FileInformation::statsFileGenerationFailed, [&](const QString&) {Failed++;});
         Files[Pos]->Export_XmlGz(FileName, Prefs->ActiveFilters);
+        disconnect(connection);
     }
 
-    statusBar()->showMessage("All files exported to sidecar file");
+    if (Failed)
+        statusBar()->showMessage(QString("Export to sidecar file failed for %1 of %2 files").arg(Failed).arg(Files.size()));
+    else
+        statusBar()->showMessage("All files exported to sidecar file");
+}
+
+//---------------------------------------------------------------------------
+void MainWindow::on_actionExport_Bin_Sidecar_triggered()
+{
+    if (getFilesCurrentPos()>=Files.size() || !Files[getFilesCurrentPos()])
+        return;
+
+    FileInformation* File=Files[getFilesCurrentPos()];
+    QString FileName=File->fileName() + ".qctools.bin";
+
+    // In the file thread, the result is shown by statsFileGenerated() or statsFileGenerationFailed()
+    statusBar()->showMessage("Exporting to "+FileName+"...");
+    if (File->isRunning() || !File->Glue)
+        File->Export_Bin(FileName); // Thread is busy (e.g. thumbnails of a report) or not available
+    else
+        File->startExport(FileName);
 }
 
 //---------------------------------------------------------------------------
@@ -366,6 +393,8 @@ void MainWindow::on_actionFilesList_triggered()
         ui->actionExport_XmlGz_Prompt->setVisible(false);
     if (ui->actionExport_XmlGz_Sidecar)
         ui->actionExport_XmlGz_Sidecar->setVisible(false);
+    if (ui->actionExport_Bin_Sidecar)
+        ui->actionExport_Bin_Sidecar->setVisible(false);
     if (ui->actionExport_XmlGz_Custom)
         ui->actionExport_XmlGz_Custom->setVisible(false);
     if (ui->actionPrint)
@@ -404,6 +433,8 @@ void MainWindow::on_actionGraphsLayout_triggered()
         ui->actionExport_XmlGz_Prompt->setVisible(true);
     if (ui->actionExport_XmlGz_Sidecar)
         ui->actionExport_XmlGz_Sidecar->setVisible(true);
+    if (ui->actionExport_Bin_Sidecar)
+        ui->actionExport_Bin_Sidecar->setVisible(true);
     //if (ui->actionExport_XmlGz_Custom) // Not implemented action
     //    ui->actionExport_XmlGz_Custom->setVisible(true);
     if (ui->actionExport_XmlGz_Prompt)
@@ -672,6 +703,15 @@ void MainWindow::updateSignalServerSettings()
     ui->actionSignalServer_status->setVisible(Prefs->isSignalServerEnabled());
 }
 
+void MainWindow::updateParsingSettings()
+{
+    FileInformation::setDecoderThreading(preferences->decoderThreading(), preferences->decoderThreadCount());
+    FileInformation::setThumbnailsTiles(preferences->thumbnailsTiles());
+    CommonStats::Lossless_Set(preferences->losslessStats());
+    FileInformation::setCheckpointInterval(preferences->checkpointInterval());
+    Profiler::Enabled_Set(preferences->profiling());
+}
+
 template <typename T> QString convertEnumToQString(const char* typeName, int value)
 {
     const QMetaObject &mo = T::staticMetaObject;
@@ -781,6 +821,16 @@ void MainWindow::updateSignalServerUploadProgress(qint64 value, qint64 total)
     ui->actionSignalServer_status->setText(QString("Uploading: %1 / %2").arg(value).arg(total));
 }
 
+void MainWindow::exportDone(SharedFile, const QString& name)
+{
+    statusBar()->showMessage("Exported to "+name);
+}
+
+void MainWindow::exportFailed(const QString& name)
+{
+    statusBar()->showMessage("Export to "+name+" failed");
+}
+
 void MainWindow::updateExportActions()
 {
     if (getFilesCurrentPos() != (size_t)-1)
@@ -794,6 +844,7 @@ void MainWindow::updateExportActions()
         ui->actionExport_XmlGz_Custom->setEnabled(exportEnabled);
         ui->actionExport_XmlGz_Prompt->setEnabled(exportEnabled);
         ui->actionExport_XmlGz_Sidecar->setEnabled(exportEnabled);
+        ui->actionExport_Bin_Sidecar->setEnabled(exportEnabled);
     }
 }
 
@@ -928,6 +979,9 @@ void MainWindow::setFilesCurrentPos(const size_t &value)
     if(files_CurrentPos != value) {
         files_CurrentPos = value;
 
+        // Selected file is parsed first
+        AnalysisScheduler::instance()->setPriorityFile(files_CurrentPos < Files.size() ? Files[files_CurrentPos] : NULL);
+
         Q_EMIT filePositionChanged(files_CurrentPos);
 
         if(fileWasSelected != isFileSelected())
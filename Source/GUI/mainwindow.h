@@ -108,7 +108,6 @@ public:
 
     // Files
     std::vector<FileInformation*> Files;
-    size_t                      Thumbnails_Modulo;
 
     // Deck
     bool                        DeckRunning;
@@ -177,6 +176,8 @@ private Q_SLOTS:
 
     void on_actionExport_XmlGz_SidecarAll_triggered();
 
+    void on_actionExport_Bin_Sidecar_triggered();
+
     void on_actionExport_XmlGz_Custom_triggered();
 
     void on_actionPrint_triggered();
@@ -218,11 +219,14 @@ private Q_SLOTS:
     void onSignalServerConnectionChanged(SignalServerConnectionChecker::State state);
     void updateConnectionIndicator();
     void updateSignalServerSettings();
+    void updateParsingSettings();
 
     void updateSignalServerCheckUploadedStatus();
     void updateSignalServerUploadStatus();
     void updateSignalServerUploadProgress(qint64, qint64);
 
+    void exportDone(SharedFile, const QString& name);
+    void exportFailed(const QString& name);
     void updateExportActions();
     void updateExportAllAction();
     void showPlayer();
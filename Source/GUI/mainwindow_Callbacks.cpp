@@ -48,17 +48,6 @@ void MainWindow::TimeOut ()
     refreshDisplay();
     Update();
 
-    // this code seems to launch more parsings tasks
-    // 2do: move it to proper place (introduce parsingDone signal, initiate more parsers in slot if required)
-
-    // Simultaneous parsing
-    for (size_t Files_Pos=0; Files_Pos<Files.size(); Files_Pos++)
-    {
-        CommonStats* Stats=Files[Files_Pos]->ReferenceStat();
-        if (Stats && Stats->State_Get()==0)
-            Files[Files_Pos]->startParse();
-    }
-
     bool DeckRunning_New=false;
 
     // Status
@@ -85,16 +74,6 @@ void MainWindow::TimeOut ()
             else
                 Message_Total<<"100%";
         }
-
-        //Thumbnails_Modulo
-        if (VideoFrameCount_Total / Thumbnails_Modulo > 512*1024) //Arbitrary value
-        {
-            for (size_t Files_Pos=0; Files_Pos<Files.size(); Files_Pos++)
-            {
-                Thumbnails_Modulo<<=1;
-                Files[Files_Pos]->Glue->Thumbnails_Modulo_Change(Thumbnails_Modulo);
-            }
-        }
     }
     for (size_t Files_Pos=0; Files_Pos<Files.size(); Files_Pos++)
     {
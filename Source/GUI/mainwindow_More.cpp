@@ -50,7 +50,7 @@ void MainWindow::openFile()
 
     QStringList List=QFileDialog::getOpenFileNames(this, "Open file", "", "All (*.*);;\
                                                                            Audio files (*.wav);;\
-                                                                           Statistic files (*.qctools.xml *.qctools.xml.gz *.xml.gz *.xml);;\
+                                                                           Statistic files (*.qctools.bin *.qctools.xml *.qctools.xml.gz *.xml.gz *.xml);;\
                                                                            Statistic files with thumbnails (*.qctools.mkv);;\
                                                                            Video files (*.avi *.mkv *.mov *.mxf *.mp4 *.ts *.m2ts)", 0, options);
     if (List.empty())
@@ -165,6 +165,8 @@ void MainWindow::processFile(const QString &FileName)
     // Launch analysis
     FileInformation* file = new FileInformation(signalServer, FileName, Prefs->ActiveFilters, Prefs->ActiveAllTracks);
     connect(file, SIGNAL(positionChanged()), this, SLOT(Update()), Qt::DirectConnection); // direct connection is required here to get Update called from separate thread
+    connect(file, SIGNAL(statsFileGenerated(SharedFile, QString)), this, SLOT(exportDone(SharedFile, QString)));
+    connect(file, SIGNAL(statsFileGenerationFailed(QString)), this, SLOT(exportFailed(QString)));
     file->setIndex(Files.size());
     file->setExportFilters(Prefs->ActiveFilters);
 
@@ -363,8 +363,10 @@ void MainWindow::Ui_Init()
     //Preferences
     Prefs=new PreferencesDialog(preferences, connectionChecker, this);
     connect(Prefs, SIGNAL(saved()), this, SLOT(updateSignalServerSettings()));
+    connect(Prefs, SIGNAL(saved()), this, SLOT(updateParsingSettings()));
 
     updateSignalServerSettings();
+    updateParsingSettings();
     updateConnectionIndicator();
 
     //Temp
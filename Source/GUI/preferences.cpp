@@ -107,6 +107,14 @@ void PreferencesDialog::Load()
     ui->Tracks_Audio_First->setChecked(!ActiveAllTracks[Type_Audio]);
     ui->Tracks_Audio_All->setChecked(ActiveAllTracks[Type_Audio]);
 
+    ui->DecoderThreading_comboBox->setCurrentIndex(preferences->decoderThreading());
+    ui->DecoderThreadCount_spinBox->setValue(preferences->decoderThreadCount());
+    ui->ThumbnailsTiles_checkBox->setChecked(preferences->thumbnailsTiles() > 1);
+    ui->DisplayCacheSize_spinBox->setValue(preferences->displayCacheSize());
+    ui->LosslessStats_checkBox->setChecked(preferences->losslessStats());
+    ui->CheckpointInterval_spinBox->setValue(preferences->checkpointInterval());
+    ui->Profiling_checkBox->setChecked(preferences->profiling());
+
     ui->signalServerUrl_lineEdit->setText(signalServerUrlString());
     ui->signalServerLogin_lineEdit->setText(signalServerLogin());
     ui->signalServerPassword_lineEdit->setText(signalServerPassword());
@@ -118,6 +126,13 @@ void PreferencesDialog::Save()
 {
     preferences->setActiveFilters(ActiveFilters);
     preferences->setActiveAllTracks(ActiveAllTracks);
+    preferences->setDecoderThreading((decoderthreading) ui->DecoderThreading_comboBox->currentIndex());
+    preferences->setDecoderThreadCount(ui->DecoderThreadCount_spinBox->value());
+    preferences->setThumbnailsTiles(ui->ThumbnailsTiles_checkBox->isChecked() ? 10 : 0);
+    preferences->setDisplayCacheSize(ui->DisplayCacheSize_spinBox->value());
+    preferences->setLosslessStats(ui->LosslessStats_checkBox->isChecked());
+    preferences->setCheckpointInterval(ui->CheckpointInterval_spinBox->value());
+    preferences->setProfiling(ui->Profiling_checkBox->isChecked());
     preferences->setSignalServerUrlString(ui->signalServerUrl_lineEdit->text());
     preferences->setSignalServerLogin(ui->signalServerLogin_lineEdit->text());
     preferences->setSignalServerPassword(ui->signalServerPassword_lineEdit->text());